@@ -0,0 +1,17 @@
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Implemented by each benchmark grammar. Runs the machine over the whole
+ * corpus and returns a check value that must not depend on the code style,
+ * or -1 if the machine failed. */
+long bench_run( char *data, long len );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,128 @@
+/*
+ *  Copyright 2009 Adrian Thurston <thurston@complang.org>
+ */
+
+/*  This file is part of Ragel.
+ *
+ *  Ragel is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Ragel is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Ragel; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Runs the bench_run of a grammar over a corpus held in memory and prints
+ * the best of a number of runs:
+ *
+ *   <MB/s> <cycles/byte> <check>
+ *
+ * The cycles are those of the time stamp counter and are printed as - where
+ * there is none.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "bench.h"
+
+#if defined(__GNUC__) && ( defined(__i386__) || defined(__x86_64__) )
+#define HAVE_CYCLES
+static unsigned long long cycles()
+{
+	unsigned int lo, hi;
+	__asm__ __volatile__ ( "rdtsc" : "=a" (lo), "=d" (hi) );
+	return ( (unsigned long long)hi << 32 ) | lo;
+}
+#endif
+
+static double now()
+{
+	struct timeval tv;
+	gettimeofday( &tv, 0 );
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+int main( int argc, char **argv )
+{
+	FILE *file;
+	char *data;
+	long len, check = 0;
+	int reps, r;
+	double best = 0;
+#ifdef HAVE_CYCLES
+	unsigned long long bestCycles = 0;
+#endif
+
+	if ( argc != 3 ) {
+		fprintf( stderr, "usage: benchdrv <corpus> <reps>\n" );
+		return 1;
+	}
+	reps = atoi( argv[2] );
+
+	file = fopen( argv[1], "rb" );
+	if ( file == 0 ) {
+		fprintf( stderr, "benchdrv: could not open %s\n", argv[1] );
+		return 1;
+	}
+	fseek( file, 0, SEEK_END );
+	len = ftell( file );
+	fseek( file, 0, SEEK_SET );
+	data = malloc( len + 1 );
+	if ( data == 0 || (long)fread( data, 1, len, file ) != len ) {
+		fprintf( stderr, "benchdrv: could not read %s\n", argv[1] );
+		return 1;
+	}
+	fclose( file );
+
+	for ( r = 0; r < reps; r++ ) {
+		long result;
+		double start = now(), elapsed;
+#ifdef HAVE_CYCLES
+		unsigned long long startCycles = cycles(), elapsedCycles;
+#endif
+
+		result = bench_run( data, len );
+
+#ifdef HAVE_CYCLES
+		elapsedCycles = cycles() - startCycles;
+#endif
+		elapsed = now() - start;
+
+		if ( result < 0 ) {
+			fprintf( stderr, "benchdrv: the machine failed\n" );
+			return 1;
+		}
+		if ( r > 0 && result != check ) {
+			fprintf( stderr, "benchdrv: the check changed between runs\n" );
+			return 1;
+		}
+		check = result;
+
+		if ( r == 0 || elapsed < best )
+			best = elapsed;
+#ifdef HAVE_CYCLES
+		if ( r == 0 || elapsedCycles < bestCycles )
+			bestCycles = elapsedCycles;
+#endif
+	}
+
+	if ( best <= 0 )
+		best = 1e-6;
+	printf( "%.1f ", len / best / ( 1024 * 1024 ) );
+#ifdef HAVE_CYCLES
+	printf( "%.2f ", (double)bestCycles / len );
+#else
+	printf( "- " );
+#endif
+	printf( "%ld\n", check );
+	return 0;
+}
@@ -0,0 +1,30 @@
+/*
+ * Benchmark of the mini C scanner in examples/clang.rl.
+ */
+
+#include "clang.h"
+
+%%{
+	machine clang_bench;
+	access fsm->;
+	variable ts fsm->tok_start;
+	variable te fsm->tok_end;
+	include clang "examples/clang.rl";
+}%%
+
+%% write data nofinal;
+
+long bench_run( char *data, long len )
+{
+	struct clang_bench bench, *fsm = &bench;
+	char *p = data, *pe = data + len, *eof = pe;
+
+	%% write init;
+	fsm->line = 1;
+	fsm->tokens = 0;
+	%% write exec;
+
+	if ( fsm->cs == clang_bench_error )
+		return -1;
+	return fsm->tokens + fsm->line;
+}
@@ -0,0 +1,18 @@
+#ifndef _CPPSCAN_H
+#define _CPPSCAN_H
+
+#include "bench.h"
+
+struct cppscan_bench
+{
+	int cs, act;
+	char *tok_start, *tok_end;
+	long check;
+};
+
+/* The actions of examples/cppscan.rl pass each token to token(). */
+#define ts fsm->tok_start
+#define te fsm->tok_end
+#define token(tok) (fsm->check += 1)
+
+#endif
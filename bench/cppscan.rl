@@ -0,0 +1,29 @@
+/*
+ * Benchmark of the C++ scanner in examples/cppscan.rl.
+ */
+
+#include "cppscan.h"
+
+%%{
+	machine cppscan_bench;
+	access fsm->;
+	variable ts fsm->tok_start;
+	variable te fsm->tok_end;
+	include Scanner "examples/cppscan.rl";
+}%%
+
+%% write data nofinal;
+
+long bench_run( char *data, long len )
+{
+	struct cppscan_bench bench, *fsm = &bench;
+	char *p = data, *pe = data + len, *eof = pe;
+
+	%% write init;
+	fsm->check = 0;
+	%% write exec;
+
+	if ( fsm->cs == cppscan_bench_error )
+		return -1;
+	return fsm->check;
+}
@@ -0,0 +1,12 @@
+#ifndef _DICT_H
+#define _DICT_H
+
+#include <string.h>
+#include "bench.h"
+
+struct dict_bench
+{
+	int cs;
+};
+
+#endif
@@ -0,0 +1,548 @@
+/*
+ *  Copyright 2009 Adrian Thurston <thurston@complang.org>
+ */
+
+/*  This file is part of Ragel.
+ *
+ *  Ragel is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Ragel is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Ragel; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Writes the corpora of the benchmark and the grammars that are too large to
+ * keep in the tree. The output depends only on the arguments, so results of
+ * different builds and hosts can be compared.
+ *
+ *   gencorpus <kind> <bytes> [literal-file]   write a corpus of a kind
+ *   gencorpus -g <grammar>                    write a synthetic grammar
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_KEYWORDS 250
+#define NUM_DICT 1000
+#define MAX_WORD 16
+
+/* Our own generator: rand() differs between C libraries. */
+static unsigned long seed = 1;
+
+static int rnd( int n )
+{
+	seed = ( seed * 1103515245UL + 12345UL ) & 0x7fffffffUL;
+	return (int)( ( seed >> 8 ) % n );
+}
+
+static long written = 0;
+
+static void put( const char *s )
+{
+	written += strlen( s );
+	fputs( s, stdout );
+}
+
+static void putch( int c )
+{
+	written += 1;
+	putchar( c );
+}
+
+static void word( char *dest, int minLen, int maxLen )
+{
+	int i, len = minLen + rnd( maxLen - minLen + 1 );
+	for ( i = 0; i < len; i++ )
+		dest[i] = 'a' + rnd( 26 );
+	dest[len] = 0;
+}
+
+/* Word lists shared by a synthetic grammar and its corpus. The list is drawn
+ * from its own seed so it does not depend on what was generated before. */
+static char (*wordList( int num, unsigned long listSeed ))[MAX_WORD]
+{
+	char (*words)[MAX_WORD] = malloc( num * MAX_WORD );
+	unsigned long saved = seed;
+	int i;
+
+	seed = listSeed;
+	for ( i = 0; i < num; i++ )
+		word( words[i], 3, 12 );
+	seed = saved;
+	return words;
+}
+
+#define KEYWORDS_SEED 17
+#define DICT_SEED 29
+
+/*
+ * Synthetic grammars.
+ */
+
+static void grammarHead( const char *name, const char *comment )
+{
+	printf(
+		"/*\n"
+		" * %s Written by gencorpus.\n"
+		" */\n"
+		"\n"
+		"#include \"%s.h\"\n"
+		"\n"
+		"%%%%{\n"
+		"\tmachine %s_bench;\n"
+		"\taccess fsm->;\n", comment, name, name );
+}
+
+static void keywordsGrammar()
+{
+	char (*words)[MAX_WORD] = wordList( NUM_KEYWORDS, KEYWORDS_SEED );
+	int i;
+
+	grammarHead( "keywords", "A scanner with a large set of keywords." );
+	printf(
+		"\tvariable ts fsm->tok_start;\n"
+		"\tvariable te fsm->tok_end;\n"
+		"\n"
+		"\tmain := |*\n" );
+	for ( i = 0; i < NUM_KEYWORDS; i++ )
+		printf( "\t\t'%s' { fsm->check += %d; };\n", words[i], i + 1 );
+	printf(
+		"\t\t[a-z_] [a-z0-9_]* { fsm->check += %d; };\n"
+		"\t\tdigit+ { fsm->check += %d; };\n"
+		"\t\tpunct { fsm->check += %d; };\n"
+		"\t\tspace+;\n"
+		"\t*|;\n"
+		"}%%%%\n"
+		"\n"
+		"%%%% write data nofinal;\n"
+		"\n"
+		"long bench_run( char *data, long len )\n"
+		"{\n"
+		"\tstruct keywords_bench bench, *fsm = &bench;\n"
+		"\tchar *p = data, *pe = data + len, *eof = pe;\n"
+		"\n"
+		"\t%%%% write init;\n"
+		"\tfsm->check = 0;\n"
+		"\t%%%% write exec;\n"
+		"\n"
+		"\tif ( fsm->cs == keywords_bench_error )\n"
+		"\t\treturn -1;\n"
+		"\treturn fsm->check;\n"
+		"}\n",
+		NUM_KEYWORDS + 1, NUM_KEYWORDS + 2, NUM_KEYWORDS + 3 );
+}
+
+static void dictGrammar()
+{
+	char (*words)[MAX_WORD] = wordList( NUM_DICT, DICT_SEED );
+	int i;
+
+	grammarHead( "dict", "Membership in a large dictionary of words." );
+	printf( "\n\tmain := (\n" );
+	for ( i = 0; i < NUM_DICT; i++ )
+		printf( "\t\t'%s'%s\n", words[i], i < NUM_DICT - 1 ? " |" : "" );
+	printf(
+		"\t) '\\n';\n"
+		"}%%%%\n"
+		"\n"
+		"%%%% write data;\n"
+		"\n"
+		"long bench_run( char *data, long len )\n"
+		"{\n"
+		"\tstruct dict_bench bench, *fsm = &bench;\n"
+		"\tchar *line = data, *end = data + len;\n"
+		"\tlong accepted = 0;\n"
+		"\n"
+		"\twhile ( line < end ) {\n"
+		"\t\tchar *nl = memchr( line, '\\n', end - line );\n"
+		"\t\tchar *p = line, *pe = nl != 0 ? nl + 1 : end;\n"
+		"\n"
+		"\t\t%%%% write init;\n"
+		"\t\t%%%% write exec;\n"
+		"\n"
+		"\t\tif ( fsm->cs >= dict_bench_first_final )\n"
+		"\t\t\taccepted += 1;\n"
+		"\t\tline = pe;\n"
+		"\t}\n"
+		"\treturn accepted;\n"
+		"}\n" );
+}
+
+/*
+ * Corpora.
+ */
+
+static const char *cWords[] = {
+	"int", "char", "return", "if", "else", "while", "for", "static", "struct",
+	"const", "void", "unsigned", "long", "switch", "case", "break", "sizeof",
+	"state", "trans", "count", "next", "data", "len", "buf", "p", "pe", "i", 0
+};
+
+static const char *cOps[] = {
+	"::", "==", "!=", "&&", "||", "*=", "/=", "%=", "+=", "-=", "&=", "^=",
+	"|=", "++", "--", "->", "->*", ".*", "...", "(", ")", "{", "}", "[", "]",
+	";", ",", "=", "<", ">", "+", "-", "*", "&", "!", "~", "?", ":", "#", 0
+};
+
+static int count( const char **list )
+{
+	int n = 0;
+	while ( list[n] != 0 )
+		n++;
+	return n;
+}
+
+static void cToken()
+{
+	char buf[64];
+	switch ( rnd( 16 ) ) {
+	case 0: case 1: case 2: case 3: case 4:
+		put( cWords[rnd( count( cWords ) )] );
+		break;
+	case 5: case 6:
+		word( buf, 1, 10 );
+		buf[rnd( strlen( buf ) )] = '_';
+		put( buf );
+		break;
+	case 7:
+		sprintf( buf, "%d", rnd( 100000 ) );
+		put( buf );
+		break;
+	case 8:
+		sprintf( buf, rnd( 2 ) ? "0x%x" : "0%o", rnd( 65536 ) );
+		put( buf );
+		break;
+	case 9:
+		sprintf( buf, rnd( 2 ) ? "%d.%d" : "%d.%de%d", rnd( 1000 ),
+				rnd( 1000 ), rnd( 40 ) );
+		put( buf );
+		break;
+	case 10:
+		putch( '"' );
+		word( buf, 0, 20 );
+		put( buf );
+		put( rnd( 2 ) ? "\\n" : "\\\"" );
+		putch( '"' );
+		break;
+	case 11:
+		put( rnd( 2 ) ? "'a'" : "'\\n'" );
+		break;
+	default:
+		put( cOps[rnd( count( cOps ) )] );
+		break;
+	}
+}
+
+static void cLine()
+{
+	int i, depth = rnd( 4 ), toks = 1 + rnd( 12 );
+
+	if ( rnd( 12 ) == 0 ) {
+		put( "/* " );
+		for ( i = rnd( 4 ); i > 0; i-- ) {
+			cToken();
+			put( rnd( 3 ) == 0 ? "\n * " : " " );
+		}
+		put( "*/\n" );
+		return;
+	}
+
+	for ( i = 0; i < depth; i++ )
+		putch( '\t' );
+	for ( i = 0; i < toks; i++ ) {
+		cToken();
+		if ( rnd( 3 ) != 0 )
+			putch( ' ' );
+	}
+	if ( rnd( 8 ) == 0 )
+		put( " // note" );
+	putch( '\n' );
+}
+
+static const char *days[] = { "Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun", 0 };
+static const char *months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+	"Jul", "Aug", "Sep", "Oct", "Nov", "Dec", 0 };
+static const char *headers[] = { "Subject", "To", "Cc", "Received",
+	"Message-Id", "Content-Type", "X-Mailer", 0 };
+
+static void text( int words )
+{
+	char buf[MAX_WORD];
+	int i;
+	for ( i = 0; i < words; i++ ) {
+		word( buf, 1, 9 );
+		if ( i > 0 )
+			putch( ' ' );
+		put( buf );
+	}
+}
+
+static void mboxMessage()
+{
+	char buf[128];
+	int i;
+
+	word( buf, 3, 8 );
+	put( "From " );
+	put( buf );
+	put( "@example.com " );
+	sprintf( buf, "%s %s %2d %02d:%02d:%02d %d", days[rnd( 7 )],
+			months[rnd( 12 )], 1 + rnd( 28 ), rnd( 24 ), rnd( 60 ), rnd( 60 ),
+			1990 + rnd( 30 ) );
+	put( buf );
+	if ( rnd( 2 ) )
+		put( rnd( 2 ) ? " -0500" : " +0100" );
+	putch( '\n' );
+
+	for ( i = 1 + rnd( 8 ); i > 0; i-- ) {
+		put( headers[rnd( count( headers ) )] );
+		put( ": " );
+		text( 1 + rnd( 8 ) );
+		putch( '\n' );
+		if ( rnd( 4 ) == 0 ) {
+			putch( '\t' );
+			text( 1 + rnd( 6 ) );
+			putch( '\n' );
+		}
+	}
+	putch( '\n' );
+
+	for ( i = rnd( 30 ); i > 0; i-- ) {
+		if ( rnd( 20 ) == 0 )
+			put( rnd( 2 ) ? ">From " : "From " );
+		text( rnd( 12 ) );
+		putch( '\n' );
+	}
+	putch( '\n' );
+}
+
+static const char *schemes[] = { "http", "https", "ftp", "file", "mailto", 0 };
+
+static void uriLine()
+{
+	char buf[MAX_WORD];
+	int i;
+
+	if ( rnd( 4 ) != 0 ) {
+		put( schemes[rnd( count( schemes ) )] );
+		put( "://" );
+		for ( i = 1 + rnd( 3 ); i > 0; i-- ) {
+			word( buf, 2, 10 );
+			put( buf );
+			putch( i > 1 ? '.' : '/' );
+		}
+	}
+	for ( i = rnd( 5 ); i > 0; i-- ) {
+		word( buf, 1, 12 );
+		put( buf );
+		if ( i > 1 )
+			putch( '/' );
+	}
+	if ( rnd( 3 ) == 0 ) {
+		putch( '?' );
+		for ( i = 1 + rnd( 4 ); i > 0; i-- ) {
+			word( buf, 1, 6 );
+			put( buf );
+			putch( '=' );
+			word( buf, 1, 8 );
+			put( buf );
+			if ( i > 1 )
+				putch( '&' );
+		}
+	}
+	if ( rnd( 6 ) == 0 ) {
+		putch( '#' );
+		word( buf, 1, 10 );
+		put( buf );
+	}
+	putch( '\n' );
+}
+
+static void utf8Char()
+{
+	int r = rnd( 20 ), c;
+	if ( r < 12 ) {
+		c = rnd( 5 ) == 0 ? ' ' : 'a' + rnd( 26 );
+		putch( c );
+	}
+	else if ( r < 16 ) {
+		c = 0x80 + rnd( 0x800 - 0x80 );
+		putch( 0xc0 | ( c >> 6 ) );
+		putch( 0x80 | ( c & 0x3f ) );
+	}
+	else if ( r < 19 ) {
+		c = 0x800 + rnd( 0xd800 - 0x800 );
+		putch( 0xe0 | ( c >> 12 ) );
+		putch( 0x80 | ( ( c >> 6 ) & 0x3f ) );
+		putch( 0x80 | ( c & 0x3f ) );
+	}
+	else {
+		c = 0x10000 + rnd( 0x110000 - 0x10000 );
+		putch( 0xf0 | ( c >> 18 ) );
+		putch( 0x80 | ( ( c >> 12 ) & 0x3f ) );
+		putch( 0x80 | ( ( c >> 6 ) & 0x3f ) );
+		putch( 0x80 | ( c & 0x3f ) );
+	}
+}
+
+static void keywordsToken( char (*words)[MAX_WORD] )
+{
+	char buf[MAX_WORD];
+	int r = rnd( 10 );
+	if ( r < 5 )
+		put( words[rnd( NUM_KEYWORDS )] );
+	else if ( r < 9 ) {
+		word( buf, 1, 12 );
+		put( buf );
+	}
+	else {
+		sprintf( buf, "%d", rnd( 10000 ) );
+		put( buf );
+	}
+	r = rnd( 12 );
+	putch( r == 0 ? '\n' : r == 1 ? ';' : r == 2 ? ',' : ' ' );
+}
+
+/* Lines of the literals in a grammar: those that start with a quote. */
+static char **literals( const char *fileName, int *num )
+{
+	char line[1024], **lits = 0;
+	FILE *file = fopen( fileName, "r" );
+	int alloc = 0;
+
+	if ( file == 0 ) {
+		fprintf( stderr, "gencorpus: could not open %s\n", fileName );
+		exit( 1 );
+	}
+
+	*num = 0;
+	while ( fgets( line, sizeof(line), file ) != 0 ) {
+		char *s = line, *d;
+		while ( *s == ' ' || *s == '\t' )
+			s++;
+		if ( *s++ != '"' )
+			continue;
+
+		if ( *num == alloc ) {
+			alloc = alloc * 2 + 64;
+			lits = realloc( lits, alloc * sizeof(char*) );
+		}
+		lits[*num] = d = malloc( strlen( s ) + 1 );
+		for ( ; *s != 0 && *s != '"'; s++ ) {
+			if ( *s == '\\' && s[1] != 0 ) {
+				s++;
+				*d++ = *s == 'n' ? '\n' : *s == 't' ? '\t' : *s;
+			}
+			else
+				*d++ = *s;
+		}
+		*d = 0;
+		*num += 1;
+	}
+	fclose( file );
+	return lits;
+}
+
+static void usage()
+{
+	fprintf( stderr,
+		"usage: gencorpus <kind> <bytes> [literal-file]\n"
+		"       gencorpus -g <grammar>\n"
+		"kinds: c mbox strings uri keywords dict utf8\n"
+		"grammars: keywords dict\n" );
+	exit( 1 );
+}
+
+int main( int argc, char **argv )
+{
+	const char *kind;
+	long bytes;
+
+	if ( argc == 3 && strcmp( argv[1], "-g" ) == 0 ) {
+		if ( strcmp( argv[2], "keywords" ) == 0 )
+			keywordsGrammar();
+		else if ( strcmp( argv[2], "dict" ) == 0 )
+			dictGrammar();
+		else
+			usage();
+		return 0;
+	}
+
+	if ( argc < 3 )
+		usage();
+	kind = argv[1];
+	bytes = atol( argv[2] );
+
+	if ( strcmp( kind, "c" ) == 0 ) {
+		while ( written < bytes )
+			cLine();
+	}
+	else if ( strcmp( kind, "mbox" ) == 0 ) {
+		while ( written < bytes )
+			mboxMessage();
+	}
+	else if ( strcmp( kind, "strings" ) == 0 ) {
+		int num, i;
+		char **lits;
+		if ( argc < 4 )
+			usage();
+		lits = literals( argv[3], &num );
+		if ( num == 0 )
+			usage();
+		while ( written < bytes ) {
+			char *lit = lits[rnd( num )];
+			/* Some lines are near misses. */
+			if ( rnd( 8 ) == 0 && strlen( lit ) > 1 ) {
+				int len = strlen( lit ), miss = rnd( len - 1 );
+				for ( i = 0; i < len; i++ )
+					putch( i == miss ? '#' : lit[i] );
+			}
+			else
+				put( lit );
+		}
+	}
+	else if ( strcmp( kind, "uri" ) == 0 ) {
+		while ( written < bytes )
+			uriLine();
+	}
+	else if ( strcmp( kind, "keywords" ) == 0 ) {
+		char (*words)[MAX_WORD] = wordList( NUM_KEYWORDS, KEYWORDS_SEED );
+		while ( written < bytes )
+			keywordsToken( words );
+		putch( '\n' );
+	}
+	else if ( strcmp( kind, "dict" ) == 0 ) {
+		char (*words)[MAX_WORD] = wordList( NUM_DICT, DICT_SEED );
+		char buf[MAX_WORD];
+		while ( written < bytes ) {
+			if ( rnd( 2 ) )
+				put( words[rnd( NUM_DICT )] );
+			else {
+				word( buf, 3, 12 );
+				put( buf );
+			}
+			putch( '\n' );
+		}
+	}
+	else if ( strcmp( kind, "utf8" ) == 0 ) {
+		while ( written < bytes ) {
+			utf8Char();
+			if ( rnd( 80 ) == 0 )
+				putch( '\n' );
+		}
+	}
+	else
+		usage();
+
+	return 0;
+}
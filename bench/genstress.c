@@ -0,0 +1,271 @@
+/*
+ *  Copyright 2009 Adrian Thurston <thurston@complang.org>
+ */
+
+/*  This file is part of Ragel.
+ *
+ *  Ragel is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Ragel is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Ragel; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Writes the stress grammars of the compiler benchmark. Each grammar stresses
+ * one part of machine construction and grows with its scale. The output
+ * depends only on the arguments.
+ *
+ *   genstress <grammar> [scale]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_WORD 16
+
+/* Our own generator: rand() differs between C libraries. */
+static unsigned long seed = 1;
+
+static int rnd( int n )
+{
+	seed = ( seed * 1103515245UL + 12345UL ) & 0x7fffffffUL;
+	return (int)( ( seed >> 8 ) % n );
+}
+
+static void word( char *dest, int minLen, int maxLen )
+{
+	int i, len = minLen + rnd( maxLen - minLen + 1 );
+	for ( i = 0; i < len; i++ )
+		dest[i] = 'a' + rnd( 26 );
+	dest[len] = 0;
+}
+
+static void grammarHead( const char *name, const char *comment, int scale )
+{
+	printf(
+		"/*\n"
+		" * %s Scale %d, written by genstress.\n"
+		" */\n"
+		"\n"
+		"%%%%{\n"
+		"\tmachine %s;\n", comment, scale, name );
+}
+
+/* The machine is run over a buffer by a function of its own name. */
+static void grammarTail( const char *name, const char *type, const char *decls )
+{
+	printf(
+		"}%%%%\n"
+		"\n"
+		"%%%% write data;\n"
+		"\n"
+		"int %s( %s *p, %s *pe )\n"
+		"{\n"
+		"\t%s *eof = pe;\n"
+		"\tint cs%s;\n"
+		"\n"
+		"\t%%%% write init;\n"
+		"\t%%%% write exec;\n"
+		"\n"
+		"\treturn cs != %s_error;\n"
+		"}\n", name, type, type, type, decls, name );
+}
+
+/* A union of keywords, each with an action of its own. */
+static void kwunionGrammar( int scale )
+{
+	char buf[MAX_WORD];
+	int i;
+
+	grammarHead( "kwunion", "A union of many keywords.", scale );
+	printf( "\n\tmain := ( (\n" );
+	for ( i = 0; i < scale; i++ ) {
+		word( buf, 3, 12 );
+		printf( "\t\t'%s' @{ tok = %d; }%s\n", buf, i + 1,
+				i < scale - 1 ? " |" : "" );
+	}
+	printf( "\t) ' ' )*;\n" );
+	grammarTail( "kwunion", "char", ", tok = 0" );
+}
+
+/* Scanners calling one another to a depth of the scale. */
+static void scannersGrammar( int scale )
+{
+	char buf[MAX_WORD];
+	int i, k;
+
+	grammarHead( "scanners", "Deeply nested scanners.", scale );
+	for ( i = 0; i < scale; i++ ) {
+		if ( i == 0 )
+			printf( "\n\tmain := |*\n" );
+		else {
+			printf( "\n\ts%d := |*\n", i );
+			printf( "\t\t')' => { fret; };\n" );
+		}
+		if ( i < scale - 1 )
+			printf( "\t\t'(' => { fcall s%d; };\n", i + 1 );
+		for ( k = 0; k < 8; k++ ) {
+			word( buf, 2, 8 );
+			printf( "\t\t'%s' => { tok = %d; };\n", buf, i * 8 + k );
+		}
+		printf(
+			"\t\t[a-z_] [a-z0-9_]* => { tok = -1; };\n"
+			"\t\tdigit+ ( '.' digit+ )? ( [eE] [+\\-]? digit+ )? => { tok = -2; };\n"
+			"\t\t'\"' ( [^\"\\\\] | '\\\\' any )* '\"' => { tok = -3; };\n"
+			"\t\t'/*' any* :>> '*/';\n"
+			"\t\tspace;\n"
+			"\t*|;\n" );
+	}
+	grammarTail( "scanners", "char", ", tok, act, top, stack[1024];\n"
+			"\tchar *ts, *te" );
+}
+
+/* Bounded repetitions, counted out in full. */
+static void repeatGrammar( int scale )
+{
+	grammarHead( "repeat", "Large bounded repetitions.", scale );
+	printf(
+		"\n"
+		"\tfield = [a-z]{2,8} [,;];\n"
+		"\tword = [a-z]+ ' ';\n"
+		"\n"
+		"\tmain := (\n"
+		"\t\tfield{%d,%d} |\n"
+		"\t\tword{1,%d} |\n"
+		"\t\tdigit{1,%d} '.' xdigit{%d,%d}\n"
+		"\t) '\\n';\n",
+		scale / 2, scale, scale, scale, scale / 4, scale / 2 );
+	grammarTail( "repeat", "char", "" );
+}
+
+/* Conditions on overlapping ranges, so keys carry several at once. */
+static void condsGrammar( int scale )
+{
+	int i;
+
+	grammarHead( "conds", "Many conditions on overlapping ranges.", scale );
+	printf( "\n" );
+	for ( i = 0; i < scale; i++ )
+		printf( "\taction c%d { ( flags >> %d ) & 1 }\n", i, i % 31 );
+	printf( "\n\tmain := ( (\n" );
+	for ( i = 0; i < scale; i++ ) {
+		int lo = 0x21 + ( i * 5 ) % 80, hi = lo + 15;
+		printf( "\t\t( 0x%02x..0x%02x when c%d )+ '%c'%s\n", lo,
+				hi > 0x7e ? 0x7e : hi, i, 'a' + i % 26,
+				i < scale - 1 ? " |" : "" );
+	}
+	printf( "\t) ' ' )*;\n" );
+	grammarTail( "conds", "char", ", flags = 0" );
+}
+
+/* Intersections and subtractions of machines that determinize to many
+ * states. */
+static void setopsGrammar( int scale )
+{
+	grammarHead( "setops", "Intersections and subtractions.", scale );
+	printf(
+		"\n"
+		"\tnth = [a-d]* 'a' [a-d]{%d};\n"
+		"\thasB = [a-d]* 'b' [a-d]*;\n"
+		"\tnoRun = [a-d]* ( 'abca' | 'dd' ) [a-d]*;\n"
+		"\n"
+		"\tmain := ( ( nth & hasB ) - noRun ) '\\n' |\n"
+		"\t\t( nth - ( [a-d]* 'c' [a-d]{%d} ) ) '\\n';\n",
+		scale, scale / 2 );
+	grammarTail( "setops", "char", "" );
+}
+
+/* Sequences over a wide alphabet, spread across the code points. */
+static void wideGrammar( int scale )
+{
+	int i, k;
+
+	grammarHead( "wide", "A union over a wide alphabet.", scale );
+	printf( "\talphtype int;\n\n\tmain := ( (\n" );
+	for ( i = 0; i < scale; i++ ) {
+		int len = 2 + rnd( 4 );
+		printf( "\t\t" );
+		for ( k = 0; k < len; k++ ) {
+			/* Mostly single points, some ranges. */
+			int c = rnd( 0x110000 );
+			if ( rnd( 4 ) == 0 )
+				printf( "0x%x..0x%x ", c, c + rnd( 0x1000 ) );
+			else
+				printf( "0x%x ", c );
+		}
+		printf( "@{ tok = %d; } |\n", i + 1 );
+	}
+	printf(
+		"\t\t0x4e00..0x9fff+\n"
+		"\t) 0x20 )*;\n" );
+	grammarTail( "wide", "int", ", tok = 0" );
+}
+
+/* States that cover the same wide key space and cut it at different points.
+ * They fall into one initial partition of the minimization. */
+static void cutsGrammar( int scale )
+{
+	int i;
+
+	grammarHead( "cuts", "States cutting a wide alphabet at many points.", scale );
+	printf( "\talphtype int;\n\n\tmain := ( (\n" );
+	for ( i = 0; i < scale; i++ ) {
+		int cut = 0x100 + i * ( 0x10f000 / scale ) + rnd( 0x100 );
+		printf( "\t\t0x%x ( 0x100..0x%x 0x61 | 0x%x..0x10ffff 0x62 )%s\n",
+				i + 1, cut, cut + 1, i < scale - 1 ? " |" : "" );
+	}
+	printf( "\t) 0x20 )*;\n" );
+	grammarTail( "cuts", "int", "" );
+}
+
+static void usage()
+{
+	fprintf( stderr,
+		"usage: genstress <grammar> [scale]\n"
+		"grammars: kwunion scanners repeat conds setops wide cuts\n" );
+	exit( 1 );
+}
+
+int main( int argc, char **argv )
+{
+	const char *grammar;
+	int scale = 0;
+
+	if ( argc < 2 || argc > 3 )
+		usage();
+	grammar = argv[1];
+	if ( argc == 3 ) {
+		scale = atoi( argv[2] );
+		if ( scale < 2 )
+			usage();
+	}
+
+	if ( strcmp( grammar, "kwunion" ) == 0 )
+		kwunionGrammar( scale ? scale : 10000 );
+	else if ( strcmp( grammar, "scanners" ) == 0 )
+		scannersGrammar( scale ? scale : 200 );
+	else if ( strcmp( grammar, "repeat" ) == 0 )
+		repeatGrammar( scale ? scale : 400 );
+	else if ( strcmp( grammar, "conds" ) == 0 )
+		condsGrammar( scale ? scale : 24 );
+	else if ( strcmp( grammar, "setops" ) == 0 )
+		setopsGrammar( scale ? scale : 10 );
+	else if ( strcmp( grammar, "wide" ) == 0 )
+		wideGrammar( scale ? scale : 5000 );
+	else if ( strcmp( grammar, "cuts" ) == 0 )
+		cutsGrammar( scale ? scale : 2000 );
+	else
+		usage();
+
+	return 0;
+}
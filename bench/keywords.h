@@ -0,0 +1,13 @@
+#ifndef _KEYWORDS_H
+#define _KEYWORDS_H
+
+#include "bench.h"
+
+struct keywords_bench
+{
+	int cs, act;
+	char *tok_start, *tok_end;
+	long check;
+};
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef _MAILBOX_H
+#define _MAILBOX_H
+
+#include <stdio.h>
+#include "vector.h"
+#include "bench.h"
+
+struct mailbox_bench
+{
+	int cs;
+	Vector<char> headName;
+	Vector<char> headContent;
+	long check;
+};
+
+/* The actions of test/mailbox1.rl print the headers. Count them instead. */
+#define printf(...) (fsm->check += 1)
+
+#endif
@@ -0,0 +1,27 @@
+/*
+ * Benchmark of the mailbox parser in test/mailbox1.rl.
+ */
+
+#include "mailbox.h"
+
+%%{
+	machine mailbox_bench;
+	access fsm->;
+	include MBox "test/mailbox1.rl";
+}%%
+
+%% write data;
+
+long bench_run( char *data, long len )
+{
+	struct mailbox_bench bench, *fsm = &bench;
+	char *p = data, *pe = data + len;
+
+	%% write init;
+	fsm->check = 0;
+	%% write exec;
+
+	if ( fsm->cs == mailbox_bench_error )
+		return -1;
+	return fsm->check;
+}
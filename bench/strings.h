@@ -0,0 +1,12 @@
+#ifndef _STRINGS_H
+#define _STRINGS_H
+
+#include <string.h>
+#include "bench.h"
+
+struct strings_bench
+{
+	int cs;
+};
+
+#endif
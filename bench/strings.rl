@@ -0,0 +1,34 @@
+/*
+ * Benchmark of the union of literals in test/strings2.rl. Each line of the
+ * corpus is tested on its own.
+ */
+
+#include "strings.h"
+
+%%{
+	machine strings_bench;
+	access fsm->;
+	include strs "test/strings2.rl";
+}%%
+
+%% write data;
+
+long bench_run( char *data, long len )
+{
+	struct strings_bench bench, *fsm = &bench;
+	char *line = data, *end = data + len;
+	long accepted = 0;
+
+	while ( line < end ) {
+		char *nl = memchr( line, '\n', end - line );
+		char *p = line, *pe = nl != 0 ? nl + 1 : end;
+
+		%% write init;
+		%% write exec;
+
+		if ( fsm->cs >= strings_bench_first_final )
+			accepted += 1;
+		line = pe;
+	}
+	return accepted;
+}
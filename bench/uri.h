@@ -0,0 +1,12 @@
+#ifndef _URI_H
+#define _URI_H
+
+#include <string.h>
+#include "bench.h"
+
+struct uri_bench
+{
+	int cs;
+};
+
+#endif
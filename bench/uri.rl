@@ -0,0 +1,34 @@
+/*
+ * Benchmark of the URI machine in examples/uri.rl. Each line of the corpus
+ * is one URI.
+ */
+
+#include "uri.h"
+
+%%{
+	machine uri_bench;
+	access fsm->;
+	include uri "examples/uri.rl";
+}%%
+
+%% write data;
+
+long bench_run( char *data, long len )
+{
+	struct uri_bench bench, *fsm = &bench;
+	char *line = data, *end = data + len;
+	long accepted = 0;
+
+	while ( line < end ) {
+		char *nl = memchr( line, '\n', end - line );
+		char *p = line, *pe = nl != 0 ? nl : end, *eof = pe;
+
+		%% write init;
+		%% write exec;
+
+		if ( fsm->cs >= uri_bench_first_final )
+			accepted += 1;
+		line = pe + 1;
+	}
+	return accepted;
+}
@@ -0,0 +1,12 @@
+#ifndef _UTF8_H
+#define _UTF8_H
+
+#include "bench.h"
+
+struct utf8_bench
+{
+	int cs;
+	long chars;
+};
+
+#endif
@@ -0,0 +1,43 @@
+/*
+ * Counts the characters of UTF-8 text, rejecting overlong forms and
+ * surrogates.
+ */
+
+#include "utf8.h"
+
+%%{
+	machine utf8_bench;
+	alphtype unsigned char;
+	access fsm->;
+
+	action char { fsm->chars += 1; }
+
+	tail = 0x80..0xbf;
+	utf8 =
+		0x00..0x7f |
+		0xc2..0xdf tail |
+		0xe0 0xa0..0xbf tail |
+		( 0xe1..0xec | 0xee..0xef ) tail tail |
+		0xed 0x80..0x9f tail |
+		0xf0 0x90..0xbf tail tail |
+		0xf1..0xf3 tail tail tail |
+		0xf4 0x80..0x8f tail tail;
+
+	main := ( utf8 @char )*;
+}%%
+
+%% write data;
+
+long bench_run( char *data, long len )
+{
+	struct utf8_bench bench, *fsm = &bench;
+	unsigned char *p = (unsigned char*)data, *pe = p + len;
+
+	%% write init;
+	fsm->chars = 0;
+	%% write exec;
+
+	if ( fsm->cs == utf8_bench_error )
+		return -1;
+	return fsm->chars;
+}
@@ -26,6 +26,7 @@
 #include "redfsm.h"
 #include "gendata.h"
 #include <sstream>
+#include <fstream>
 #include <string>
 #include <assert.h>
 
@@ -223,6 +224,19 @@ string FsmCodeGen::TOP()
 	return ret.str();
 }
 
+string FsmCodeGen::COUNTERS()
+{
+	ostringstream ret;
+	if ( countersExpr == 0 )
+		ret << ACCESS() + "counters";
+	else {
+		ret << "(";
+		INLINE_LIST( ret, countersExpr, 0, false, false );
+		ret << ")";
+	}
+	return ret.str();
+}
+
 string FsmCodeGen::STACK()
 {
 	ostringstream ret;
@@ -530,6 +544,9 @@ void FsmCodeGen::INLINE_LIST( ostream &ret, GenInlineList *inlineList,
 		case GenInlineItem::Break:
 			BREAK( ret, targState, csForced );
 			break;
+		case GenInlineItem::Counter:
+			ret << COUNTERS() << "[" << item->counterId << "]";
+			break;
 		}
 	}
 }
@@ -549,6 +566,9 @@ string FsmCodeGen::LDIR_PATH( char *path )
 void FsmCodeGen::ACTION( ostream &ret, GenAction *action, int targState, 
 		bool inFinish, bool csForced )
 {
+	if ( instrumentOpt )
+		ret << "\t" << PCA() << "[" << action->actionId << "]++;\n";
+
 	/* Write the preprocessor line info for going into the source file. */
 	cdLineDirective( ret, action->loc.fileName, action->loc.line );
 
@@ -654,6 +674,11 @@ void FsmCodeGen::STATE_IDS()
 	if ( !noError )
 		STATIC_VAR( "int", ERROR() ) << " = " << ERROR_STATE() << ";\n";
 
+	if ( numCounters > 0 ) {
+		STATIC_VAR( "int", DATA_PREFIX() + "num_counters" ) <<
+				" = " << numCounters << ";\n";
+	}
+
 	out << "\n";
 
 	if ( entryPointNames.length() > 0 ) {
@@ -665,6 +690,106 @@ void FsmCodeGen::STATE_IDS()
 	}
 }
 
+/* Increment the entry counter of a state, with --instrument. */
+string FsmCodeGen::PROF_STATE( string state )
+{
+	if ( !instrumentOpt )
+		return "";
+	return "\t" + PCS() + "[" + state + "]++;\n";
+}
+
+/* Increment the counter of a transition by id, with --instrument. */
+string FsmCodeGen::PROF_TRANS( string trans )
+{
+	if ( !instrumentOpt )
+		return "";
+	return "\t" + PCT() + "[" + trans + "]++;\n";
+}
+
+/* Count an eof transition ahead of the jump the goto styles take to it. The
+ * table styles count it with the others, as they go through _trans. */
+string FsmCodeGen::PROF_EOF( RedTransAp *trans )
+{
+	if ( !instrumentOpt )
+		return "";
+	ostringstream ret;
+	ret << PCT() << "[" << trans->id << "]++; ";
+	return ret.str();
+}
+
+/* The counters of an instrumented build and a function writing them out in
+ * the form --profile-use reads. Actions are given as "action <id> <count>"
+ * lines, which --profile-use passes over. */
+void FsmCodeGen::PROF_DATA()
+{
+	if ( !instrumentOpt )
+		return;
+
+	int numStates = redFsm->nextStateId;
+	int numTrans = redFsm->transSet.length();
+	int numActions = actionList.length();
+
+	if ( numTrans > 0 ) {
+		RedTransAp **transPtrs = new RedTransAp*[numTrans];
+		for ( TransApSet::Iter trans = redFsm->transSet; trans.lte(); trans++ )
+			transPtrs[trans->id] = trans;
+
+		OPEN_ARRAY( "int", PTT() );
+		out << "\t";
+		for ( int t = 0; t < numTrans; t++ ) {
+			out << transPtrs[t]->targ->id;
+			if ( t < numTrans-1 ) {
+				out << ", ";
+				if ( (t+1) % IALL == 0 )
+					out << "\n\t";
+			}
+		}
+		out << "\n";
+		CLOSE_ARRAY() << "\n";
+		delete[] transPtrs;
+	}
+
+	PROF_ARRAY( PCS(), numStates );
+	if ( numTrans > 0 )
+		PROF_ARRAY( PCT(), numTrans );
+	if ( numActions > 0 )
+		PROF_ARRAY( PCA(), numActions );
+	out << "\n";
+
+	PROF_DUMP( numStates, numTrans, numActions );
+}
+
+/* The routine writing out the counters, in C. */
+void FsmCodeGen::PROF_DUMP( int numStates, int numTrans, int numActions )
+{
+	out <<
+		"static void " << DATA_PREFIX() << "dump_profile( FILE *_out )\n"
+		"{\n"
+		"	int i;\n"
+		"	fprintf( _out, \"machine " << fsmName << "\\n\" );\n"
+		"	for ( i = 0; i < " << numStates << "; i++ )\n"
+		"		fprintf( _out, \"state %d " << PROF_FORMAT() << "\\n\", i, " << 
+				PCS() << "[i] );\n";
+
+	if ( numTrans > 0 ) {
+		out <<
+			"	for ( i = 0; i < " << numTrans << "; i++ )\n"
+			"		fprintf( _out, \"trans %d %d " << PROF_FORMAT() << "\\n\", i, " << 
+					PTT() << "[i], " << PCT() << "[i] );\n";
+	}
+
+	if ( numActions > 0 ) {
+		out <<
+			"	for ( i = 0; i < " << numActions << "; i++ )\n"
+			"		fprintf( _out, \"action %d " << PROF_FORMAT() << "\\n\", i, " << 
+					PCA() << "[i] );\n";
+	}
+
+	out <<
+		"}\n"
+		"\n";
+}
+
 void FsmCodeGen::writeStart()
 {
 	out << START_STATE_ID();
@@ -706,6 +831,23 @@ std::ostream &CCodeGen::STATIC_VAR( string type, string name )
 	return out;
 }
 
+/* Counters are thread-local where the compiler offers it. */
+std::ostream &CCodeGen::PROF_ARRAY( string name, long length )
+{
+	out <<
+		"#if defined(__GNUC__)\n"
+		"static __thread unsigned long " << name << "[" << length << "];\n"
+		"#else\n"
+		"static unsigned long " << name << "[" << length << "];\n"
+		"#endif\n";
+	return out;
+}
+
+string CCodeGen::PROF_FORMAT()
+{
+	return "%lu";
+}
+
 string CCodeGen::UINT( )
 {
 	return "unsigned int";
@@ -799,6 +941,50 @@ string DCodeGen::CAST( string type )
 	return "cast(" + type + ")";
 }
 
+/* Module level variables are thread-local in D2. */
+std::ostream &DCodeGen::PROF_ARRAY( string name, long length )
+{
+	out << "static ulong[" << length << "] " << name << ";\n";
+	return out;
+}
+
+/* The routine writing out the counters, in D. FILE and fprintf come from the
+ * C library, imported next to the routine so any scope can hold it. */
+void DCodeGen::PROF_DUMP( int numStates, int numTrans, int numActions )
+{
+	out <<
+		"import core.stdc.stdio;\n"
+		"static void " << DATA_PREFIX() << "dump_profile( FILE *_out )\n"
+		"{\n"
+		"	fprintf( _out, \"machine " << fsmName << "\\n\" );\n"
+		"	for ( int i = 0; i < " << numStates << "; i++ )\n"
+		"		fprintf( _out, \"state %d " << PROF_FORMAT() << "\\n\", i, " << 
+				PCS() << "[i] );\n";
+
+	if ( numTrans > 0 ) {
+		out <<
+			"	for ( int i = 0; i < " << numTrans << "; i++ )\n"
+			"		fprintf( _out, \"trans %d %d " << PROF_FORMAT() << "\\n\", i, " << 
+					PTT() << "[i], " << PCT() << "[i] );\n";
+	}
+
+	if ( numActions > 0 ) {
+		out <<
+			"	for ( int i = 0; i < " << numActions << "; i++ )\n"
+			"		fprintf( _out, \"action %d " << PROF_FORMAT() << "\\n\", i, " << 
+					PCA() << "[i] );\n";
+	}
+
+	out <<
+		"}\n"
+		"\n";
+}
+
+string DCodeGen::PROF_FORMAT()
+{
+	return "%llu";
+}
+
 string DCodeGen::UINT( )
 {
 	return "uint";
@@ -830,11 +1016,31 @@ void DCodeGen::writeExports()
  * End D-specific code.
  */
 
+/* Load the counts of this machine from the profile given with --profile-use.
+ * Machines the profile has no counts for are laid out as usual. */
+void FsmCodeGen::readProfile()
+{
+	std::ifstream in( profileUseFile );
+	if ( !in.is_open() ) {
+		error() << "could not open " << profileUseFile << " for reading" << endl;
+		return;
+	}
+
+	if ( !redFsm->readProfile( in, fsmName ) ) {
+		error() << "profile " << profileUseFile << " does not fit machine " << 
+				fsmName << endl;
+	}
+}
+
 void FsmCodeGen::finishRagelDef()
 {
-	if ( codeStyle == GenGoto || codeStyle == GenFGoto || 
-			codeStyle == GenIpGoto || codeStyle == GenSplit )
-	{
+	/* The counts of a profile steer the ordering and the defaults. */
+	if ( profileUseFile != 0 )
+		readProfile();
+
+	bool gotoStyle = codeStyle == GenGoto || codeStyle == GenFGoto || 
+			codeStyle == GenIpGoto || codeStyle == GenSplit;
+	if ( gotoStyle ) {
 		/* For directly executable machines there is no required state
 		 * ordering. Choose a depth-first ordering to increase the
 		 * potential for fall-throughs. */
@@ -846,12 +1052,28 @@ void FsmCodeGen::finishRagelDef()
 		redFsm->sortByStateId();
 	}
 
-	/* Choose default transitions and the single transition. */
-	redFsm->chooseDefaultSpan();
+	/* Choose default transitions and the single transition. Directly
+	 * executable machines test for every transition but the default, so
+	 * with a profile the least taken one is made the default. */
+	if ( gotoStyle && redFsm->profiled )
+		redFsm->chooseDefaultProfile();
+	else
+		redFsm->chooseDefaultSpan();
 		
 	/* Maybe do flat expand, otherwise choose single. */
-	if ( codeStyle == GenFlat || codeStyle == GenFFlat )
-		redFsm->makeFlat();
+	if ( codeStyle == GenFlat || codeStyle == GenFFlat ) {
+		if ( !redFsm->makeFlat( true, flatPagesOpt ) ) {
+			error() << "-F0 and -F1 cannot lay out machine " << fsmName << 
+					", it has conditions over a key span too wide for pages" << endl;
+		}
+	}
+	else if ( codeStyle == GenCombTables ) {
+		if ( !redFsm->makeComb() ) {
+			error() << "-T2 cannot lay out machine " << fsmName << 
+					", it has conditions over a key span wider than " <<
+					FLAT_PAGE_SPAN << endl;
+		}
+	}
 	else
 		redFsm->chooseSingle();
 
@@ -60,6 +60,7 @@ public:
 	virtual ~FsmCodeGen() {}
 
 	virtual void finishRagelDef();
+	void readProfile();
 	virtual void writeInit();
 	virtual void writeStart();
 	virtual void writeFirstFinal();
@@ -75,9 +76,9 @@ protected:
 	string KEY( Key key );
 	string WIDE_KEY( RedStateAp *state, Key key );
 	string LDIR_PATH( char *path );
-	void ACTION( ostream &ret, GenAction *action, int targState, 
+	virtual void ACTION( ostream &ret, GenAction *action, int targState, 
 			bool inFinish, bool csForced );
-	void CONDITION( ostream &ret, GenAction *condition );
+	virtual void CONDITION( ostream &ret, GenAction *condition );
 	string ALPH_TYPE();
 	string WIDE_ALPH_TYPE();
 	string ARRAY_TYPE( unsigned long maxVal );
@@ -101,6 +102,7 @@ protected:
 	string vCS();
 	string STACK();
 	string TOP();
+	string COUNTERS();
 	string TOKSTART();
 	string TOKEND();
 	string ACT();
@@ -126,6 +128,18 @@ protected:
 	string ET() { return "_" + DATA_PREFIX() + "eof_trans"; }
 	string SP() { return "_" + DATA_PREFIX() + "key_spans"; }
 	string CSP() { return "_" + DATA_PREFIX() + "cond_key_spans"; }
+	string CC() { return "_" + DATA_PREFIX() + "char_class"; }
+	string CLK() { return "_" + DATA_PREFIX() + "class_keys"; }
+	string PO() { return "_" + DATA_PREFIX() + "page_offsets"; }
+	string PG() { return "_" + DATA_PREFIX() + "pages"; }
+	string ID() { return "_" + DATA_PREFIX() + "index_defaults"; }
+	string BS() { return "_" + DATA_PREFIX() + "base"; }
+	string NX() { return "_" + DATA_PREFIX() + "next"; }
+	string CHK() { return "_" + DATA_PREFIX() + "check"; }
+	string PCS() { return "_" + DATA_PREFIX() + "prof_states"; }
+	string PCT() { return "_" + DATA_PREFIX() + "prof_trans"; }
+	string PCA() { return "_" + DATA_PREFIX() + "prof_actions"; }
+	string PTT() { return "_" + DATA_PREFIX() + "prof_targs"; }
 	string START() { return DATA_PREFIX() + "start"; }
 	string ERROR() { return DATA_PREFIX() + "error"; }
 	string FIRST_FINAL() { return DATA_PREFIX() + "first_final"; }
@@ -144,7 +158,7 @@ protected:
 	virtual void BREAK( ostream &ret, int targState, bool csForced ) = 0;
 	virtual void CURS( ostream &ret, bool inFinish ) = 0;
 	virtual void TARGS( ostream &ret, bool inFinish, int targState ) = 0;
-	void EXEC( ostream &ret, GenInlineItem *item, int targState, int inFinish );
+	virtual void EXEC( ostream &ret, GenInlineItem *item, int targState, int inFinish );
 	void LM_SWITCH( ostream &ret, GenInlineItem *item, int targState, 
 			int inFinish, bool csForced );
 	void SET_ACT( ostream &ret, GenInlineItem *item );
@@ -155,7 +169,14 @@ protected:
 	void GET_TOKEND( ostream &ret, GenInlineItem *item );
 	void SUB_ACTION( ostream &ret, GenInlineItem *item, 
 			int targState, bool inFinish, bool csForced );
-	void STATE_IDS();
+	virtual void STATE_IDS();
+
+	/* Counters of an instrumented build. */
+	string PROF_STATE( string state );
+	string PROF_TRANS( string trans );
+	string PROF_EOF( RedTransAp *trans );
+	void PROF_DATA();
+	virtual void PROF_DUMP( int numStates, int numTrans, int numActions );
 
 	string ERROR_STATE();
 	string FIRST_FINAL_STATE();
@@ -164,6 +185,8 @@ protected:
 	virtual ostream &OPEN_ARRAY( string type, string name ) = 0;
 	virtual ostream &CLOSE_ARRAY() = 0;
 	virtual ostream &STATIC_VAR( string type, string name ) = 0;
+	virtual ostream &PROF_ARRAY( string name, long length ) = 0;
+	virtual string PROF_FORMAT() = 0;
 
 	virtual string CTRL_FLOW() = 0;
 
@@ -177,7 +200,7 @@ protected:
 	bool againLabelUsed;
 	bool useIndicies;
 
-	void genLineDirective( ostream &out );
+	virtual void genLineDirective( ostream &out );
 
 public:
 	/* Determine if we should use indicies. */
@@ -195,6 +218,8 @@ public:
 	virtual ostream &OPEN_ARRAY( string type, string name );
 	virtual ostream &CLOSE_ARRAY();
 	virtual ostream &STATIC_VAR( string type, string name );
+	virtual ostream &PROF_ARRAY( string name, long length );
+	virtual string PROF_FORMAT();
 	virtual string ARR_OFF( string ptr, string offset );
 	virtual string CAST( string type );
 	virtual string UINT();
@@ -215,6 +240,9 @@ public:
 	virtual ostream &OPEN_ARRAY( string type, string name );
 	virtual ostream &CLOSE_ARRAY();
 	virtual ostream &STATIC_VAR( string type, string name );
+	virtual ostream &PROF_ARRAY( string name, long length );
+	virtual string PROF_FORMAT();
+	virtual void PROF_DUMP( int numStates, int numTrans, int numActions );
 	virtual string ARR_OFF( string ptr, string offset );
 	virtual string CAST( string type );
 	virtual string UINT();
@@ -0,0 +1,411 @@
+/*
+ *  Copyright 2010 Adrian Thurston <thurston@complang.org>
+ */
+
+/*  This file is part of Ragel.
+ *
+ *  Ragel is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ * 
+ *  Ragel is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ * 
+ *  You should have received a copy of the GNU General Public License
+ *  along with Ragel; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA 
+ */
+
+#include "ragel.h"
+#include "cdcomb.h"
+#include "redfsm.h"
+#include "gendata.h"
+
+std::ostream &CombCodeGen::COMB_BASE()
+{
+	out << "\t";
+	int totalStateNum = 0;
+	for ( RedStateList::Iter st = redFsm->stateList; st.lte(); st++ ) {
+		out << st->combBase;
+		if ( !st.last() ) {
+			out << ", ";
+			if ( ++totalStateNum % IALL == 0 )
+				out << "\n\t";
+		}
+	}
+	out << "\n";
+	return out;
+}
+
+std::ostream &CombCodeGen::COMB_CHECK()
+{
+	out << "\t";
+	for ( long slot = 0; slot < redFsm->combSize; slot++ ) {
+		out << ( slot < redFsm->maxCombBase + redFsm->numCombCols ?
+				redFsm->combCheck[slot] : redFsm->nextStateId );
+		if ( slot < redFsm->combSize - 1 ) {
+			out << ", ";
+			if ( (slot+1) % IALL == 0 )
+				out << "\n\t";
+		}
+	}
+	out << "\n";
+	return out;
+}
+
+std::ostream &CombCodeGen::COMB_NEXT()
+{
+	out << "\t";
+	for ( long slot = 0; slot < redFsm->combSize; slot++ ) {
+		RedTransAp *trans = slot < redFsm->maxCombBase + redFsm->numCombCols ?
+				redFsm->combNext[slot] : 0;
+		out << ( trans != 0 ? trans->id : 0 );
+		if ( slot < redFsm->combSize - 1 ) {
+			out << ", ";
+			if ( (slot+1) % IALL == 0 )
+				out << "\n\t";
+		}
+	}
+	out << "\n";
+	return out;
+}
+
+std::ostream &CombCodeGen::COMB_DEFAULTS()
+{
+	out << "\t";
+	int totalStateNum = 0;
+	for ( RedStateList::Iter st = redFsm->stateList; st.lte(); st++ ) {
+		out << ( st->combDefTrans != 0 ? st->combDefTrans->id : 0 );
+		if ( !st.last() ) {
+			out << ", ";
+			if ( ++totalStateNum % IALL == 0 )
+				out << "\n\t";
+		}
+	}
+	out << "\n";
+	return out;
+}
+
+void CombCodeGen::LOCATE_TRANS()
+{
+	if ( redFsm->anyClassIntervals() ) {
+		CLASS_SEARCH();
+		out <<
+			"	_off = " << BS() << "[" << vCS() << "] + _cls;\n"
+			"	_trans = " << CHK() << "[_off] == " << vCS() << " ?\n"
+			"		" << NX() << "[_off] : " << ID() << "[" << vCS() << "];\n"
+			"\n";
+	}
+	else if ( redFsm->anyCharClasses() ) {
+		out <<
+			"	_off = " << BS() << "[" << vCS() << "] + (" << CLASS_OF_KEY() << ");\n"
+			"	_trans = " << CHK() << "[_off] == " << vCS() << " ?\n"
+			"		" << NX() << "[_off] : " << ID() << "[" << vCS() << "];\n"
+			"\n";
+	}
+	else if ( redFsm->numCombCols > 0 ) {
+		out <<
+			"	_off = " << BS() << "[" << vCS() << "] + " << CAST("int") << "(" <<
+					GET_WIDE_KEY() << " - " << KEY( redFsm->combLowKey ) << ");\n"
+			"	_trans = " << GET_WIDE_KEY() << " < " << KEY( redFsm->combLowKey ) << " ||\n"
+			"		" << GET_WIDE_KEY() << " > " << KEY( redFsm->combHighKey ) << " ||\n"
+			"		" << CHK() << "[_off] != " << vCS() << " ?\n"
+			"		" << ID() << "[" << vCS() << "] : " << NX() << "[_off];\n"
+			"\n";
+	}
+	else {
+		out <<
+			"	_off = 0;\n"
+			"	_trans = " << ID() << "[" << vCS() << "];\n"
+			"\n";
+	}
+}
+
+void CombCodeGen::writeData()
+{
+	/* If there are any transtion functions then output the array. If there
+	 * are none, don't bother emitting an empty array that won't be used. */
+	if ( redFsm->anyActions() ) {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxActArrItem), A() );
+		ACTIONS_ARRAY();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+
+	if ( redFsm->anyConditions() ) {
+		OPEN_ARRAY( WIDE_ALPH_TYPE(), CK() );
+		COND_KEYS();
+		CLOSE_ARRAY() <<
+		"\n";
+
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxCondSpan), CSP() );
+		COND_KEY_SPANS();
+		CLOSE_ARRAY() <<
+		"\n";
+
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxCond), C() );
+		CONDS();
+		CLOSE_ARRAY() <<
+		"\n";
+
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxCondIndexOffset), CO() );
+		COND_INDEX_OFFSET();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+
+	if ( redFsm->anyClassIntervals() ) {
+		OPEN_ARRAY( ALPH_TYPE(), CLK() );
+		CLASS_KEYS();
+		CLOSE_ARRAY() <<
+		"\n";
+
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->numClasses), CC() );
+		CLASS_INTERVALS();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+	else if ( redFsm->anyCharClasses() ) {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->numClasses), CC() );
+		CHAR_CLASS();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+
+	OPEN_ARRAY( ARRAY_TYPE(redFsm->maxCombBase), BS() );
+	COMB_BASE();
+	CLOSE_ARRAY() <<
+	"\n";
+
+	OPEN_ARRAY( ARRAY_TYPE(redFsm->nextStateId), CHK() );
+	COMB_CHECK();
+	CLOSE_ARRAY() <<
+	"\n";
+
+	OPEN_ARRAY( ARRAY_TYPE(redFsm->maxIndex), NX() );
+	COMB_NEXT();
+	CLOSE_ARRAY() <<
+	"\n";
+
+	OPEN_ARRAY( ARRAY_TYPE(redFsm->maxIndex), ID() );
+	COMB_DEFAULTS();
+	CLOSE_ARRAY() <<
+	"\n";
+
+	OPEN_ARRAY( ARRAY_TYPE(redFsm->maxState), TT() );
+	TRANS_TARGS();
+	CLOSE_ARRAY() <<
+	"\n";
+
+	if ( redFsm->anyActions() ) {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxActionLoc), TA() );
+		TRANS_ACTIONS();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+
+	if ( redFsm->anyToStateActions() ) {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxActionLoc), TSA() );
+		TO_STATE_ACTIONS();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+
+	if ( redFsm->anyFromStateActions() ) {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxActionLoc), FSA() );
+		FROM_STATE_ACTIONS();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+
+	if ( redFsm->anyEofActions() ) {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxActionLoc), EA() );
+		EOF_ACTIONS();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+
+	if ( redFsm->anyEofTrans() ) {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxIndexOffset+1), ET() );
+		EOF_TRANS();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+
+	STATE_IDS();
+	PROF_DATA();
+}
+
+void CombCodeGen::writeExec()
+{
+	testEofUsed = false;
+	outLabelUsed = false;
+
+	out << 
+		"	{\n"
+		"	int _trans, _off";
+
+	if ( redFsm->anyRegCurStateRef() )
+		out << ", _ps";
+	if ( redFsm->anyConditions() )
+		out << ", _slen, _cond";
+	if ( redFsm->anyClassIntervals() )
+		out << ", _cls, _lower, _upper, _mid";
+	out << ";\n";
+
+	if ( redFsm->anyToStateActions() || 
+			redFsm->anyRegActions() || redFsm->anyFromStateActions() )
+	{
+		out << 
+			"	" << PTR_CONST() << ARRAY_TYPE(redFsm->maxActArrItem) << POINTER() << "_acts;\n"
+			"	" << UINT() << " _nacts;\n"; 
+	}
+
+	if ( redFsm->anyConditions() ) {
+		out << 
+			"	" << PTR_CONST() << WIDE_ALPH_TYPE() << POINTER() << "_keys;\n"
+			"	" << PTR_CONST() << ARRAY_TYPE(redFsm->maxCond) << POINTER() << "_conds;\n"
+			"	" << WIDE_ALPH_TYPE() << " _widec;\n";
+	}
+
+	out << "\n";
+
+	if ( !noEnd ) {
+		testEofUsed = true;
+		out << 
+			"	if ( " << P() << " == " << PE() << " )\n"
+			"		goto _test_eof;\n";
+	}
+
+	if ( redFsm->errState != 0 ) {
+		outLabelUsed = true;
+		out << 
+			"	if ( " << vCS() << " == " << redFsm->errState->id << " )\n"
+			"		goto _out;\n";
+	}
+
+	out << "_resume:\n" << PROF_STATE( vCS() );
+
+	if ( redFsm->anyFromStateActions() ) {
+		out <<
+			"	_acts = " << ARR_OFF( A(), FSA() + "[" + vCS() + "]" ) << ";\n"
+			"	_nacts = " << CAST(UINT()) << " *_acts++;\n"
+			"	while ( _nacts-- > 0 ) {\n"
+			"		switch ( *_acts++ ) {\n";
+			FROM_STATE_ACTION_SWITCH();
+			SWITCH_DEFAULT() <<
+			"		}\n"
+			"	}\n"
+			"\n";
+	}
+
+	if ( redFsm->anyConditions() )
+		COND_TRANSLATE();
+
+	LOCATE_TRANS();
+
+	if ( redFsm->anyEofTrans() )
+		out << "_eof_trans:\n";
+
+	if ( redFsm->anyRegCurStateRef() )
+		out << "	_ps = " << vCS() << ";\n";
+
+	out << PROF_TRANS( "_trans" );
+	out <<
+		"	" << vCS() << " = " << TT() << "[_trans];\n"
+		"\n";
+
+	if ( redFsm->anyRegActions() ) {
+		out <<
+			"	if ( " << TA() << "[_trans] == 0 )\n"
+			"		goto _again;\n"
+			"\n"
+			"	_acts = " << ARR_OFF( A(), TA() + "[_trans]" ) << ";\n"
+			"	_nacts = " << CAST(UINT()) << " *_acts++;\n"
+			"	while ( _nacts-- > 0 ) {\n"
+			"		switch ( *(_acts++) )\n		{\n";
+			ACTION_SWITCH();
+			SWITCH_DEFAULT() <<
+			"		}\n"
+			"	}\n"
+			"\n";
+	}
+
+	if ( redFsm->anyRegActions() || redFsm->anyActionGotos() || 
+			redFsm->anyActionCalls() || redFsm->anyActionRets() )
+		out << "_again:\n";
+
+	if ( redFsm->anyToStateActions() ) {
+		out <<
+			"	_acts = " << ARR_OFF( A(),  TSA() + "[" + vCS() + "]" ) << ";\n"
+			"	_nacts = " << CAST(UINT()) << " *_acts++;\n"
+			"	while ( _nacts-- > 0 ) {\n"
+			"		switch ( *_acts++ ) {\n";
+			TO_STATE_ACTION_SWITCH();
+			SWITCH_DEFAULT() <<
+			"		}\n"
+			"	}\n"
+			"\n";
+	}
+
+	if ( redFsm->errState != 0 ) {
+		outLabelUsed = true;
+		out << 
+			"	if ( " << vCS() << " == " << redFsm->errState->id << " )\n"
+			"		goto _out;\n";
+	}
+
+	if ( !noEnd ) {
+		out << 
+			"	if ( ++" << P() << " != " << PE() << " )\n"
+			"		goto _resume;\n";
+	}
+	else {
+		out << 
+			"	" << P() << " += 1;\n"
+			"	goto _resume;\n";
+	}
+
+	if ( testEofUsed )
+		out << "	_test_eof: {}\n";
+
+	if ( redFsm->anyEofTrans() || redFsm->anyEofActions() ) {
+		out << 
+			"	if ( " << P() << " == " << vEOF() << " )\n"
+			"	{\n";
+
+		if ( redFsm->anyEofTrans() ) {
+			out <<
+				"	if ( " << ET() << "[" << vCS() << "] > 0 ) {\n"
+				"		_trans = " << ET() << "[" << vCS() << "] - 1;\n"
+				"		goto _eof_trans;\n"
+				"	}\n";
+		}
+
+		if ( redFsm->anyEofActions() ) {
+			out <<
+				"	" << PTR_CONST() << ARRAY_TYPE(redFsm->maxActArrItem) << 
+						POINTER() << "__acts = " << 
+						ARR_OFF( A(), EA() + "[" + vCS() + "]" ) << ";\n"
+				"	" << UINT() << " __nacts = " << CAST(UINT()) << " *__acts++;\n"
+				"	while ( __nacts-- > 0 ) {\n"
+				"		switch ( *__acts++ ) {\n";
+				EOF_ACTION_SWITCH();
+				SWITCH_DEFAULT() <<
+				"		}\n"
+				"	}\n";
+		}
+
+		out <<
+			"	}\n"
+			"\n";
+	}
+
+	if ( outLabelUsed )
+		out << "	_out: {}\n";
+
+	out << "	}\n";
+}
@@ -0,0 +1,73 @@
+/*
+ *  Copyright 2010 Adrian Thurston <thurston@complang.org>
+ */
+
+/*  This file is part of Ragel.
+ *
+ *  Ragel is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ * 
+ *  Ragel is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ * 
+ *  You should have received a copy of the GNU General Public License
+ *  along with Ragel; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA 
+ */
+
+#ifndef _CDCOMB_H
+#define _CDCOMB_H
+
+#include <iostream>
+#include "cdflat.h"
+
+/* Forwards. */
+struct CodeGenData;
+
+/*
+ * CombCodeGen
+ *
+ * The rows of the flat tables are packed into shared next and check arrays
+ * by row displacement. Keys a state does not take its default transition on
+ * are left out of its row.
+ */
+class CombCodeGen : public FlatCodeGen
+{
+protected:
+	CombCodeGen( ostream &out ) : FsmCodeGen(out), FlatCodeGen(out) {}
+
+	std::ostream &COMB_BASE();
+	std::ostream &COMB_NEXT();
+	std::ostream &COMB_CHECK();
+	std::ostream &COMB_DEFAULTS();
+	void LOCATE_TRANS();
+
+	virtual void writeData();
+	virtual void writeExec();
+};
+
+/*
+ * CCombCodeGen
+ */
+struct CCombCodeGen
+	: public CombCodeGen, public CCodeGen
+{
+	CCombCodeGen( ostream &out ) : 
+		FsmCodeGen(out), CombCodeGen(out), CCodeGen(out) {}
+};
+
+/*
+ * DCombCodeGen
+ */
+struct DCombCodeGen
+	: public CombCodeGen, public DCodeGen
+{
+	DCombCodeGen( ostream &out ) : 
+		FsmCodeGen(out), CombCodeGen(out), DCodeGen(out) {}
+};
+
+#endif
@@ -173,7 +173,25 @@ void FFlatCodeGen::writeData()
 		"\n";
 	}
 
-	OPEN_ARRAY( WIDE_ALPH_TYPE(), K() );
+	if ( redFsm->anyClassIntervals() ) {
+		OPEN_ARRAY( ALPH_TYPE(), CLK() );
+		CLASS_KEYS();
+		CLOSE_ARRAY() <<
+		"\n";
+
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->numClasses), CC() );
+		CLASS_INTERVALS();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+	else if ( redFsm->anyCharClasses() ) {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->numClasses), CC() );
+		CHAR_CLASS();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+
+	OPEN_ARRAY( KEYS_TYPE(), K() );
 	KEYS();
 	CLOSE_ARRAY() <<
 	"\n";
@@ -183,15 +201,38 @@ void FFlatCodeGen::writeData()
 	CLOSE_ARRAY() <<
 	"\n";
 
-	OPEN_ARRAY( ARRAY_TYPE(redFsm->maxFlatIndexOffset), IO() );
-	FLAT_INDEX_OFFSET();
-	CLOSE_ARRAY() <<
-	"\n";
+	if ( redFsm->flatPaged ) {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->numPageRefs), PO() );
+		PAGE_OFFSETS();
+		CLOSE_ARRAY() <<
+		"\n";
 
-	OPEN_ARRAY( ARRAY_TYPE(redFsm->maxIndex), I() );
-	INDICIES();
-	CLOSE_ARRAY() <<
-	"\n";
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->flatPages.length()), PG() );
+		PAGES();
+		CLOSE_ARRAY() <<
+		"\n";
+
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxIndex), I() );
+		PAGE_INDICIES();
+		CLOSE_ARRAY() <<
+		"\n";
+
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxIndex), ID() );
+		INDEX_DEFAULTS();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+	else {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxFlatIndexOffset), IO() );
+		FLAT_INDEX_OFFSET();
+		CLOSE_ARRAY() <<
+		"\n";
+
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxIndex), I() );
+		INDICIES();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
 
 	OPEN_ARRAY( ARRAY_TYPE(redFsm->maxState), TT() );
 	TRANS_TARGS();
@@ -234,6 +275,7 @@ void FFlatCodeGen::writeData()
 	}
 
 	STATE_IDS();
+	PROF_DATA();
 }
 
 void FFlatCodeGen::writeExec()
@@ -253,12 +295,20 @@ void FFlatCodeGen::writeExec()
 
 	if ( redFsm->anyConditions() )
 		out << ", _cond";
+	if ( redFsm->anyCharClasses() )
+		out << ", _cls";
+	if ( redFsm->anyClassIntervals() )
+		out << ", _lower, _upper, _mid";
 
 	out << ";\n";
 
 	out <<
-		"	" << PTR_CONST() << WIDE_ALPH_TYPE() << POINTER() << "_keys;\n"
-		"	" << PTR_CONST() << ARRAY_TYPE(redFsm->maxIndex) << POINTER() << "_inds;\n";
+		"	" << PTR_CONST() << KEYS_TYPE() << POINTER() << "_keys;\n";
+
+	if ( redFsm->flatPaged )
+		out << "	" << UINT() << " _off;\n";
+	else
+		out << "	" << PTR_CONST() << ARRAY_TYPE(redFsm->maxIndex) << POINTER() << "_inds;\n";
 
 	if ( redFsm->anyConditions() ) {
 		out << 
@@ -280,7 +330,7 @@ void FFlatCodeGen::writeExec()
 			"		goto _out;\n";
 	}
 
-	out << "_resume:\n";
+	out << "_resume:\n" << PROF_STATE( vCS() );
 
 	if ( redFsm->anyFromStateActions() ) {
 		out <<
@@ -302,6 +352,7 @@ void FFlatCodeGen::writeExec()
 	if ( redFsm->anyRegCurStateRef() )
 		out << "	_ps = " << vCS() << ";\n";
 
+	out << PROF_TRANS( "_trans" );
 	out << 
 		"	" << vCS() << " = " << TT() << "[_trans];\n\n";
 
@@ -174,6 +174,7 @@ void FGotoCodeGen::writeData()
 	}
 
 	STATE_IDS();
+	PROF_DATA();
 }
 
 void FGotoCodeGen::writeExec()
@@ -203,7 +204,7 @@ void FGotoCodeGen::writeExec()
 			"		goto _out;\n";
 	}
 
-	out << "_resume:\n";
+	out << "_resume:\n" << PROF_STATE( vCS() );
 
 	if ( redFsm->anyFromStateActions() ) {
 		out <<
@@ -269,7 +270,8 @@ void FGotoCodeGen::writeExec()
 
 			for ( RedStateList::Iter st = redFsm->stateList; st.lte(); st++ ) {
 				if ( st->eofTrans != 0 )
-					out << "	case " << st->id << ": goto tr" << st->eofTrans->id << ";\n";
+					out << "	case " << st->id << ": " << 
+							PROF_EOF( st->eofTrans ) << "goto tr" << st->eofTrans->id << ";\n";
 			}
 
 			SWITCH_DEFAULT() <<
@@ -25,6 +25,9 @@
 #include "cdflat.h"
 #include "redfsm.h"
 #include "gendata.h"
+#include <sstream>
+
+using std::ostringstream;
 
 std::ostream &FlatCodeGen::TO_STATE_ACTION( RedStateAp *state )
 {
@@ -164,7 +167,7 @@ std::ostream &FlatCodeGen::KEY_SPANS()
 	for ( RedStateList::Iter st = redFsm->stateList; st.lte(); st++ ) {
 		/* Write singles length. */
 		unsigned long long span = 0;
-		if ( st->transList != 0 )
+		if ( st->transList != 0 || st->pageList != 0 )
 			span = keyOps->span( st->lowKey, st->highKey );
 		out << span;
 		if ( !st.last() ) {
@@ -343,9 +346,16 @@ std::ostream &FlatCodeGen::KEYS()
 	out << '\t';
 	int totalTrans = 0;
 	for ( RedStateList::Iter st = redFsm->stateList; st.lte(); st++ ) {
-		/* Emit just low key and high key. */
-		out << KEY( st->lowKey ) << ", ";
-		out << KEY( st->highKey ) << ", ";
+		/* Emit just low key and high key. These are classes when the keys
+		 * are mapped. */
+		if ( redFsm->anyCharClasses() ) {
+			out << st->lowKey.getVal() << ", ";
+			out << st->highKey.getVal() << ", ";
+		}
+		else {
+			out << KEY( st->lowKey ) << ", ";
+			out << KEY( st->highKey ) << ", ";
+		}
 		if ( ++totalTrans % IALL == 0 )
 			out << "\n\t";
 	}
@@ -356,6 +366,91 @@ std::ostream &FlatCodeGen::KEYS()
 	return out;
 }
 
+std::ostream &FlatCodeGen::CHAR_CLASS()
+{
+	out << '\t';
+	unsigned long long span = keyOps->span( redFsm->classLowKey, redFsm->classHighKey );
+	for ( unsigned long long pos = 0; pos < span; pos++ ) {
+		out << redFsm->charClass[pos];
+		if ( pos < span-1 ) {
+			out << ", ";
+			if ( (pos+1) % IALL == 0 )
+				out << "\n\t";
+		}
+	}
+	out << "\n";
+	return out;
+}
+
+/* Expression for the class of the current key. */
+string FlatCodeGen::CLASS_OF_KEY()
+{
+	ostringstream ret;
+	if ( redFsm->classLowKey != keyOps->minKey || redFsm->classHighKey != keyOps->maxKey ) {
+		ret << GET_KEY() << " < " << KEY( redFsm->classLowKey ) << " || " <<
+				GET_KEY() << " > " << KEY( redFsm->classHighKey ) << " ? " <<
+				redFsm->numClasses << " :\n		";
+	}
+	ret << CC() << "[" << GET_KEY() << " - " << KEY( redFsm->classLowKey ) << "]";
+	return ret.str();
+}
+
+std::ostream &FlatCodeGen::CLASS_KEYS()
+{
+	out << "\t";
+	for ( long i = 0; i < redFsm->numClassInts; i++ ) {
+		out << KEY( redFsm->classIntKeys[i] );
+		if ( i < redFsm->numClassInts - 1 ) {
+			out << ", ";
+			if ( (i+1) % IALL == 0 )
+				out << "\n\t";
+		}
+	}
+	out << "\n";
+	return out;
+}
+
+std::ostream &FlatCodeGen::CLASS_INTERVALS()
+{
+	out << "\t";
+	for ( long i = 0; i < redFsm->numClassInts; i++ ) {
+		out << redFsm->classIntClasses[i];
+		if ( i < redFsm->numClassInts - 1 ) {
+			out << ", ";
+			if ( (i+1) % IALL == 0 )
+				out << "\n\t";
+		}
+	}
+	out << "\n";
+	return out;
+}
+
+/* Assigns the class of the key to _cls by a binary search of the class
+ * intervals, for alphabets too wide for a class map. The first interval
+ * starts at the lowest key. */
+void FlatCodeGen::CLASS_SEARCH()
+{
+	out <<
+		"	_lower = 1;\n"
+		"	_upper = " << redFsm->numClassInts << ";\n"
+		"	while ( _lower < _upper ) {\n"
+		"		_mid = _lower + ((_upper - _lower) >> 1);\n"
+		"		if ( " << GET_KEY() << " < " << CLK() << "[_mid] )\n"
+		"			_upper = _mid;\n"
+		"		else\n"
+		"			_lower = _mid + 1;\n"
+		"	}\n"
+		"	_cls = " << CC() << "[_lower - 1];\n"
+		"\n";
+}
+
+string FlatCodeGen::KEYS_TYPE()
+{
+	if ( redFsm->anyCharClasses() )
+		return ARRAY_TYPE( redFsm->numClasses );
+	return WIDE_ALPH_TYPE();
+}
+
 std::ostream &FlatCodeGen::INDICIES()
 {
 	int totalTrans = 0;
@@ -385,6 +480,84 @@ std::ostream &FlatCodeGen::INDICIES()
 	return out;
 }
 
+std::ostream &FlatCodeGen::PAGE_OFFSETS()
+{
+	out << "\t";
+	int totalStateNum = 0;
+	long curPageOffset = 0;
+	for ( RedStateList::Iter st = redFsm->stateList; st.lte(); st++ ) {
+		out << curPageOffset;
+		if ( !st.last() ) {
+			out << ", ";
+			if ( ++totalStateNum % IALL == 0 )
+				out << "\n\t";
+		}
+
+		if ( st->pageList != 0 ) {
+			unsigned long long span = keyOps->span( st->lowKey, st->highKey );
+			curPageOffset += ( span + (1ULL << redFsm->pageBits) - 1 ) >> redFsm->pageBits;
+		}
+	}
+	out << "\n";
+	return out;
+}
+
+std::ostream &FlatCodeGen::PAGES()
+{
+	out << "\t";
+	int totalPages = 0;
+	for ( RedStateList::Iter st = redFsm->stateList; st.lte(); st++ ) {
+		if ( st->pageList != 0 ) {
+			unsigned long long span = keyOps->span( st->lowKey, st->highKey );
+			unsigned long long numPages = ( span + (1ULL << redFsm->pageBits) - 1 ) >> redFsm->pageBits;
+			for ( unsigned long long page = 0; page < numPages; page++ ) {
+				out << st->pageList[page] << ", ";
+				if ( ++totalPages % IALL == 0 )
+					out << "\n\t";
+			}
+		}
+	}
+
+	/* Output one last number so we don't have to figure out when the last
+	 * entry is and avoid writing a comma. */
+	out << 0 << "\n";
+	return out;
+}
+
+std::ostream &FlatCodeGen::PAGE_INDICIES()
+{
+	out << "\t";
+	int totalTrans = 0;
+	for ( RedFlatPageVect::Iter page = redFsm->flatPages; page.lte(); page++ ) {
+		for ( int pos = 0; pos < (*page)->size; pos++ ) {
+			out << (*page)->transList[pos]->id;
+			if ( !page.last() || pos < (*page)->size - 1 ) {
+				out << ", ";
+				if ( ++totalTrans % IALL == 0 )
+					out << "\n\t";
+			}
+		}
+	}
+	out << "\n";
+	return out;
+}
+
+std::ostream &FlatCodeGen::INDEX_DEFAULTS()
+{
+	out << "\t";
+	int totalStateNum = 0;
+	for ( RedStateList::Iter st = redFsm->stateList; st.lte(); st++ ) {
+		out << ( st->defTrans != 0 ? st->defTrans->id : 0 );
+		if ( !st.last() ) {
+			out << ", ";
+			if ( ++totalStateNum % IALL == 0 )
+				out << "\n\t";
+		}
+	}
+	out << "\n";
+	return out;
+}
+
 std::ostream &FlatCodeGen::TRANS_TARGS()
 {
 	/* Transitions must be written ordered by their id. */
@@ -441,15 +614,49 @@ std::ostream &FlatCodeGen::TRANS_ACTIONS()
 
 void FlatCodeGen::LOCATE_TRANS()
 {
+	if ( redFsm->flatPaged ) {
+		unsigned long long pageMask = (1ULL << redFsm->pageBits) - 1;
+		out <<
+			"	_keys = " << ARR_OFF( K(), "(" + vCS() + "<<1)" ) << ";\n"
+			"	_slen = " << SP() << "[" << vCS() << "];\n"
+			"	if ( _slen > 0 && _keys[0] <= " << GET_WIDE_KEY() << " &&\n"
+			"			" << GET_WIDE_KEY() << " <= _keys[1] ) {\n"
+			"		_off = " << CAST(UINT()) << "(" << GET_WIDE_KEY() << " - _keys[0]);\n"
+			"		_trans = " << I() << "[(" << CAST(UINT()) << PG() << "[" << PO() << "[" << vCS() <<
+					"] + (_off >> " << redFsm->pageBits << ")] << " << redFsm->pageBits <<
+					") + (_off & " << pageMask << ")];\n"
+			"	}\n"
+			"	else\n"
+			"		_trans = " << ID() << "[" << vCS() << "];\n"
+			"\n";
+		return;
+	}
+
 	out <<
 		"	_keys = " << ARR_OFF( K(), "(" + vCS() + "<<1)" ) << ";\n"
 		"	_inds = " << ARR_OFF( I(), IO() + "[" + vCS() + "]" ) << ";\n"
-		"\n"
-		"	_slen = " << SP() << "[" << vCS() << "];\n"
-		"	_trans = _inds[ _slen > 0 && _keys[0] <=" << GET_WIDE_KEY() << " &&\n"
-		"		" << GET_WIDE_KEY() << " <= _keys[1] ?\n"
-		"		" << GET_WIDE_KEY() << " - _keys[0] : _slen ];\n"
 		"\n";
+
+	if ( redFsm->anyCharClasses() ) {
+		if ( redFsm->anyClassIntervals() )
+			CLASS_SEARCH();
+		else
+			out << "	_cls = " << CLASS_OF_KEY() << ";\n";
+
+		out <<
+			"	_slen = " << SP() << "[" << vCS() << "];\n"
+			"	_trans = _inds[ _slen > 0 && _keys[0] <= _cls && _cls <= _keys[1] ?\n"
+			"		_cls - _keys[0] : _slen ];\n"
+			"\n";
+	}
+	else {
+		out <<
+			"	_slen = " << SP() << "[" << vCS() << "];\n"
+			"	_trans = _inds[ _slen > 0 && _keys[0] <=" << GET_WIDE_KEY() << " &&\n"
+			"		" << GET_WIDE_KEY() << " <= _keys[1] ?\n"
+			"		" << GET_WIDE_KEY() << " - _keys[0] : _slen ];\n"
+			"\n";
+	}
 }
 
 void FlatCodeGen::GOTO( ostream &ret, int gotoDest, bool inFinish )
@@ -570,7 +777,25 @@ void FlatCodeGen::writeData()
 		"\n";
 	}
 
-	OPEN_ARRAY( WIDE_ALPH_TYPE(), K() );
+	if ( redFsm->anyClassIntervals() ) {
+		OPEN_ARRAY( ALPH_TYPE(), CLK() );
+		CLASS_KEYS();
+		CLOSE_ARRAY() <<
+		"\n";
+
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->numClasses), CC() );
+		CLASS_INTERVALS();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+	else if ( redFsm->anyCharClasses() ) {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->numClasses), CC() );
+		CHAR_CLASS();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+
+	OPEN_ARRAY( KEYS_TYPE(), K() );
 	KEYS();
 	CLOSE_ARRAY() <<
 	"\n";
@@ -580,15 +805,38 @@ void FlatCodeGen::writeData()
 	CLOSE_ARRAY() <<
 	"\n";
 
-	OPEN_ARRAY( ARRAY_TYPE(redFsm->maxFlatIndexOffset), IO() );
-	FLAT_INDEX_OFFSET();
-	CLOSE_ARRAY() <<
-	"\n";
+	if ( redFsm->flatPaged ) {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->numPageRefs), PO() );
+		PAGE_OFFSETS();
+		CLOSE_ARRAY() <<
+		"\n";
 
-	OPEN_ARRAY( ARRAY_TYPE(redFsm->maxIndex), I() );
-	INDICIES();
-	CLOSE_ARRAY() <<
-	"\n";
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->flatPages.length()), PG() );
+		PAGES();
+		CLOSE_ARRAY() <<
+		"\n";
+
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxIndex), I() );
+		PAGE_INDICIES();
+		CLOSE_ARRAY() <<
+		"\n";
+
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxIndex), ID() );
+		INDEX_DEFAULTS();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+	else {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxFlatIndexOffset), IO() );
+		FLAT_INDEX_OFFSET();
+		CLOSE_ARRAY() <<
+		"\n";
+
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxIndex), I() );
+		INDICIES();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
 
 	OPEN_ARRAY( ARRAY_TYPE(redFsm->maxState), TT() );
 	TRANS_TARGS();
@@ -631,6 +879,7 @@ void FlatCodeGen::writeData()
 	}
 
 	STATE_IDS();
+	PROF_DATA();
 }
 
 void FlatCodeGen::COND_TRANSLATE()
@@ -692,6 +941,10 @@ void FlatCodeGen::writeExec()
 
 	if ( redFsm->anyConditions() )
 		out << ", _cond";
+	if ( redFsm->anyCharClasses() )
+		out << ", _cls";
+	if ( redFsm->anyClassIntervals() )
+		out << ", _lower, _upper, _mid";
 	out << ";\n";
 
 	if ( redFsm->anyToStateActions() || 
@@ -703,8 +956,12 @@ void FlatCodeGen::writeExec()
 	}
 
 	out <<
-		"	" << PTR_CONST() << WIDE_ALPH_TYPE() << POINTER() << "_keys;\n"
-		"	" << PTR_CONST() << ARRAY_TYPE(redFsm->maxIndex) << POINTER() << "_inds;\n";
+		"	" << PTR_CONST() << KEYS_TYPE() << POINTER() << "_keys;\n";
+
+	if ( redFsm->flatPaged )
+		out << "	" << UINT() << " _off;\n";
+	else
+		out << "	" << PTR_CONST() << ARRAY_TYPE(redFsm->maxIndex) << POINTER() << "_inds;\n";
 
 	if ( redFsm->anyConditions() ) {
 		out << 
@@ -728,7 +985,7 @@ void FlatCodeGen::writeExec()
 			"		goto _out;\n";
 	}
 
-	out << "_resume:\n";
+	out << "_resume:\n" << PROF_STATE( vCS() );
 
 	if ( redFsm->anyFromStateActions() ) {
 		out <<
@@ -754,6 +1011,7 @@ void FlatCodeGen::writeExec()
 	if ( redFsm->anyRegCurStateRef() )
 		out << "	_ps = " << vCS() << ";\n";
 
+	out << PROF_TRANS( "_trans" );
 	out <<
 		"	" << vCS() << " = " << TT() << "[_trans];\n"
 		"\n";
@@ -48,6 +48,16 @@ protected:
 	std::ostream &EOF_ACTION_SWITCH();
 	std::ostream &ACTION_SWITCH();
 	std::ostream &KEYS();
+	std::ostream &CHAR_CLASS();
+	std::ostream &CLASS_KEYS();
+	std::ostream &CLASS_INTERVALS();
+	std::ostream &PAGE_OFFSETS();
+	std::ostream &PAGES();
+	std::ostream &PAGE_INDICIES();
+	std::ostream &INDEX_DEFAULTS();
+	string KEYS_TYPE();
+	string CLASS_OF_KEY();
+	void CLASS_SEARCH();
 	std::ostream &INDICIES();
 	std::ostream &FLAT_INDEX_OFFSET();
 	std::ostream &KEY_SPANS();
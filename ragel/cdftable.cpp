@@ -50,8 +50,9 @@ void FTabCodeGen::calcIndexSize()
 			sizeWithoutInds += arrayTypeSize(redFsm->maxActListId) * totalIndex;
 	}
 
-	/* If using indicies reduces the size, use them. */
-	useIndicies = sizeWithInds < sizeWithoutInds;
+	/* If using indicies reduces the size, use them. Instrumented builds
+	 * always do, so the transition counters are indexed by id. */
+	useIndicies = instrumentOpt || sizeWithInds < sizeWithoutInds;
 }
 
 std::ostream &FTabCodeGen::TO_STATE_ACTION( RedStateAp *state )
@@ -288,6 +289,7 @@ void FTabCodeGen::writeData()
 	}
 
 	STATE_IDS();
+	PROF_DATA();
 }
 
 void FTabCodeGen::writeExec()
@@ -326,7 +328,7 @@ void FTabCodeGen::writeExec()
 			"		goto _out;\n";
 	}
 
-	out << "_resume:\n";
+	out << "_resume:\n" << PROF_STATE( vCS() );
 
 	if ( redFsm->anyFromStateActions() ) {
 		out <<
@@ -353,6 +355,7 @@ void FTabCodeGen::writeExec()
 	if ( redFsm->anyRegCurStateRef() )
 		out << "	_ps = " << vCS() << ";\n";
 
+	out << PROF_TRANS( "_trans" );
 	out <<
 		"	" << vCS() << " = " << TT() << "[_trans];\n"
 		"\n";
@@ -25,12 +25,21 @@
 #include "cdgoto.h"
 #include "redfsm.h"
 #include "bstmap.h"
+#include "mergesort.h"
 #include "gendata.h"
+#include <sstream>
+
+using std::ostringstream;
 
 /* Emit the goto to take for a given transition. */
 std::ostream &GotoCodeGen::TRANS_GOTO( RedTransAp *trans, int level )
 {
-	out << TABS(level) << "goto tr" << trans->id << ";";
+	if ( instrumentOpt ) {
+		out << TABS(level) << "{" << PCT() << "[" << trans->id << "]++; " <<
+				"goto tr" << trans->id << ";}";
+	}
+	else
+		out << TABS(level) << "goto tr" << trans->id << ";";
 	return out;
 }
 
@@ -111,9 +120,14 @@ void GotoCodeGen::GOTO_HEADER( RedStateAp *state )
 
 void GotoCodeGen::emitSingleSwitch( RedStateAp *state )
 {
-	/* Load up the singles. */
-	int numSingles = state->outSingle.length();
-	RedTransEl *data = state->outSingle.data;
+	/* Load up the singles, less those already tested for by HOT_TRANS. */
+	RedTransList singles;
+	for ( RedTransList::Iter rtel = state->outSingle; rtel.lte(); rtel++ ) {
+		if ( hotTrans.find( rtel->value ) == 0 )
+			singles.append( *rtel );
+	}
+	int numSingles = singles.length();
+	RedTransEl *data = singles.data;
 
 	if ( numSingles == 1 ) {
 		/* If there is a single single key then write it out as an if. */
@@ -228,6 +242,328 @@ void GotoCodeGen::emitRangeBSearch( RedStateAp *state, int level, int low, int h
 	}
 }
 
+/* The most ranges a skip loop will test in one pass over a vector. */
+#define SKIP_MAX_RANGES 4
+
+/* Returns true if the state loops on itself over a class of bytes that can
+ * be skipped ahead of the dispatch. Fills ranges with either the bytes of the
+ * class or the bytes that leave it, whichever needs fewer ranges. */
+bool GotoCodeGen::skipLoopRanges( RedStateAp *state, Vector<SkipRange> &ranges,
+		bool &inClass )
+{
+	/* Instrumented builds count every transition. */
+	if ( hostLang->lang != HostLang::C || noEnd || getKeyExpr != 0 ||
+			keyOps->alphType->size != 1 || instrumentOpt )
+		return false;
+
+	if ( state == redFsm->errState || state->stateCondList.length() > 0 ||
+			state->toStateAction != 0 || state->fromStateAction != 0 ||
+			!skipLoopAllowed( state ) )
+		return false;
+
+	/* Classify every byte, indexed by its unsigned value. */
+	bool loops[256];
+	bool anyLoop = false;
+	for ( int b = 0; b < 256; b++ ) {
+		Key key = keyOps->isSigned ? (long)(signed char)b : (long)b;
+
+		/* Singles are tested ahead of the ranges, so they win. */
+		RedTransAp *trans = state->defTrans;
+		for ( RedTransList::Iter rtel = state->outRange; rtel.lte(); rtel++ ) {
+			if ( rtel->lowKey <= key && key <= rtel->highKey )
+				trans = rtel->value;
+		}
+		for ( RedTransList::Iter rtel = state->outSingle; rtel.lte(); rtel++ ) {
+			if ( rtel->lowKey == key )
+				trans = rtel->value;
+		}
+
+		loops[b] = trans != 0 && trans->targ == state && trans->action == 0;
+		anyLoop = anyLoop || loops[b];
+	}
+
+	if ( !anyLoop )
+		return false;
+
+	Vector<SkipRange> inRanges, outRanges;
+	for ( int b = 0; b < 256; ) {
+		SkipRange range;
+		range.low = b;
+		while ( b < 256 && loops[b] == loops[range.low] )
+			b += 1;
+		range.high = b - 1;
+		if ( loops[range.low] )
+			inRanges.append( range );
+		else
+			outRanges.append( range );
+	}
+
+	/* Prefer testing for the bytes that leave the class. */
+	inClass = outRanges.length() == 0 || inRanges.length() < outRanges.length();
+	ranges = inClass ? inRanges : outRanges;
+	return ranges.length() <= SKIP_MAX_RANGES;
+}
+
+/* Membership test of an unsigned byte or byte vector in a list of ranges. */
+string GotoCodeGen::SKIP_TEST( Vector<SkipRange> &ranges, bool vect, const char *v )
+{
+	ostringstream ret;
+	for ( Vector<SkipRange>::Iter r = ranges; r.lte(); r++ ) {
+		if ( r.pos() > 0 )
+			ret << " | ";
+		if ( r->low == r->high )
+			ret << "(" << v << " == " << r->low << ")";
+		else if ( r->low == 0 )
+			ret << "(" << v << " <= " << r->high << ")";
+		else if ( r->high == 255 )
+			ret << "(" << v << " >= " << r->low << ")";
+		else {
+			/* Wrap below the low end so a single compare does. */
+			ret << "(" << ( vect ? "(" : "(unsigned char)(" ) << v << " - " << 
+					r->low << ") <= " << r->high - r->low << ")";
+		}
+	}
+	return ret.str();
+}
+
+/* Scan width bytes at a time with GCC vector extensions. The compiler turns
+ * the compares into SSE2 or AVX2 instructions, and the movemask builtin
+ * finds the first byte that leaves the class. */
+void GotoCodeGen::SKIP_VECTOR( Vector<SkipRange> &ranges, bool inClass,
+		int width, const char *movemask )
+{
+	out <<
+		"	{\n"
+		"		typedef unsigned char _sv __attribute__((vector_size(" << width << ")));\n"
+		"		typedef char _sm __attribute__((vector_size(" << width << ")));\n"
+		"		_sv _v;\n"
+		"		unsigned int _m;\n"
+		"		while ( " << PE() << " - " << P() << " >= " << width << " ) {\n"
+		"			__builtin_memcpy( &_v, " << P() << ", " << width << " );\n"
+		"			_m = " << ( inClass ? "~" : "" ) << "(unsigned int)" << movemask << 
+				"( (_sm)( " << SKIP_TEST( ranges, true, "_v" ) << " ) )";
+	if ( inClass && width < 32 )
+		out << " & 0x" << std::hex << ( ( 1 << width ) - 1 ) << std::dec;
+	out << ";\n"
+		"			if ( _m != 0 ) {\n"
+		"				" << P() << " += __builtin_ctz( _m );\n"
+		"				break;\n"
+		"			}\n"
+		"			" << P() << " += " << width << ";\n"
+		"		}\n"
+		"	}\n";
+}
+
+/* Move p past a run of bytes that a state consumes by looping on itself
+ * without actions, so the dispatch only sees the byte that leaves. */
+void GotoCodeGen::SKIP_LOOP( RedStateAp *state )
+{
+	Vector<SkipRange> ranges;
+	bool inClass;
+	if ( !skipLoopRanges( state, ranges, inClass ) )
+		return;
+
+	out << "#if defined(__AVX2__) && ( defined(__clang__) || __GNUC__ >= 5 )\n";
+	SKIP_VECTOR( ranges, inClass, 32, "__builtin_ia32_pmovmskb256" );
+	out << "#endif\n";
+	out << "#if defined(__SSE2__) && ( defined(__clang__) || __GNUC__ >= 5 )\n";
+	SKIP_VECTOR( ranges, inClass, 16, "__builtin_ia32_pmovmskb128" );
+	out << "#endif\n";
+
+	string c = string("((unsigned char)") + GET_KEY() + ")";
+	out <<
+		"	while ( " << P() << " != " << PE() << " && " << ( inClass ? "" : "!" ) << 
+				"( " << SKIP_TEST( ranges, false, c.c_str() ) << " ) )\n"
+		"		" << P() << " += 1;\n"
+		"	if ( " << P() << " == " << PE() << " )\n"
+		"		" << SKIP_LOOP_EOF( state ) << "\n";
+}
+
+bool GotoCodeGen::skipLoopAllowed( RedStateAp *state )
+{
+	return true;
+}
+
+string GotoCodeGen::SKIP_LOOP_EOF( RedStateAp *state )
+{
+	return "goto _test_eof;";
+}
+
+/* A transition is tested for ahead of the search when it is taken at least
+ * once in HOT_MIN_SHARE times, up to HOT_MAX_RANGES key ranges per state. */
+#define HOT_MIN_SHARE 8
+#define HOT_MAX_RANGES 4
+
+struct HotTrans
+{
+	long long count;
+	RedTransAp *trans;
+};
+
+struct CmpHotTrans
+{
+	static int compare( const HotTrans &t1, const HotTrans &t2 )
+	{
+		if ( t1.count > t2.count )
+			return -1;
+		else if ( t1.count < t2.count )
+			return 1;
+		return 0;
+	}
+};
+
+/* Append a range, joining it to the last if they are next to each other. */
+static void appendHotRange( RedTransList &ranges, const RedTransEl &el )
+{
+	if ( ranges.length() > 0 ) {
+		RedTransEl &last = ranges[ranges.length()-1];
+		if ( last.highKey < keyOps->maxKey ) {
+			Key next = last.highKey;
+			next.increment();
+			if ( next == el.lowKey ) {
+				last.highKey = el.highKey;
+				return;
+			}
+		}
+	}
+	ranges.append( el );
+}
+
+/* Collect the keys a state takes a transition on as ascending, disjoint
+ * ranges. A range may have been extended over singles that go elsewhere.
+ * Those are tested first by the search, so they are cut out here. */
+void GotoCodeGen::hotRanges( RedStateAp *state, RedTransAp *trans,
+		RedTransList &ranges )
+{
+	RedTransList pieces;
+	for ( RedTransList::Iter rtel = state->outRange; rtel.lte(); rtel++ ) {
+		if ( rtel->value != trans )
+			continue;
+
+		Key low = rtel->lowKey;
+		bool more = true;
+		for ( RedTransList::Iter sel = state->outSingle; more && sel.lte(); sel++ ) {
+			if ( sel->value == trans || sel->lowKey < low || rtel->highKey < sel->lowKey )
+				continue;
+
+			if ( low < sel->lowKey ) {
+				Key high = sel->lowKey;
+				high.decrement();
+				pieces.append( RedTransEl( low, high, trans ) );
+			}
+
+			if ( sel->lowKey == rtel->highKey )
+				more = false;
+			else {
+				low = sel->lowKey;
+				low.increment();
+			}
+		}
+
+		if ( more )
+			pieces.append( RedTransEl( low, rtel->highKey, trans ) );
+	}
+
+	/* Merge in the transition's own singles. Both lists are in key order. */
+	int pos = 0;
+	for ( RedTransList::Iter sel = state->outSingle; sel.lte(); sel++ ) {
+		if ( sel->value == trans ) {
+			while ( pos < pieces.length() && pieces[pos].lowKey < sel->lowKey )
+				appendHotRange( ranges, pieces[pos++] );
+			appendHotRange( ranges, *sel );
+		}
+	}
+	while ( pos < pieces.length() )
+		appendHotRange( ranges, pieces[pos++] );
+}
+
+string GotoCodeGen::HOT_TEST( RedStateAp *state, RedTransList &ranges )
+{
+	/* With conditions the keys reach beyond the alphabet, so the limits of
+	 * the alphabet still need testing. */
+	bool limits = state->stateCondVect.length() == 0;
+
+	ostringstream ret;
+	for ( RedTransList::Iter rtel = ranges; rtel.lte(); rtel++ ) {
+		if ( !rtel.first() )
+			ret << " || ";
+
+		bool limitLow = limits && rtel->lowKey == keyOps->minKey;
+		bool limitHigh = limits && rtel->highKey == keyOps->maxKey;
+		if ( rtel->lowKey == rtel->highKey ) {
+			ret << GET_WIDE_KEY(state) << " == " << WIDE_KEY(state, rtel->lowKey);
+		}
+		else if ( limitLow ) {
+			ret << GET_WIDE_KEY(state) << " <= " << WIDE_KEY(state, rtel->highKey);
+		}
+		else if ( limitHigh ) {
+			ret << WIDE_KEY(state, rtel->lowKey) << " <= " << GET_WIDE_KEY(state);
+		}
+		else {
+			ret << "( " << WIDE_KEY(state, rtel->lowKey) << " <= " << 
+					GET_WIDE_KEY(state) << " && " << GET_WIDE_KEY(state) << " <= " << 
+					WIDE_KEY(state, rtel->highKey) << " )";
+		}
+	}
+	return ret.str();
+}
+
+/* With a profile, test for the transitions a state takes most often ahead of
+ * the switch and binary search, most taken first. Their singles are left out
+ * of the switch. The binary search follows unchanged. In C, a transition
+ * taken more often than not is marked as the expected outcome. */
+void GotoCodeGen::HOT_TRANS( RedStateAp *state )
+{
+	hotTrans.empty();
+	if ( !redFsm->profiled || state->profCount == 0 || 
+			hostLang->lang == HostLang::Go ||
+			state->outSingle.length() + state->outRange.length() < 2 )
+		return;
+
+	RedTransSet stateTransSet;
+	for ( RedTransList::Iter rtel = state->outSingle; rtel.lte(); rtel++ )
+		stateTransSet.insert( rtel->value );
+	for ( RedTransList::Iter rtel = state->outRange; rtel.lte(); rtel++ )
+		stateTransSet.insert( rtel->value );
+
+	Vector<HotTrans> hot;
+	for ( RedTransSet::Iter trans = stateTransSet; trans.lte(); trans++ ) {
+		HotTrans ht;
+		ht.count = redFsm->profEstimate( state, *trans );
+		ht.trans = *trans;
+		if ( ht.count > 0 && ht.count * HOT_MIN_SHARE >= state->profCount )
+			hot.append( ht );
+	}
+
+	MergeSort<HotTrans, CmpHotTrans> mergeSort;
+	mergeSort.sort( hot.data, hot.length() );
+
+	int numRanges = 0;
+	for ( Vector<HotTrans>::Iter ht = hot; ht.lte(); ht++ ) {
+		RedTransList ranges;
+		hotRanges( state, ht->trans, ranges );
+		numRanges += ranges.length();
+		if ( numRanges > HOT_MAX_RANGES )
+			break;
+
+		string test = HOT_TEST( state, ranges );
+		if ( hostLang->lang == HostLang::C && ht->count * 2 > state->profCount ) {
+			out <<
+				"#if defined(__GNUC__)\n"
+				"	if ( __builtin_expect( " << test << ", 1 ) )\n"
+				"#else\n"
+				"	if ( " << test << " )\n"
+				"#endif\n"
+				"		";
+		}
+		else {
+			out << "	if ( " << test << " )\n		";
+		}
+		TRANS_GOTO( ht->trans, 0 ) << "\n";
+		hotTrans.insert( ht->trans );
+	}
+}
+
 void GotoCodeGen::STATE_GOTO_ERROR()
 {
 	/* Label the state and bail immediately. */
@@ -355,12 +691,16 @@ std::ostream &GotoCodeGen::STATE_GOTOS()
 		else {
 			/* Writing code above state gotos. */
 			GOTO_HEADER( st );
+			SKIP_LOOP( st );
 
 			if ( st->stateCondVect.length() > 0 ) {
 				out << "	_widec = " << GET_KEY() << ";\n";
 				emitCondBSearch( st, 1, 0, st->stateCondVect.length() - 1 );
 			}
 
+			/* Most taken transitions first. */
+			HOT_TRANS( st );
+
 			/* Try singles. */
 			if ( st->outSingle.length() > 0 )
 				emitSingleSwitch( st );
@@ -655,6 +995,7 @@ void GotoCodeGen::writeData()
 	}
 
 	STATE_IDS();
+	PROF_DATA();
 }
 
 void GotoCodeGen::writeExec()
@@ -694,7 +1035,7 @@ void GotoCodeGen::writeExec()
 			"		goto _out;\n";
 	}
 
-	out << "_resume:\n";
+	out << "_resume:\n" << PROF_STATE( vCS() );
 
 	if ( redFsm->anyFromStateActions() ) {
 		out <<
@@ -768,7 +1109,8 @@ void GotoCodeGen::writeExec()
 
 			for ( RedStateList::Iter st = redFsm->stateList; st.lte(); st++ ) {
 				if ( st->eofTrans != 0 )
-					out << "	case " << st->id << ": goto tr" << st->eofTrans->id << ";\n";
+					out << "	case " << st->id << ": " << 
+							PROF_EOF( st->eofTrans ) << "goto tr" << st->eofTrans->id << ";\n";
 			}
 
 			SWITCH_DEFAULT() <<
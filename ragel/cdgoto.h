@@ -34,6 +34,12 @@ struct RedTransAp;
 struct RedStateAp;
 struct GenStateCond;
 
+/* A range of byte values, compared unsigned, used by the skip loops. */
+struct SkipRange
+{
+	int low, high;
+};
+
 /*
  * Goto driven fsm.
  */
@@ -78,6 +84,22 @@ public:
 	void emitSingleSwitch( RedStateAp *state );
 	void emitRangeBSearch( RedStateAp *state, int level, int low, int high );
 
+	/* Scanning over runs of a state's self loop. */
+	bool skipLoopRanges( RedStateAp *state, Vector<SkipRange> &ranges, bool &inClass );
+	string SKIP_TEST( Vector<SkipRange> &ranges, bool vect, const char *v );
+	void SKIP_VECTOR( Vector<SkipRange> &ranges, bool inClass, int width, const char *movemask );
+	void SKIP_LOOP( RedStateAp *state );
+	virtual bool skipLoopAllowed( RedStateAp *state );
+	virtual string SKIP_LOOP_EOF( RedStateAp *state );
+
+	/* Testing for the most taken transitions of a profile first. */
+	void hotRanges( RedStateAp *state, RedTransAp *trans, RedTransList &ranges );
+	string HOT_TEST( RedStateAp *state, RedTransList &ranges );
+	void HOT_TRANS( RedStateAp *state );
+
+	/* Transitions of the current state already tested for by HOT_TRANS. */
+	RedTransSet hotTrans;
+
 	/* Called from STATE_GOTOS just before writing the gotos */
 	virtual void GOTO_HEADER( RedStateAp *state );
 	virtual void STATE_GOTO_ERROR();
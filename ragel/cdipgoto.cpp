@@ -26,6 +26,9 @@
 #include "redfsm.h"
 #include "gendata.h"
 #include "bstmap.h"
+#include <sstream>
+
+using std::ostringstream;
 
 bool IpGotoCodeGen::useAgainLabel()
 {
@@ -191,6 +194,9 @@ void IpGotoCodeGen::GOTO_HEADER( RedStateAp *state )
 	/* Give the state a switch case. */
 	out << "case " << state->id << ":\n";
 
+	if ( instrumentOpt )
+		out << "\t" << PCS() << "[" << state->id << "]++;\n";
+
 	if ( state->fromStateAction != 0 ) {
 		/* Remember that we wrote an action. Write every action in the list. */
 		anyWritten = true;
@@ -206,6 +212,9 @@ void IpGotoCodeGen::GOTO_HEADER( RedStateAp *state )
 	/* Record the prev state if necessary. */
 	if ( state->anyRegCurStateRef() )
 		out << "	_ps = " << state->id << ";\n";
+
+	if ( state->literalLen > 0 )
+		LITERAL_MATCH( state );
 }
 
 void IpGotoCodeGen::STATE_GOTO_ERROR()
@@ -229,17 +238,37 @@ void IpGotoCodeGen::STATE_GOTO_ERROR()
 }
 
 
+/* Skipping to the end leaves through the state's own exit label. */
+bool IpGotoCodeGen::skipLoopAllowed( RedStateAp *state )
+{
+	return state->outNeeded;
+}
+
+string IpGotoCodeGen::SKIP_LOOP_EOF( RedStateAp *state )
+{
+	ostringstream ret;
+	ret << "goto _test_eof" << state->id << ";";
+	return ret.str();
+}
+
 /* Emit the goto to take for a given transition. */
 std::ostream &IpGotoCodeGen::TRANS_GOTO( RedTransAp *trans, int level )
 {
+	out << TABS(level);
+	if ( instrumentOpt )
+		out << "{" << PCT() << "[" << trans->id << "]++; ";
+
 	if ( trans->action != 0 ) {
 		/* Go to the transition which will go to the state. */
-		out << TABS(level) << "goto tr" << trans->id << ";";
+		out << "goto tr" << trans->id << ";";
 	}
 	else {
 		/* Go directly to the target state. */
-		out << TABS(level) << "goto st" << trans->targ->id << ";";
+		out << "goto st" << trans->targ->id << ";";
 	}
+
+	if ( instrumentOpt )
+		out << "}";
 	return out;
 }
 
@@ -278,7 +307,8 @@ std::ostream &IpGotoCodeGen::FINISH_CASES()
 
 	for ( RedStateList::Iter st = redFsm->stateList; st.lte(); st++ ) {
 		if ( st->eofTrans != 0 )
-			out << "	case " << st->id << ": goto tr" << st->eofTrans->id << ";\n";
+			out << "	case " << st->id << ": " << 
+					PROF_EOF( st->eofTrans ) << "goto tr" << st->eofTrans->id << ";\n";
 	}
 
 	for ( GenActionTableMap::Iter act = redFsm->actionMap; act.lte(); act++ ) {
@@ -302,6 +332,134 @@ std::ostream &IpGotoCodeGen::FINISH_CASES()
 	return out;
 }
 
+/* The longest literal matched in one compare. Longer chains are matched in
+ * several pieces. */
+#define LITERAL_MAX_LEN 8
+
+/* If the state moves on exactly one key, without an action, and every other
+ * key is an error, return the target and set key. */
+RedStateAp *IpGotoCodeGen::literalLink( RedStateAp *state, Key &key )
+{
+	if ( state == redFsm->errState || state->stateCondList.length() > 0 )
+		return 0;
+
+	RedTransAp *link = 0;
+	if ( state->defTrans != 0 && state->defTrans->targ != redFsm->errState )
+		return 0;
+
+	for ( RedTransList::Iter rtel = state->outSingle; rtel.lte(); rtel++ ) {
+		if ( rtel->value->targ != redFsm->errState ) {
+			if ( link != 0 )
+				return 0;
+			link = rtel->value;
+			key = rtel->lowKey;
+		}
+	}
+
+	for ( RedTransList::Iter rtel = state->outRange; rtel.lte(); rtel++ ) {
+		if ( rtel->value->targ != redFsm->errState ) {
+			if ( link != 0 || rtel->lowKey != rtel->highKey )
+				return 0;
+			link = rtel->value;
+			key = rtel->lowKey;
+		}
+	}
+
+	if ( link == 0 || link->action != 0 )
+		return 0;
+	return link->targ;
+}
+
+/* States inside a literal are passed over, so they cannot have to-state or
+ * from-state actions. */
+bool IpGotoCodeGen::literalInner( RedStateAp *state )
+{
+	return state->toStateAction == 0 && state->fromStateAction == 0;
+}
+
+/* Find the chains of single key states. A chain starts at a state that no
+ * other link leads to and is cut into pieces of at most LITERAL_MAX_LEN. It
+ * ends before a state already on a chain, so a chain leading into a cycle of
+ * single key states, or a state linking to itself, ends too. */
+void IpGotoCodeGen::setLiterals()
+{
+	/* Instrumented builds count every transition. */
+	if ( hostLang->lang != HostLang::C || noEnd || getKeyExpr != 0 ||
+			keyOps->alphType->size != 1 || instrumentOpt )
+		return;
+
+	Key key;
+	bool *linkTarg = new bool[redFsm->nextStateId];
+	memset( linkTarg, 0, sizeof(bool) * redFsm->nextStateId );
+	for ( RedStateList::Iter st = redFsm->stateList; st.lte(); st++ ) {
+		RedStateAp *targ = literalLink( st, key );
+		if ( targ != 0 )
+			linkTarg[targ->id] = true;
+	}
+
+	bool *onChain = new bool[redFsm->nextStateId];
+	memset( onChain, 0, sizeof(bool) * redFsm->nextStateId );
+
+	for ( RedStateList::Iter st = redFsm->stateList; st.lte(); st++ ) {
+		if ( linkTarg[st->id] )
+			continue;
+
+		RedStateAp *head = st;
+		onChain[head->id] = true;
+		while ( head != 0 ) {
+			int len = 0;
+			RedStateAp *cur = head, *targ;
+			while ( len < LITERAL_MAX_LEN && ( len == 0 || literalInner( cur ) ) &&
+					( targ = literalLink( cur, key ) ) != 0 && !onChain[targ->id] )
+			{
+				cur = targ;
+				onChain[cur->id] = true;
+				len += 1;
+			}
+
+			/* A single key is no better than the dispatch. */
+			if ( len < 2 )
+				break;
+
+			head->literalLen = len;
+			cur->labelNeeded = true;
+			head = len == LITERAL_MAX_LEN ? cur : 0;
+		}
+	}
+
+	delete[] linkTarg;
+	delete[] onChain;
+}
+
+/* Match the whole chain starting at a state in one compare when there is
+ * enough input left, otherwise fall through to matching byte by byte. */
+void IpGotoCodeGen::LITERAL_MATCH( RedStateAp *state )
+{
+	Key key;
+	ostringstream bytes, chars;
+	RedStateAp *cur = state;
+	for ( int i = 0; i < state->literalLen; i++ ) {
+		cur = literalLink( cur, key );
+		bytes << "\\" << std::oct << ( key.getVal() & 0xff ) << std::dec;
+		if ( i > 0 )
+			chars << " && ";
+		chars << P() << "[" << i << "] == " << KEY( key );
+	}
+
+	out <<
+		"#if defined(__GNUC__)\n"
+		"	if ( " << PE() << " - " << P() << " >= " << state->literalLen << 
+				" && __builtin_memcmp( " << P() << ", \"" << bytes.str() << "\", " << 
+				state->literalLen << " ) == 0 ) {\n"
+		"#else\n"
+		"	if ( " << PE() << " - " << P() << " >= " << state->literalLen << 
+				" && " << chars.str() << " ) {\n"
+		"#endif\n"
+		"		" << P() << " += " << state->literalLen - 1 << ";\n"
+		"		goto st" << cur->id << ";\n"
+		"	}\n";
+}
+
 void IpGotoCodeGen::setLabelsNeeded( GenInlineList *inlineList )
 {
 	for ( GenInlineList::Iter item = *inlineList; item.lte(); item++ ) {
@@ -352,6 +510,8 @@ void IpGotoCodeGen::setLabelsNeeded()
 		}
 	}
 
+	setLiterals();
+
 	if ( !noEnd ) {
 		for ( RedStateList::Iter st = redFsm->stateList; st.lte(); st++ ) {
 			if ( st != redFsm->errState )
@@ -363,6 +523,7 @@ void IpGotoCodeGen::setLabelsNeeded()
 void IpGotoCodeGen::writeData()
 {
 	STATE_IDS();
+	PROF_DATA();
 }
 
 void IpGotoCodeGen::writeExec()
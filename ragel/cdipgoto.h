@@ -65,6 +65,14 @@ protected:
 	bool IN_TRANS_ACTIONS( RedStateAp *state );
 	void GOTO_HEADER( RedStateAp *state );
 	void STATE_GOTO_ERROR();
+	bool skipLoopAllowed( RedStateAp *state );
+	string SKIP_LOOP_EOF( RedStateAp *state );
+
+	/* Chains of single key states matched as one literal. */
+	RedStateAp *literalLink( RedStateAp *state, Key &key );
+	bool literalInner( RedStateAp *state );
+	void setLiterals();
+	void LITERAL_MATCH( RedStateAp *state );
 
 	/* Set up labelNeeded flag for each state. */
 	void setLabelsNeeded( GenInlineList *inlineList );
@@ -32,7 +32,9 @@ using std::endl;
 /* Emit the goto to take for a given transition. */
 std::ostream &SplitCodeGen::TRANS_GOTO( RedTransAp *trans, int level )
 {
-	if ( trans->targ->partition == currentPartition ) {
+	/* Every partition has its own copy of the error state. */
+	if ( trans->targ->partition == currentPartition ||
+			trans->targ == redFsm->errState ) {
 		if ( trans->action != 0 ) {
 			/* Go to the transition which will go to the state. */
 			out << TABS(level) << "goto tr" << trans->id << ";";
@@ -62,7 +64,7 @@ void SplitCodeGen::GOTO_HEADER( RedStateAp *state, bool stateInPartition )
 {
 	bool anyWritten = IN_TRANS_ACTIONS( state );
 
-	if ( state->labelNeeded ) 
+	if ( state->labelNeeded )
 		out << "st" << state->id << ":\n";
 
 	if ( state->toStateAction != 0 ) {
@@ -107,12 +109,34 @@ void SplitCodeGen::GOTO_HEADER( RedStateAp *state, bool stateInPartition )
 		out << "	_ps = " << state->id << ";\n";
 }
 
+/* Leaving through the boundary of a partition would advance p before the
+ * error state is reached, so each partition writes the error state. */
+void SplitCodeGen::STATE_GOTO_ERROR( bool stateInPartition )
+{
+	RedStateAp *state = redFsm->errState;
+	bool anyWritten = IN_TRANS_ACTIONS( state );
+
+	if ( anyWritten )
+		genLineDirective( out );
+
+	if ( state->labelNeeded )
+		out << "st" << state->id << ":\n";
+
+	/* The partition map sends exec entered in the error state here. */
+	if ( stateInPartition )
+		out << "case " << state->id << ":\n";
+
+	outLabelUsed = true;
+	out << vCS() << " = " << state->id << ";\n";
+	out << "	goto _out;\n";
+}
+
 std::ostream &SplitCodeGen::STATE_GOTOS( int partition )
 {
 	for ( RedStateList::Iter st = redFsm->stateList; st.lte(); st++ ) {
-		if ( st->partition == partition ) {
+		if ( st->partition == partition || st == redFsm->errState ) {
 			if ( st == redFsm->errState )
-				STATE_GOTO_ERROR();
+				STATE_GOTO_ERROR( st->partition == partition );
 			else {
 				/* We call into the base of the goto which calls back into us
 				 * using virtual functions. Set the current partition rather
@@ -127,6 +151,9 @@ std::ostream &SplitCodeGen::STATE_GOTOS( int partition )
 					emitCondBSearch( st, 1, 0, st->stateCondVect.length() - 1 );
 				}
 
+				/* Most taken transitions first. */
+				HOT_TRANS( st );
+
 				/* Try singles. */
 				if ( st->outSingle.length() > 0 )
 					emitSingleSwitch( st );
@@ -459,7 +486,8 @@ void SplitCodeGen::setLabelsNeeded( RedStateAp *fromState, RedTransAp *trans )
 {
 	/* In the split code gen we don't need labels for transitions across
 	 * partitions. */
-	if ( fromState->partition == trans->targ->partition ) {
+	if ( fromState->partition == trans->targ->partition ||
+			trans->targ == redFsm->errState ) {
 		/* If there is no action with a next statement, then the label will be
 		 * needed. */
 		trans->labelNeeded = true;
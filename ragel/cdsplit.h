@@ -36,6 +36,7 @@ public:
 	std::ostream &PART_TRANS( int partition );
 	std::ostream &TRANS_GOTO( RedTransAp *trans, int level );
 	void GOTO_HEADER( RedStateAp *state, bool stateInPartition );
+	void STATE_GOTO_ERROR( bool stateInPartition );
 	std::ostream &STATE_GOTOS( int partition );
 	std::ostream &PARTITION( int partition );
 	std::ostream &ALL_PARTITIONS();
@@ -50,8 +50,9 @@ void TabCodeGen::calcIndexSize()
 			sizeWithoutInds += arrayTypeSize(redFsm->maxActionLoc) * totalIndex;
 	}
 
-	/* If using indicies reduces the size, use them. */
-	useIndicies = sizeWithInds < sizeWithoutInds;
+	/* If using indicies reduces the size, use them. Instrumented builds
+	 * always do, so the transition counters are indexed by id. */
+	useIndicies = instrumentOpt || sizeWithInds < sizeWithoutInds;
 }
 
 std::ostream &TabCodeGen::TO_STATE_ACTION( RedStateAp *state )
@@ -867,6 +868,7 @@ void TabCodeGen::writeData()
 	}
 
 	STATE_IDS();
+	PROF_DATA();
 }
 
 void TabCodeGen::COND_TRANSLATE()
@@ -968,7 +970,7 @@ void TabCodeGen::writeExec()
 			"		goto _out;\n";
 	}
 
-	out << "_resume:\n";
+	out << "_resume:\n" << PROF_STATE( vCS() );
 
 	if ( redFsm->anyFromStateActions() ) {
 		out <<
@@ -999,6 +1001,7 @@ void TabCodeGen::writeExec()
 	if ( redFsm->anyRegCurStateRef() )
 		out << "	_ps = " << vCS() << ";\n";
 
+	out << PROF_TRANS( "_trans" );
 	out <<
 		"	" << vCS() << " = " << TT() << "[_trans];\n"
 		"\n";
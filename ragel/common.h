@@ -37,6 +37,14 @@ struct InputLoc
 
 typedef unsigned long long Size;
 
+/* Storage class for globals that each thread needs its own copy of when
+ * machine specifications are compiled in parallel. */
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
 struct Key
 {
 private:
@@ -57,8 +65,9 @@ public:
 
 	friend struct KeyOps;
 	
+	/* The copy constructor is left implicit so keys stay trivially copyable
+	 * and can be moved about by the aapl containers and sorts. */
 	Key( ) {}
-	Key( const Key &key ) : key(key.key) {}
 	Key( long key ) : key(key) {}
 
 	/* Returns the value used to represent the key. This value must be
@@ -214,7 +223,7 @@ struct KeyOps
 	}
 };
 
-extern KeyOps *keyOps;
+extern THREAD_LOCAL KeyOps *keyOps;
 
 inline bool operator<( const Key key1, const Key key2 )
 {
@@ -250,6 +259,19 @@ inline bool operator!=( const Key key1, const Key key2 )
 	return key1.key != key2.key;
 }
 
+struct CmpKey
+{
+	static int compare( const Key key1, const Key key2 )
+	{
+		if ( key1 < key2 )
+			return -1;
+		else if ( key1 > key2 )
+			return 1;
+		else
+			return 0;
+	}
+};
+
 /* Decrement. Needed only for ranges. */
 inline void Key::decrement()
 {
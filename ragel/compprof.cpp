@@ -0,0 +1,340 @@
+/*
+ *  Copyright 2010 Adrian Thurston <thurston@complang.org>
+ */
+
+/*  This file is part of Ragel.
+ *
+ *  Ragel is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Ragel is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Ragel; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <iostream>
+#include <iomanip>
+
+#include "ragel.h"
+#include "compprof.h"
+#include "parsedata.h"
+#include "mergesort.h"
+
+using std::ostream;
+using std::setw;
+using std::endl;
+
+/* Number of nodes shown in the report. */
+#define PROF_REPORT_NODES 30
+
+THREAD_LOCAL CompileProfile *compileProfile = 0;
+THREAD_LOCAL CompileProfFrame *compileProfFrame = 0;
+
+static ProfTime profTime()
+{
+	struct timeval tv;
+	gettimeofday( &tv, 0 );
+	return (ProfTime)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/* Peak resident set size of the process in kilobytes. */
+static long peakKb()
+{
+	struct rusage usage;
+	if ( getrusage( RUSAGE_SELF, &usage ) != 0 )
+		return 0;
+#ifdef __APPLE__
+	/* Counted in bytes. */
+	return usage.ru_maxrss / 1024;
+#else
+	return usage.ru_maxrss;
+#endif
+}
+
+CompileProfNode::CompileProfNode( const void *node, const char *kind,
+		const char *name, const InputLoc &loc )
+:
+	node(node), kind(kind), name(name), loc(loc),
+	calls(0), totalTime(0), selfTime(0), minTime(0),
+	buildStates(-1), buildTrans(-1), states(-1), trans(-1)
+{
+}
+
+CompileProfile::CompileProfile()
+:
+	startTime(profTime()),
+	totalTime(0)
+{
+}
+
+CompileProfile::~CompileProfile()
+{
+	nodeTree.empty();
+}
+
+CompileProfNode *CompileProfile::findNode( const void *node, const char *kind,
+		const char *name, const InputLoc &loc )
+{
+	CompileProfNode *profNode = nodeTree.find( node );
+	if ( profNode == 0 ) {
+		profNode = new CompileProfNode( node, kind, name, loc );
+		nodeTree.insert( profNode );
+	}
+	return profNode;
+}
+
+void CompileProfile::finish()
+{
+	totalTime = profTime() - startTime;
+}
+
+/* Hottest first, by the time spent in the node itself. */
+struct CmpProfNodeSelfTime
+{
+	static int compare( const CompileProfNode *n1, const CompileProfNode *n2 )
+	{
+		if ( n1->selfTime > n2->selfTime )
+			return -1;
+		else if ( n1->selfTime < n2->selfTime )
+			return 1;
+		else if ( n1->loc.line < n2->loc.line )
+			return -1;
+		else if ( n1->loc.line > n2->loc.line )
+			return 1;
+		else if ( n1->loc.col < n2->loc.col )
+			return -1;
+		else if ( n1->loc.col > n2->loc.col )
+			return 1;
+		return 0;
+	}
+};
+
+/* Nodes that never completed have no sizes. */
+static void writeCount( ostream &out, long n, int width )
+{
+	if ( n < 0 )
+		out << setw(width) << '-';
+	else
+		out << setw(width) << n;
+}
+
+static void writeSeconds( ostream &out, ProfTime t, int width )
+{
+	out << setw(width - 5) << t / 1000000 << '.' << std::setfill('0') <<
+			setw(4) << ( t % 1000000 ) / 100 << std::setfill(' ');
+}
+
+void CompileProfile::report( ostream &out, const char *sectionName,
+		const InputLoc &sectionLoc )
+{
+	int numNodes = nodeTree.length();
+	CompileProfNode **nodes = new CompileProfNode*[numNodes];
+	int n = 0;
+	for ( CompileProfTree::Iter node = nodeTree; node.lte(); node++ )
+		nodes[n++] = node;
+
+	MergeSort<CompileProfNode*, CmpProfNodeSelfTime> mergeSort;
+	mergeSort.sort( nodes, numNodes );
+
+	out << sectionLoc << ": compile profile of " << sectionName << ": ";
+	writeSeconds( out, totalTime, 6 );
+	out << "s, " << numNodes << " nodes" << endl;
+	out << setw(10) << "self" << setw(10) << "total" << setw(10) << "minimize" <<
+			setw(7) << "calls" << setw(19) << "states" <<
+			setw(19) << "transitions" << "  node" << endl;
+
+	int shown = numNodes < PROF_REPORT_NODES ? numNodes : PROF_REPORT_NODES;
+	for ( int i = 0; i < shown; i++ ) {
+		CompileProfNode *node = nodes[i];
+		writeSeconds( out, node->selfTime, 10 );
+		writeSeconds( out, node->totalTime, 10 );
+		writeSeconds( out, node->minTime, 10 );
+		out << setw(7) << node->calls;
+		writeCount( out, node->buildStates, 9 );
+		out << " ->";
+		writeCount( out, node->states, 7 );
+		writeCount( out, node->buildTrans, 9 );
+		out << " ->";
+		writeCount( out, node->trans, 7 );
+		out << "  " << ( node->loc.fileName != 0 ? node->loc : sectionLoc ) <<
+				": " << node->kind;
+		if ( node->name != 0 )
+			out << " " << node->name;
+		out << endl;
+	}
+
+	if ( shown < numNodes )
+		out << "  (" << numNodes - shown << " more nodes)" << endl;
+
+	delete[] nodes;
+}
+
+CompileProfFrame::CompileProfFrame( const void *node, const char *kind,
+		const InputLoc &loc, const char *name )
+{
+	if ( compileProfile == 0 || kind == 0 ) {
+		profNode = 0;
+		return;
+	}
+
+	/* Plain concatenation and factors with only priorities embedded have no
+	 * location of their own. Report them at the enclosing node. */
+	const InputLoc &nodeLoc = loc.line == 0 && compileProfFrame != 0 ?
+			compileProfFrame->profNode->loc : loc;
+	profNode = compileProfile->findNode( node, kind, name, nodeLoc );
+
+	startTime = profTime();
+	childTime = 0;
+	minTime = 0;
+	buildStates = buildTrans = -1;
+	states = trans = -1;
+
+	prev = compileProfFrame;
+	compileProfFrame = this;
+}
+
+CompileProfFrame::~CompileProfFrame()
+{
+	if ( profNode == 0 )
+		return;
+
+	ProfTime elapsed = profTime() - startTime;
+	profNode->calls += 1;
+	profNode->totalTime += elapsed;
+	profNode->selfTime += elapsed - childTime;
+	profNode->minTime += minTime;
+
+	/* If the walk did not complete there is no result. */
+	if ( states >= 0 ) {
+		if ( states > buildStates )
+			buildStates = states;
+		if ( trans > buildTrans )
+			buildTrans = trans;
+		profNode->states = states;
+		profNode->trans = trans;
+	}
+	if ( buildStates > profNode->buildStates )
+		profNode->buildStates = buildStates;
+	if ( buildTrans > profNode->buildTrans )
+		profNode->buildTrans = buildTrans;
+
+	compileProfFrame = prev;
+	if ( prev != 0 )
+		prev->childTime += elapsed;
+}
+
+void CompileProfFrame::result( FsmAp *fsm )
+{
+	if ( profNode != 0 ) {
+		states = fsm->stateList.length();
+		trans = countTransitions( fsm );
+	}
+}
+
+CompileProfMin::CompileProfMin( FsmAp *fsm )
+{
+	if ( compileProfFrame == 0 )
+		return;
+
+	long states = fsm->stateList.length();
+	long trans = countTransitions( fsm );
+	if ( states > compileProfFrame->buildStates )
+		compileProfFrame->buildStates = states;
+	if ( trans > compileProfFrame->buildTrans )
+		compileProfFrame->buildTrans = trans;
+
+	startTime = profTime();
+}
+
+CompileProfMin::~CompileProfMin()
+{
+	if ( compileProfFrame != 0 )
+		compileProfFrame->minTime += profTime() - startTime;
+}
+
+static const char *phaseNames[NumCompilePhases] = {
+	"walk", "deterministicEntry", "removeActionDups", "minimize",
+	"compressTransitions", "other", "makeBackend", "emit"
+};
+
+PhaseTimes::PhaseTimes()
+{
+	for ( int p = 0; p < NumCompilePhases; p++ ) {
+		time[p] = 0;
+		peakKb[p] = -1;
+		growKb[p] = 0;
+	}
+}
+
+static void writePhase( ostream &out, ProfTime t, long peak, long grow,
+		const char *name )
+{
+	writeSeconds( out, t, 10 );
+	writeCount( out, peak, 10 );
+	writeCount( out, peak < 0 ? -1 : grow, 10 );
+	out << "  " << name << endl;
+}
+
+/* The build phase is reported as the part of it not in the phases it
+ * contains. */
+void PhaseTimes::report( ostream &out, const char *sectionName,
+		const InputLoc &sectionLoc )
+{
+	ProfTime totalTime = time[PhaseBuild] + time[PhaseMakeBackend] + time[PhaseEmit];
+	long totalPeak = -1;
+	for ( int p = 0; p < NumCompilePhases; p++ ) {
+		if ( peakKb[p] > totalPeak )
+			totalPeak = peakKb[p];
+	}
+
+	out << sectionLoc << ": phase times of " << sectionName << ": ";
+	writeSeconds( out, totalTime, 6 );
+	out << "s, peak " << totalPeak << " kB" << endl;
+	out << setw(10) << "seconds" << setw(10) << "peak kB" <<
+			setw(10) << "grown kB" << "  phase" << endl;
+
+	ProfTime otherTime = time[PhaseBuild];
+	long otherGrow = growKb[PhaseBuild];
+	for ( int p = 0; p < NumCompilePhases; p++ ) {
+		if ( p < PhaseBuild ) {
+			otherTime -= time[p];
+			otherGrow -= growKb[p];
+		}
+
+		if ( p == PhaseBuild )
+			writePhase( out, otherTime, peakKb[p], otherGrow, phaseNames[p] );
+		else
+			writePhase( out, time[p], peakKb[p], growKb[p], phaseNames[p] );
+	}
+}
+
+PhaseTimer::PhaseTimer( PhaseTimes *phaseTimes, CompilePhase phase )
+:
+	phaseTimes(phaseTimes),
+	phase(phase)
+{
+	if ( phaseTimes != 0 ) {
+		startKb = peakKb();
+		startTime = profTime();
+	}
+}
+
+PhaseTimer::~PhaseTimer()
+{
+	if ( phaseTimes != 0 ) {
+		phaseTimes->time[phase] += profTime() - startTime;
+		long endKb = peakKb();
+		phaseTimes->growKb[phase] += endKb - startKb;
+		if ( endKb > phaseTimes->peakKb[phase] )
+			phaseTimes->peakKb[phase] = endKb;
+	}
+}
@@ -0,0 +1,162 @@
+/*
+ *  Copyright 2010 Adrian Thurston <thurston@complang.org>
+ */
+
+/*  This file is part of Ragel.
+ *
+ *  Ragel is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Ragel is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Ragel; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _COMPPROF_H
+#define _COMPPROF_H
+
+#include <iostream>
+#include "common.h"
+#include "avltree.h"
+#include "compare.h"
+
+struct FsmAp;
+
+/* Microseconds of wall clock time. */
+typedef long long ProfTime;
+
+/* Accumulated cost of one parse tree node. A machine definition that is
+ * referenced from several places is walked once per reference, so nodes can
+ * have more than one call. */
+struct CompileProfNode
+:
+	public AvlTreeEl<CompileProfNode>
+{
+	CompileProfNode( const void *node, const char *kind,
+			const char *name, const InputLoc &loc );
+
+	const void *getKey() { return node; }
+
+	const void *node;
+	const char *kind;
+	const char *name;
+	InputLoc loc;
+
+	long calls;
+	ProfTime totalTime;
+	ProfTime selfTime;
+	ProfTime minTime;
+
+	/* Largest machine the node produced before minimizing it, and the size
+	 * of the machine it returned. Negative until a walk completes. */
+	long buildStates, buildTrans;
+	long states, trans;
+};
+
+typedef AvlTree< CompileProfNode, const void*, CmpOrd<const void*> > CompileProfTree;
+
+/* The profile of one machine specification. */
+struct CompileProfile
+{
+	CompileProfile();
+	~CompileProfile();
+
+	CompileProfNode *findNode( const void *node, const char *kind,
+			const char *name, const InputLoc &loc );
+	void finish();
+	void report( std::ostream &out, const char *sectionName,
+			const InputLoc &sectionLoc );
+
+	CompileProfTree nodeTree;
+	ProfTime startTime;
+	ProfTime totalTime;
+};
+
+/* Placed on the stack for the duration of a parse tree walk. Does nothing
+ * unless a profile is being collected. Nodes that only pass the machine below
+ * them through are given no kind and are not profiled. */
+struct CompileProfFrame
+{
+	CompileProfFrame( const void *node, const char *kind,
+			const InputLoc &loc, const char *name = 0 );
+	~CompileProfFrame();
+
+	/* Record the size of the machine the walk returns. */
+	void result( FsmAp *fsm );
+
+	CompileProfNode *profNode;
+	ProfTime startTime;
+	ProfTime childTime;
+	ProfTime minTime;
+	long buildStates, buildTrans;
+	long states, trans;
+
+	CompileProfFrame *prev;
+};
+
+/* Placed on the stack around a minimization. Credits the time to the
+ * innermost walk under way. */
+struct CompileProfMin
+{
+	CompileProfMin( FsmAp *fsm );
+	~CompileProfMin();
+
+	ProfTime startTime;
+};
+
+/* The phases of compiling a machine specification that --phase-times
+ * reports. Build is all of the construction, so includes the phases before
+ * it. */
+enum CompilePhase
+{
+	PhaseWalk,
+	PhaseDeterministicEntry,
+	PhaseRemoveActionDups,
+	PhaseMinimize,
+	PhaseCompressTransitions,
+	PhaseBuild,
+	PhaseMakeBackend,
+	PhaseEmit,
+	NumCompilePhases
+};
+
+/* Time and memory of the phases of one machine specification. Memory is the
+ * peak resident set size of the process, in kilobytes. */
+struct PhaseTimes
+{
+	PhaseTimes();
+
+	void report( std::ostream &out, const char *sectionName,
+			const InputLoc &sectionLoc );
+
+	ProfTime time[NumCompilePhases];
+
+	/* The peak at the end of the phase and how far the phase raised it. */
+	long peakKb[NumCompilePhases];
+	long growKb[NumCompilePhases];
+};
+
+/* Placed on the stack for the duration of a phase. Does nothing when there
+ * are no phase times. */
+struct PhaseTimer
+{
+	PhaseTimer( PhaseTimes *phaseTimes, CompilePhase phase );
+	~PhaseTimer();
+
+	PhaseTimes *phaseTimes;
+	CompilePhase phase;
+	ProfTime startTime;
+	long startKb;
+};
+
+extern THREAD_LOCAL CompileProfile *compileProfile;
+extern THREAD_LOCAL CompileProfFrame *compileProfFrame;
+
+#endif
@@ -29,6 +29,7 @@
 #include <iomanip>
 #include <string>
 #include <assert.h>
+#include <string.h>
 
 using std::ostream;
 using std::ostringstream;
@@ -188,6 +189,19 @@ string CSharpFsmCodeGen::PE()
 	return ret.str();
 }
 
+string CSharpFsmCodeGen::DATA()
+{
+	ostringstream ret;
+	if ( dataExpr == 0 )
+		ret << "data";
+	else {
+		ret << "(";
+		INLINE_LIST( ret, dataExpr, 0, false );
+		ret << ")";
+	}
+	return ret.str();
+}
+
 string CSharpFsmCodeGen::vEOF()
 {
 	ostringstream ret;
@@ -228,6 +242,19 @@ string CSharpFsmCodeGen::TOP()
 	return ret.str();
 }
 
+string CSharpFsmCodeGen::COUNTERS()
+{
+	ostringstream ret;
+	if ( countersExpr == 0 )
+		ret << ACCESS() + "counters";
+	else {
+		ret << "(";
+		INLINE_LIST( ret, countersExpr, 0, false );
+		ret << ")";
+	}
+	return ret.str();
+}
+
 string CSharpFsmCodeGen::STACK()
 {
 	ostringstream ret;
@@ -334,10 +361,19 @@ string CSharpFsmCodeGen::KEY( Key key )
 	return ret.str();
 }
 
+/* Write out a key as a table item or case label. Character literals only
+ * convert to a char alphabet, byte and the other integral alphabets get plain
+ * numbers. */
 string CSharpFsmCodeGen::ALPHA_KEY( Key key )
 {
 	ostringstream ret;
-	if (key.getVal() > 0xFFFF) {
+	if ( strcmp( keyOps->alphType->data1, "char" ) != 0 ) {
+		if ( keyOps->isSigned )
+			ret << key.getVal();
+		else
+			ret << (unsigned long) key.getVal();
+	}
+	else if (key.getVal() > 0xFFFF) {
 		ret << key.getVal();
 	} else {
 		ret << "'\\u" << std::hex << std::setw(4) << std::setfill('0') << 
@@ -508,6 +544,9 @@ void CSharpFsmCodeGen::INLINE_LIST( ostream &ret, GenInlineList *inlineList,
 		case GenInlineItem::Break:
 			BREAK( ret, targState );
 			break;
+		case GenInlineItem::Counter:
+			ret << COUNTERS() << "[" << item->counterId << "]";
+			break;
 		}
 	}
 }
@@ -631,6 +670,11 @@ void CSharpFsmCodeGen::STATE_IDS()
 	if ( !noError )
 		STATIC_VAR( "int", ERROR() ) << " = " << ERROR_STATE() << ";\n";
 
+	if ( numCounters > 0 ) {
+		STATIC_VAR( "int", DATA_PREFIX() + "num_counters" ) <<
+				" = " << numCounters << ";\n";
+	}
+
 	out << "\n";
 
 	if ( entryPointNames.length() > 0 ) {
@@ -643,6 +687,16 @@ void CSharpFsmCodeGen::STATE_IDS()
 }
 
 
+/* Open the block of the exec code. The data is pinned for the whole block
+ * when keys are read through a pointer, which the JIT does not bounds check. */
+void CSharpFsmCodeGen::OPEN_EXEC()
+{
+	if ( fixedDataOpt && getKeyExpr == 0 )
+		out << "	fixed ( " << ALPH_TYPE() << "* _data = " << DATA() << " ) {\n";
+	else
+		out << "	{\n";
+}
+
 void CSharpFsmCodeGen::writeStart()
 {
 	out << START_STATE_ID();
@@ -671,8 +725,12 @@ string CSharpCodeGen::GET_KEY()
 		ret << ")";
 	}
 	else {
-		/* Expression for retrieving the key, use simple dereference. */
-		ret << "data[" << P() << "]";
+		/* Expression for retrieving the key, index the data or the pointer
+		 * to it that the exec block pinned. */
+		if ( fixedDataOpt )
+			ret << "_data[" << P() << "]";
+		else
+			ret << DATA() << "[" << P() << "]";
 	}
 	return ret.str();
 }
@@ -695,6 +753,16 @@ string CSharpCodeGen::PTR_CONST()
 
 std::ostream &CSharpCodeGen::OPEN_ARRAY( string type, string name )
 {
+	/* A span property over a constant array initializer reads the assembly's
+	 * data in place. Nothing is allocated when the type is initialized. Before
+	 * C# 11 only byte sized items are read in place. Wider ones would allocate
+	 * the array on every read, so they stay static readonly arrays. */
+	if ( spanTablesOpt && ( type == "byte" || type == "sbyte" ) ) {
+		out << "static System.ReadOnlySpan<" << type << "> " << name << " => ";
+		out << "new " << type << " [] {\n";
+		return out;
+	}
+
 	out << "static readonly " << type << "[] " << name << " =  ";
 	/*
 	if (type == "char")
@@ -747,7 +815,7 @@ void CSharpCodeGen::writeExports()
 	if ( exportList.length() > 0 ) {
 		for ( ExportList::Iter ex = exportList; ex.lte(); ex++ ) {
 			out << "const " << ALPH_TYPE() << " " << DATA_PREFIX() << 
-					"ex_" << ex->name << " = " << KEY(ex->key) << ";\n";
+					"ex_" << ex->name << " = " << ALPHA_KEY(ex->key) << ";\n";
 		}
 		out << "\n";
 	}
@@ -93,11 +93,13 @@ protected:
 	string P();
 	string PE();
 	string vEOF();
+	string DATA();
 
 	string ACCESS();
 	string vCS();
 	string STACK();
 	string TOP();
+	string COUNTERS();
 	string TOKSTART();
 	string TOKEND();
 	string ACT();
@@ -123,6 +125,7 @@ protected:
 	string ET() { return "_" + DATA_PREFIX() + "eof_trans"; }
 	string SP() { return "_" + DATA_PREFIX() + "key_spans"; }
 	string CSP() { return "_" + DATA_PREFIX() + "cond_key_spans"; }
+	string CC() { return "_" + DATA_PREFIX() + "char_class"; }
 	string START() { return DATA_PREFIX() + "start"; }
 	string ERROR() { return DATA_PREFIX() + "error"; }
 	string FIRST_FINAL() { return DATA_PREFIX() + "first_final"; }
@@ -151,6 +154,7 @@ protected:
 	void SUB_ACTION( ostream &ret, GenInlineItem *item, 
 			int targState, bool inFinish );
 	void STATE_IDS();
+	void OPEN_EXEC();
 
 	string ERROR_STATE();
 	string FIRST_FINAL_STATE();
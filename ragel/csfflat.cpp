@@ -173,7 +173,14 @@ void CSharpFFlatCodeGen::writeData()
 		"\n";
 	}
 
-	OPEN_ARRAY( WIDE_ALPH_TYPE(), K() );
+	if ( redFsm->anyCharClasses() ) {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->numClasses), CC() );
+		CHAR_CLASS();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+
+	OPEN_ARRAY( KEYS_TYPE(), K() );
 	KEYS();
 	CLOSE_ARRAY() <<
 	"\n";
@@ -242,8 +249,9 @@ void CSharpFFlatCodeGen::writeExec()
 	outLabelUsed = false;
 	initVarTypes();
 
-	out << 
-		"	{\n"
+	OPEN_EXEC();
+
+	out <<
 		"	" << slenType << " _slen";
 
 	if ( redFsm->anyRegCurStateRef() )
@@ -260,6 +268,9 @@ void CSharpFFlatCodeGen::writeExec()
 	out <<
 		"	" << "int _keys;\n"
 		"	" << indsType << " _inds;\n";
+
+	if ( redFsm->anyCharClasses() )
+		out << "	int _cls;\n";
 		/*
 		"	" << PTR_CONST() << WIDE_ALPH_TYPE() << POINTER() << "_keys;\n"
 		"	" << PTR_CONST() << ARRAY_TYPE(redFsm->maxIndex) << POINTER() << "_inds;\n";*/
@@ -181,7 +181,7 @@ void CSharpFGotoCodeGen::writeExec()
 	testEofUsed = false;
 	outLabelUsed = false;
 
-	out << "	{\n";
+	OPEN_EXEC();
 
 	if ( redFsm->anyRegCurStateRef() )
 		out << "	int _ps = 0;\n";
@@ -267,7 +267,7 @@ std::ostream &CSharpFlatCodeGen::COND_KEYS()
 
 	/* Output one last number so we don't have to figure out when the last
 	 * entry is and avoid writing a comma. */
-	out << "(char) " << 0 << "\n";
+	out << ALPHA_KEY( 0 ) << "\n";
 	return out;
 }
 
@@ -343,19 +343,52 @@ std::ostream &CSharpFlatCodeGen::KEYS()
 	out << '\t';
 	int totalTrans = 0;
 	for ( RedStateList::Iter st = redFsm->stateList; st.lte(); st++ ) {
-		/* Emit just low key and high key. */
-		out << ALPHA_KEY( st->lowKey ) << ", ";
-		out << ALPHA_KEY( st->highKey ) << ", ";
+		/* Emit just low key and high key. These are classes when the keys
+		 * are mapped. */
+		if ( redFsm->anyCharClasses() ) {
+			out << st->lowKey.getVal() << ", ";
+			out << st->highKey.getVal() << ", ";
+		}
+		else {
+			out << ALPHA_KEY( st->lowKey ) << ", ";
+			out << ALPHA_KEY( st->highKey ) << ", ";
+		}
 		if ( ++totalTrans % IALL == 0 )
 			out << "\n\t";
 	}
 
 	/* Output one last number so we don't have to figure out when the last
 	 * entry is and avoid writing a comma. */
-	out << "(char) " << 0 << "\n";
+	if ( redFsm->anyCharClasses() )
+		out << 0 << "\n";
+	else
+		out << ALPHA_KEY( 0 ) << "\n";
 	return out;
 }
 
+std::ostream &CSharpFlatCodeGen::CHAR_CLASS()
+{
+	out << '\t';
+	unsigned long long span = keyOps->span( redFsm->classLowKey, redFsm->classHighKey );
+	for ( unsigned long long pos = 0; pos < span; pos++ ) {
+		out << redFsm->charClass[pos];
+		if ( pos < span-1 ) {
+			out << ", ";
+			if ( (pos+1) % IALL == 0 )
+				out << "\n\t";
+		}
+	}
+	out << "\n";
+	return out;
+}
+
+string CSharpFlatCodeGen::KEYS_TYPE()
+{
+	if ( redFsm->anyCharClasses() )
+		return ARRAY_TYPE( redFsm->numClasses );
+	return WIDE_ALPH_TYPE();
+}
+
 std::ostream &CSharpFlatCodeGen::INDICIES()
 {
 	int totalTrans = 0;
@@ -444,13 +477,35 @@ void CSharpFlatCodeGen::LOCATE_TRANS()
 	out <<
 		"	_keys = " << vCS() << "<<1;\n"
 		"	_inds = " << IO() << "[" << vCS() << "];\n"
-		"\n"
-		"	_slen = " << SP() << "[" << vCS() << "];\n"
-		"	_trans = " << I() << "[_inds + (\n"
-		"		_slen > 0 && " << K() << "[_keys] <=" << GET_WIDE_KEY() << " &&\n"
-		"		" << GET_WIDE_KEY() << " <= " << K() <<"[_keys+1] ?\n"
-		"		" << GET_WIDE_KEY() << " - " << K() << "[_keys] : _slen ) ];\n"
 		"\n";
+
+	if ( redFsm->anyCharClasses() ) {
+		out << "	_cls = ";
+		if ( redFsm->classLowKey != keyOps->minKey || redFsm->classHighKey != keyOps->maxKey ) {
+			out << GET_KEY() << " < " << KEY( redFsm->classLowKey ) << " || " <<
+					GET_KEY() << " > " << KEY( redFsm->classHighKey ) << " ? " <<
+					redFsm->numClasses << " :\n		";
+		}
+		out << CC() << "[" << CAST( "int" ) << "(" << GET_KEY() << " - " <<
+				KEY( redFsm->classLowKey ) << ")];\n";
+
+		out <<
+			"	_slen = " << SP() << "[" << vCS() << "];\n"
+			"	_trans = " << I() << "[_inds + (\n"
+			"		_slen > 0 && " << K() << "[_keys] <= _cls &&\n"
+			"		_cls <= " << K() <<"[_keys+1] ?\n"
+			"		_cls - " << K() << "[_keys] : _slen ) ];\n"
+			"\n";
+	}
+	else {
+		out <<
+			"	_slen = " << SP() << "[" << vCS() << "];\n"
+			"	_trans = " << I() << "[_inds + (\n"
+			"		_slen > 0 && " << K() << "[_keys] <=" << GET_WIDE_KEY() << " &&\n"
+			"		" << GET_WIDE_KEY() << " <= " << K() <<"[_keys+1] ?\n"
+			"		" << GET_WIDE_KEY() << " - " << K() << "[_keys] : _slen ) ];\n"
+			"\n";
+	}
 }
 
 void CSharpFlatCodeGen::GOTO( ostream &ret, int gotoDest, bool inFinish )
@@ -571,7 +626,14 @@ void CSharpFlatCodeGen::writeData()
 		"\n";
 	}
 
-	OPEN_ARRAY( WIDE_ALPH_TYPE(), K() );
+	if ( redFsm->anyCharClasses() ) {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->numClasses), CC() );
+		CHAR_CLASS();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+
+	OPEN_ARRAY( KEYS_TYPE(), K() );
 	KEYS();
 	CLOSE_ARRAY() <<
 	"\n";
@@ -697,8 +759,9 @@ void CSharpFlatCodeGen::writeExec()
 	outLabelUsed = false;
 	initVarTypes();
 
-	out << 
-		"	{\n"
+	OPEN_EXEC();
+
+	out <<
 		"	" << slenType << " _slen";
 
 	if ( redFsm->anyRegCurStateRef() )
@@ -723,6 +786,9 @@ void CSharpFlatCodeGen::writeExec()
 	out <<
 		"	" << "int _keys;\n"
 		"	" << indsType << " _inds;\n";
+
+	if ( redFsm->anyCharClasses() )
+		out << "	int _cls;\n";
 		/*
 		"	" << PTR_CONST() << WIDE_ALPH_TYPE() << POINTER() << "_keys;\n"
 		"	" << PTR_CONST() << ARRAY_TYPE(redFsm->maxIndex) << POINTER() << "_inds;\n";*/
@@ -48,6 +48,8 @@ protected:
 	std::ostream &EOF_ACTION_SWITCH();
 	std::ostream &ACTION_SWITCH();
 	std::ostream &KEYS();
+	std::ostream &CHAR_CLASS();
+	string KEYS_TYPE();
 	std::ostream &INDICIES();
 	std::ostream &FLAT_INDEX_OFFSET();
 	std::ostream &KEY_SPANS();
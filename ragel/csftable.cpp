@@ -296,8 +296,9 @@ void CSharpFTabCodeGen::writeExec()
 	outLabelUsed = false;
 	initVarTypes();
 
-	out << 
-		"	{\n"
+	OPEN_EXEC();
+
+	out <<
 		"	" << klenType << " _klen";
 
 	if ( redFsm->anyRegCurStateRef() )
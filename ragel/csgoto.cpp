@@ -662,7 +662,7 @@ void CSharpGotoCodeGen::writeExec()
 	testEofUsed = false;
 	outLabelUsed = false;
 
-	out << "	{\n";
+	OPEN_EXEC();
 
 	if ( redFsm->anyRegCurStateRef() )
 		out << "	int _ps = 0;\n";
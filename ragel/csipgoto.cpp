@@ -367,7 +367,7 @@ void CSharpIpGotoCodeGen::writeExec()
 	testEofUsed = false;
 	outLabelUsed = false;
 
-	out << "	{\n";
+	OPEN_EXEC();
 
 	if ( redFsm->anyRegCurStateRef() )
 		out << "	int _ps = 0;\n";
@@ -424,7 +424,7 @@ std::ostream &CSharpTabCodeGen::KEYS()
 
 	/* Output one last number so we don't have to figure out when the last
 	 * entry is and avoid writing a comma. */
-	out << "(char) " << 0 << "\n";
+	out << ALPHA_KEY( 0 ) << "\n";
 	return out;
 }
 
@@ -931,8 +931,9 @@ void CSharpTabCodeGen::writeExec()
 	outLabelUsed = false;
 	initVarTypes();
 
+	OPEN_EXEC();
+
 	out <<
-		"	{\n"
 		"	" << klenType << " _klen";
 
 	if ( redFsm->anyRegCurStateRef() )
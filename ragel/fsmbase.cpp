@@ -23,6 +23,96 @@
 #include <assert.h>
 #include "fsmgraph.h"
 
+#define STATE_DICT_INIT_SIZE 64
+
+StateDict::StateDict()
+:
+	table(0),
+	tableSize(0),
+	numEls(0)
+{
+}
+
+StateDict::~StateDict()
+{
+	delete[] table;
+}
+
+/* Combine the state pointers of a set into a hash value. Sets are kept
+ * sorted so equal sets always hash the same. */
+unsigned long StateDict::hashSet( const StateSet &stateSet )
+{
+	unsigned long hashVal = 2166136261UL;
+	for ( int i = 0; i < stateSet.length(); i++ ) {
+		unsigned long ptr = (unsigned long)stateSet.data[i];
+		hashVal = ( hashVal ^ ( ptr >> 3 ) ) * 16777619UL;
+		hashVal ^= hashVal >> 15;
+	}
+	return hashVal;
+}
+
+/* Double the table size, moving the elements using their stored hashes. */
+void StateDict::grow()
+{
+	long newSize = tableSize == 0 ? STATE_DICT_INIT_SIZE : tableSize * 2;
+	StateDictEl **newTable = new StateDictEl*[newSize];
+	memset( newTable, 0, sizeof(StateDictEl*) * newSize );
+
+	for ( long i = 0; i < tableSize; i++ ) {
+		StateDictEl *el = table[i];
+		while ( el != 0 ) {
+			StateDictEl *next = el->hashNext;
+			long pos = el->hashVal & ( newSize - 1 );
+			el->hashNext = newTable[pos];
+			newTable[pos] = el;
+			el = next;
+		}
+	}
+
+	delete[] table;
+	table = newTable;
+	tableSize = newSize;
+}
+
+StateDictEl *StateDict::insert( const StateSet &stateSet, StateDictEl **lastFound )
+{
+	unsigned long hashVal = hashSet( stateSet );
+
+	if ( tableSize > 0 ) {
+		StateDictEl *el = table[hashVal & ( tableSize - 1 )];
+		for ( ; el != 0; el = el->hashNext ) {
+			if ( el->hashVal == hashVal && 
+					el->stateSet.length() == stateSet.length() &&
+					memcmp( el->stateSet.data, stateSet.data, 
+					sizeof(StateAp*) * stateSet.length() ) == 0 )
+			{
+				*lastFound = el;
+				return 0;
+			}
+		}
+	}
+
+	/* Not found. Keep the load factor at or below one. */
+	if ( numEls >= tableSize )
+		grow();
+
+	StateDictEl *el = new StateDictEl( stateSet, hashVal );
+	long pos = hashVal & ( tableSize - 1 );
+	el->hashNext = table[pos];
+	table[pos] = el;
+	numEls += 1;
+
+	*lastFound = el;
+	return el;
+}
+
+void StateDict::empty()
+{
+	if ( table != 0 )
+		memset( table, 0, sizeof(StateDictEl*) * tableSize );
+	numEls = 0;
+}
+
 /* Simple singly linked list append routine for the fill list. The new state
  * goes to the end of the list. */
 void MergeData::fillListAppend( StateAp *state )
@@ -29,6 +29,165 @@
 using std::cerr;
 using std::endl;
 
+THREAD_LOCAL FsmSlabPool *fsmSlabPool = 0;
+THREAD_LOCAL FsmOpContext *fsmOpContext = 0;
+
+FsmOpContext::FsmOpContext( const char *defName )
+:
+	defName(defName),
+	opName(0),
+	lhsStates(0),
+	rhsStates(0),
+	prev(fsmOpContext)
+{
+	loc.fileName = 0;
+	loc.line = 0;
+	loc.col = 0;
+	fsmOpContext = this;
+}
+
+FsmOpContext::FsmOpContext( const InputLoc &loc, const char *opName,
+		FsmAp *lhs, FsmAp *rhs )
+:
+	defName(0),
+	loc(loc),
+	opName(opName),
+	lhsStates(lhs->stateList.length()),
+	rhsStates(rhs != 0 ? rhs->stateList.length() : 0),
+	prev(fsmOpContext)
+{
+	fsmOpContext = this;
+}
+
+FsmOpContext::~FsmOpContext()
+{
+	fsmOpContext = prev;
+}
+
+/* Capture the innermost operation and definition from the context stack.
+ * The stack unwinds along with the exception. */
+FsmConstructFail::FsmConstructFail( Reason reason )
+:
+	reason(reason),
+	defName(0),
+	opName(0),
+	lhsStates(0),
+	rhsStates(0)
+{
+	opLoc.fileName = 0;
+	opLoc.line = 0;
+	opLoc.col = 0;
+
+	for ( FsmOpContext *ctx = fsmOpContext; ctx != 0; ctx = ctx->prev ) {
+		if ( ctx->opName != 0 && opName == 0 ) {
+			opLoc = ctx->loc;
+			opName = ctx->opName;
+			lhsStates = ctx->lhsStates;
+			rhsStates = ctx->rhsStates;
+		}
+		if ( ctx->defName != 0 && defName == 0 )
+			defName = ctx->defName;
+	}
+}
+
+FsmSlabPool::FsmSlabPool()
+:
+	bytes(0),
+	blocks(0)
+{
+	for ( int t = 0; t < FsmSlabNumTypes; t++ ) {
+		freeList[t] = 0;
+		block[t] = 0;
+		blockAvail[t] = 0;
+	}
+}
+
+FsmSlabPool::~FsmSlabPool()
+{
+	clear();
+}
+
+void *FsmSlabPool::allocate( FsmSlabType type, size_t size )
+{
+	bytes += size;
+
+	FsmSlabHead *head;
+	if ( freeList[type] != 0 ) {
+		head = freeList[type];
+		freeList[type] = head->next;
+	}
+	else {
+		long slot = sizeof(FsmSlabHead) + size;
+		if ( blockAvail[type] == 0 ) {
+			FsmSlabHead *newBlock = (FsmSlabHead*) ::operator new( 
+					sizeof(FsmSlabHead) + slot * FSM_SLAB_BLOCK );
+			newBlock->next = blocks;
+			blocks = newBlock;
+
+			block[type] = (char*)( newBlock + 1 );
+			blockAvail[type] = FSM_SLAB_BLOCK;
+		}
+
+		blockAvail[type] -= 1;
+		head = (FsmSlabHead*)( block[type] + slot * blockAvail[type] );
+	}
+
+	head->pool = this;
+	return head + 1;
+}
+
+void FsmSlabPool::release( FsmSlabType type, size_t size, FsmSlabHead *head )
+{
+	bytes -= size;
+	head->next = freeList[type];
+	freeList[type] = head;
+}
+
+void FsmSlabPool::clear()
+{
+	while ( blocks != 0 ) {
+		FsmSlabHead *next = blocks->next;
+		::operator delete( blocks );
+		blocks = next;
+	}
+
+	for ( int t = 0; t < FsmSlabNumTypes; t++ ) {
+		freeList[t] = 0;
+		block[t] = 0;
+		blockAvail[t] = 0;
+	}
+	bytes = 0;
+}
+
+void *fsmSlabAllocate( FsmSlabType type, size_t size )
+{
+	if ( fsmSlabPool != 0 )
+		return fsmSlabPool->allocate( type, size );
+
+	FsmSlabHead *head = (FsmSlabHead*) ::operator new( sizeof(FsmSlabHead) + size );
+	head->pool = 0;
+	return head + 1;
+}
+
+void fsmSlabRelease( FsmSlabType type, size_t size, void *ptr )
+{
+	if ( ptr != 0 ) {
+		FsmSlabHead *head = (FsmSlabHead*)ptr - 1;
+		if ( head->pool != 0 )
+			head->pool->release( type, size, head );
+		else
+			::operator delete( head );
+	}
+}
+
+void FsmAp::checkLimits()
+{
+	if ( maxStates > 0 && stateList.length() + misfitList.length() > maxStates )
+		throw FsmConstructFail( FsmConstructFail::StateLimit );
+	if ( maxMemory > 0 && fsmSlabPool != 0 && fsmSlabPool->bytes > maxMemory )
+		throw FsmConstructFail( FsmConstructFail::MemoryLimit );
+}
+
 /* Make a new state. The new state will be put on the graph's
  * list of state. The new state can be created final or non final. */
 StateAp *FsmAp::addState()
@@ -46,6 +205,7 @@ StateAp *FsmAp::addState()
 		stateList.append( state );
 	}
 
+	checkLimits();
 	return state;
 }
 
@@ -881,7 +1041,7 @@ void FsmAp::isolateStartState( )
 
 	/* Stfil and stateDict will be empty because the merging of the old start
 	 * state into the new one will not have any conflicting transitions. */
-	assert( md.stateDict.treeSize == 0 );
+	assert( md.stateDict.numEls == 0 );
 	assert( md.stfillHead == 0 );
 
 	/* The old start state may be unreachable. Remove the misfits and turn off
@@ -1272,6 +1432,7 @@ void FsmAp::fillInStates( MergeData &md )
 	while ( state != 0 ) {
 		StateSet *stateSet = &state->stateDictEl->stateSet;
 		mergeStates( md, state, stateSet->data, stateSet->length() );
+		checkLimits();
 		state = state->alg.next;
 	}
 
@@ -1286,8 +1447,9 @@ void FsmAp::fillInStates( MergeData &md )
 		state = state->alg.next;
 	}
 
-	/* StateDict will still have its ptrs/size set but all of it's element
-	 * will be deleted so we don't need to clean it up. */
+	/* All of the dict's elements have been deleted. Drop the references to
+	 * them. */
+	md.stateDict.empty();
 }
 
 void FsmAp::findEmbedExpansions( ExpansionList &expansionList, 
@@ -24,6 +24,8 @@
 
 #include "config.h"
 #include <assert.h>
+#include <stddef.h>
+#include <new>
 #include <iostream>
 #include <string>
 #include "common.h"
@@ -58,6 +60,7 @@ struct FsmAp;
 struct Action;
 struct LongestMatchPart;
 struct LengthDef;
+struct CondPiece;
 
 /* State list element for unambiguous access to list element. */
 struct FsmListEl 
@@ -66,7 +69,8 @@ struct FsmListEl
 };
 
 /* This is the marked index for a state pair. Used in minimization. It keeps
- * track of whether or not the state pair is marked. */
+ * track of whether or not the state pair is marked. Only the lower triangle
+ * of pairs is stored, one bit per pair. */
 struct MarkIndex
 {
 	MarkIndex(int states);
@@ -76,11 +80,25 @@ struct MarkIndex
 	bool isPairMarked(int state1, int state2);
 
 private:
+	Size pairPos(int state1, int state2);
+
 	int numStates;
-	bool *array;
+	unsigned char *array;
+};
+
+/* A pair of states, by number, that was marked and whose predecessor pairs
+ * need to be visited. */
+struct MarkPair
+{
+	MarkPair( int state1, int state2 )
+		: state1(state1), state2(state2) { }
+
+	int state1, state2;
 };
 
-extern KeyOps *keyOps;
+typedef Vector<MarkPair> MarkPairVect;
+
+extern THREAD_LOCAL KeyOps *keyOps;
 
 /* Transistion Action Element. */
 typedef SBstMapEl< int, Action* > ActionTableEl;
@@ -111,6 +129,7 @@ public:
 		numCondRefs(0),
 		anyCall(false),
 		isLmAction(false),
+		isCounterMin(false),
 		condId(condId)
 	{
 	}
@@ -146,6 +165,9 @@ public:
 	bool anyCall;
 
 	bool isLmAction;
+
+	/* Lower bound test of a counted repetition. */
+	bool isCounterMin;
 	int condId;
 };
 
@@ -369,6 +391,75 @@ typedef CmpSTable<PriorEl, CmpPriorEl> CmpPriorTable;
 /* Plain action list that imposes no ordering. */
 typedef Vector<int> TransFuncList;
 
+/* Number of objects carved out of each slab block. */
+#define FSM_SLAB_BLOCK 256
+
+/* The graph objects that are drawn from slabs. Each has free lists of its
+ * own. */
+enum FsmSlabType
+{
+	FsmSlabTrans,
+	FsmSlabStateCond,
+	FsmSlabExpansion,
+	FsmSlabState,
+	FsmSlabNumTypes
+};
+
+struct FsmSlabPool;
+
+/* Every slab object is preceded by the pool it came from, so it goes back to
+ * that pool whichever thread or section frees it. */
+union FsmSlabHead
+{
+	FsmSlabPool *pool;
+	FsmSlabHead *next;
+	long long alignLong;
+	double alignDouble;
+};
+
+/* Slab allocation for the graph objects that are created and destroyed in
+ * great numbers during construction. A pool belongs to a machine
+ * specification. Objects are carved out of large blocks and freed objects go
+ * on a free list to be recycled. All blocks are released in one go when the
+ * specification is done with its graph. */
+struct FsmSlabPool
+{
+	FsmSlabPool();
+	~FsmSlabPool();
+
+	void *allocate( FsmSlabType type, size_t size );
+	void release( FsmSlabType type, size_t size, FsmSlabHead *head );
+
+	/* Release all blocks. Objects still in them must not be used again. */
+	void clear();
+
+	/* Bytes of the objects currently allocated from the pool, which the
+	 * memory limit of the specification is checked against. */
+	long bytes;
+
+private:
+	FsmSlabHead *freeList[FsmSlabNumTypes];
+	char *block[FsmSlabNumTypes];
+	int blockAvail[FsmSlabNumTypes];
+
+	/* All blocks, linked through their first head. */
+	FsmSlabHead *blocks;
+};
+
+/* The pool of the specification the thread is working on. Without one,
+ * objects come from the heap. */
+extern THREAD_LOCAL FsmSlabPool *fsmSlabPool;
+
+void *fsmSlabAllocate( FsmSlabType type, size_t size );
+void fsmSlabRelease( FsmSlabType type, size_t size, void *ptr );
+
+/* Route new and delete of a graph object through the slabs. */
+#define FSM_SLAB_ALLOC(T, type) \
+	static void *operator new( size_t size ) \
+		{ assert( size == sizeof(T) ); return fsmSlabAllocate( type, size ); } \
+	static void operator delete( void *ptr ) \
+		{ fsmSlabRelease( type, sizeof(T), ptr ); }
+
 /* Comparison for TransFuncList. */
 typedef CmpTable< int, CmpOrd<int> > TransFuncListCompare;
 
@@ -399,6 +490,8 @@ struct TransAp
 	PriorTable priorTable;
 
 	LmActionTable lmActionTable;
+
+	FSM_SLAB_ALLOC( TransAp, FsmSlabTrans )
 };
 
 /* In transition list. Like DList except only has head pointers, which is all
@@ -447,21 +540,46 @@ typedef DList<TransAp> TransList;
 typedef BstSet<StateAp*> StateSet;
 typedef DList<StateAp> StateList;
 
-/* A element in a state dict. */
+/* A element in a state dict. The hash of the set is computed once, when the
+ * element is made, and is kept for comparisons and for rehashing. */
 struct StateDictEl 
-:
-	public AvlTreeEl<StateDictEl>
 {
-	StateDictEl(const StateSet &stateSet) 
-		: stateSet(stateSet) { }
+	StateDictEl( const StateSet &stateSet, unsigned long hashVal ) 
+		: stateSet(stateSet), hashVal(hashVal), hashNext(0) { }
 
-	const StateSet &getKey() { return stateSet; }
 	StateSet stateSet;
 	StateAp *targState;
+
+	unsigned long hashVal;
+	StateDictEl *hashNext;
 };
 
-/* Dictionary mapping a set of states to a target state. */
-typedef AvlTree< StateDictEl, StateSet, CmpTable<StateAp*> > StateDict;
+/* Dictionary mapping a set of states to a target state. It is a chained hash
+ * table keyed on the contents of the set. The elements are not owned by the
+ * dictionary. They are handed to the combination states and deleted by them
+ * once their out transitions are filled in. */
+struct StateDict
+{
+	StateDict();
+	~StateDict();
+
+	/* Find the set. If it is not present a new element is made and returned.
+	 * Otherwise returns null. In both cases lastFound is set to the element
+	 * for the set. */
+	StateDictEl *insert( const StateSet &stateSet, StateDictEl **lastFound );
+
+	/* Forget all elements without deleting them. */
+	void empty();
+
+	static unsigned long hashSet( const StateSet &stateSet );
+
+	StateDictEl **table;
+	long tableSize;
+	long numEls;
+
+private:
+	void grow();
+};
 
 /* Data needed for a merge operation. */
 struct MergeData
@@ -490,19 +608,6 @@ struct TransEl
 	TransAp *value;
 };
 
-struct CmpKey
-{
-	static int compare( const Key key1, const Key key2 )
-	{
-		if ( key1 < key2 )
-			return -1;
-		else if ( key1 > key2 )
-			return 1;
-		else
-			return 0;
-	}
-};
-
 /* Vector based set of key items. */
 typedef BstSet<Key, CmpKey> KeySet;
 
@@ -598,6 +703,8 @@ struct StateCond
 	CondSpace *condSpace;
 
 	StateCond *prev, *next;
+
+	FSM_SLAB_ALLOC( StateCond, FsmSlabStateCond )
 };
 
 typedef DList<StateCond> StateCondList;
@@ -627,6 +734,8 @@ struct Expansion
 	LongVect toValsList;
 
 	Expansion *prev, *next;
+
+	FSM_SLAB_ALLOC( Expansion, FsmSlabExpansion )
 };
 
 typedef DList<Expansion> ExpansionList;
@@ -649,18 +758,48 @@ struct CondData
 	CondSpaceMap condSpaceMap;
 };
 
-extern CondData *condData;
+extern THREAD_LOCAL CondData *condData;
+
+/* Parse tree nodes keep one of these on the stack while they apply an
+ * operator, so a failed construction can say what it was doing. A context
+ * with a definition name only marks the machine definition being walked. */
+struct FsmOpContext
+{
+	FsmOpContext( const char *defName );
+	FsmOpContext( const InputLoc &loc, const char *opName,
+			FsmAp *lhs, FsmAp *rhs = 0 );
+	~FsmOpContext();
+
+	const char *defName;
+	InputLoc loc;
+	const char *opName;
+	long lhsStates;
+	long rhsStates;
+
+	FsmOpContext *prev;
+};
+
+extern THREAD_LOCAL FsmOpContext *fsmOpContext;
 
 struct FsmConstructFail
 {
 	enum Reason
 	{
-		CondNoKeySpace
+		CondNoKeySpace,
+		StateLimit,
+		MemoryLimit
 	};
 
-	FsmConstructFail( Reason reason ) 
-		: reason(reason) {}
+	FsmConstructFail( Reason reason );
 	Reason reason;
+
+	/* Innermost definition and operation under way when thrown. The op
+	 * name is null if no operator was being applied. */
+	const char *defName;
+	InputLoc opLoc;
+	const char *opName;
+	long lhsStates;
+	long rhsStates;
 };
 
 /* State class that implements actions and priorities. */
@@ -767,6 +906,8 @@ struct StateAp
 
 	/* Set of longest match items that may be active in this state. */
 	LmItemSet lmItemSet;
+
+	FSM_SLAB_ALLOC( StateAp, FsmSlabState )
 };
 
 template <class ListItem> struct NextTrans
@@ -1211,6 +1352,9 @@ struct FsmAp
 	/* Walk the list of states and verify state properties. */
 	void verifyStates();
 
+	/* Throw when the machine outgrows the construction limits. */
+	void checkLimits();
+
 	/* Misfit Accounting. Are misfits put on a separate list. */
 	void setMisfitAccounting( bool val ) 
 		{ misfitAccounting = val; }
@@ -1469,9 +1613,13 @@ struct FsmAp
 	void minimizePartition1();
 	void minimizePartition2();
 
+	/* Minimization by Hopcroft's algorithm. Uses O(m) space for m labelled
+	 * transitions and O(m log n) time. */
+	void minimizeHopcroft();
+
 	/* Minimize the final state Machine. The result is the minimal fsm. Slow
-	 * but stable, correct minimization. Uses n^2 space (lookout) and average
-	 * n^2 time. Worst case n^3 time, but a that is a very rare case. */
+	 * but stable, correct minimization. Uses n^2/2 bits of space (lookout)
+	 * and average n^2 time. Worst case n^3 time, but a that is a very rare case. */
 	void minimizeStable();
 
 	/* Minimize the final state machine. Does not find the minimal fsm, but a
@@ -1500,8 +1648,14 @@ struct FsmAp
 	void initialMarkRound( MarkIndex &markIndex );
 
 	/* One marking round on all state pairs. Considers if trans pairs go
-	 * to a marked state only. Returns whether or not a pair was marked. */
-	bool markRound( MarkIndex &markIndex );
+	 * to a marked state only. Pairs that get marked are added to the work
+	 * list. Returns whether or not a pair was marked. */
+	bool markRound( MarkIndex &markIndex, MarkPairVect &workList );
+
+	/* Drain the work list of marked pairs. Only the pairs of states with
+	 * transitions into a newly marked pair are reconsidered. */
+	void markFromWorkList( MarkIndex &markIndex, StateAp **statePtrs,
+			MarkPairVect &workList );
 
 	/* Move the in trans into src into dest. */
 	void inTransMove(StateAp *dest, StateAp *src);
@@ -1513,6 +1667,12 @@ struct FsmAp
 	 * merge them into the primary states of their equivalence class. */
 	void fuseUnmarkedPairs( MarkIndex &markIndex );
 
+	/* Remove conditions whose two senses lead to the same transition. */
+	void findRedundantConds( Vector<CondPiece> &pieces, StateAp *state,
+			StateCond *stateCond );
+	void removeRedundantConds( StateAp *state );
+	void removeTautologicalConds();
+
 	/* Merge neighboring transitions go to the same state and have the same
 	 * transitions data. */
 	void compressTransitions();
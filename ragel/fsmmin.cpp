@@ -19,6 +19,7 @@
  *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA 
  */
 
+#include <string.h>
 #include "fsmgraph.h"
 #include "mergesort.h"
 
@@ -340,6 +341,342 @@ void FsmAp::minimizePartition2()
 	delete[] parts;
 }
 
+/* Refinable partition of the integers 0 .. size-1. The elements of each set
+ * are kept contiguous in the elements array, with the marked elements of a
+ * set at its front. Splitting a set costs time proportional to the smaller
+ * of the two halves. Used by the Hopcroft minimization, once for states and
+ * once for transitions. */
+struct RefinablePartition
+{
+	RefinablePartition( int size );
+	~RefinablePartition();
+
+	void mark( int el );
+	void split();
+
+	int numSets;
+
+	/* Elements ordered by set and the position of each element. */
+	int *elements;
+	int *location;
+
+	/* The set each element is in, and the bounds of each set. */
+	int *setOf;
+	int *first;
+	int *past;
+
+	/* Number of marked elements in each set, and the sets with marks. */
+	int *marked;
+	int *touched;
+	int numTouched;
+};
+
+RefinablePartition::RefinablePartition( int size )
+:
+	numSets(0),
+	numTouched(0)
+{
+	/* One extra so that an empty partition still allocates. */
+	elements = new int[size+1];
+	location = new int[size+1];
+	setOf = new int[size+1];
+	first = new int[size+1];
+	past = new int[size+1];
+	marked = new int[size+1];
+	touched = new int[size+1];
+
+	for ( int i = 0; i < size; i++ ) {
+		elements[i] = location[i] = i;
+		setOf[i] = 0;
+		marked[i] = 0;
+	}
+}
+
+RefinablePartition::~RefinablePartition()
+{
+	delete[] elements;
+	delete[] location;
+	delete[] setOf;
+	delete[] first;
+	delete[] past;
+	delete[] marked;
+	delete[] touched;
+}
+
+/* Move an element into the marked front of its set. Each element must be
+ * marked at most once between splits. */
+void RefinablePartition::mark( int el )
+{
+	int set = setOf[el], pos = location[el], dest = first[set] + marked[set];
+
+	elements[pos] = elements[dest];
+	location[elements[pos]] = pos;
+	elements[dest] = el;
+	location[el] = dest;
+
+	if ( marked[set]++ == 0 )
+		touched[numTouched++] = set;
+}
+
+/* Split every touched set into its marked and unmarked elements. The smaller
+ * of the two halves becomes the new set. */
+void RefinablePartition::split()
+{
+	while ( numTouched > 0 ) {
+		int set = touched[--numTouched];
+		int mid = first[set] + marked[set];
+
+		/* If every element was marked there is nothing to split off. */
+		if ( mid == past[set] ) {
+			marked[set] = 0;
+			continue;
+		}
+
+		if ( marked[set] <= past[set] - mid ) {
+			first[numSets] = first[set];
+			past[numSets] = first[set] = mid;
+		}
+		else {
+			past[numSets] = past[set];
+			first[numSets] = past[set] = mid;
+		}
+
+		for ( int i = first[numSets]; i < past[numSets]; i++ )
+			setOf[elements[i]] = numSets;
+
+		marked[set] = marked[numSets] = 0;
+		numSets += 1;
+	}
+}
+
+/* A labelled transition used by the Hopcroft minimization. Labels are local
+ * to an initial partition. */
+struct HopcroftTrans
+{
+	HopcroftTrans( int tail, int head, int label )
+		: tail(tail), head(head), label(label) { }
+
+	int tail, head, label;
+};
+
+typedef Vector<HopcroftTrans> HopcroftTransVect;
+
+/* The last transition of the run that starts at trans: the following
+ * transitions that are adjacent to it and go to the same state. The states of
+ * an initial partition have the same transition data at every key, so only
+ * the targets need to tell runs apart. */
+static TransAp *hopcroftRunEnd( TransAp *trans )
+{
+	while ( trans->next != 0 && trans->next->toState == trans->toState ) {
+		Key nextKey = trans->highKey;
+		nextKey.increment();
+		if ( !( nextKey == trans->next->lowKey ) )
+			break;
+		trans = trans->next;
+	}
+	return trans;
+}
+
+/**
+ * \brief Minimize by Hopcroft's partition refinement.
+ *
+ * Begins with the same initial partitioning as the other partition
+ * minimizations. Within each initial partition the states cover the same
+ * keys, so the key space of the partition is cut into the ranges that start
+ * at any run of a state's transitions to one target, and each range becomes
+ * a label. Transitions are then refined alongside states (Valmari and
+ * Lehtinen), always splitting off the smaller half. Produces the most
+ * minimal FSM possible.
+ *
+ * Runs in O(m log n) for m labelled transitions. A run gets a label for
+ * every range of its partition it covers, so when the states of a partition
+ * cut a wide alphabet at many different points, m approaches the number of
+ * states times the number of cuts. The cuts grammar of make bench-compile
+ * measures that case.
+ */
+void FsmAp::minimizeHopcroft()
+{
+	/* Need a mergesort and an initial partition compare. */
+	MergeSort<StateAp*, InitPartitionCompare> mergeSort;
+	InitPartitionCompare initPartCompare;
+
+	/* Nothing to do if there are no states. */
+	if ( stateList.length() == 0 )
+		return;
+
+	/* Make a array of pointers to states, sorted into initial partitions. */
+	int numStates = stateList.length();
+	StateAp** statePtrs = new StateAp*[numStates];
+
+	StateList::Iter state = stateList;
+	for ( int s = 0; state.lte(); state++, s++ )
+		statePtrs[s] = state;
+
+	mergeSort.sort( statePtrs, numStates );
+
+	/* States are identified by their position in the sorted array. */
+	for ( int s = 0; s < numStates; s++ )
+		statePtrs[s]->alg.stateNum = s;
+
+	/* The state partition starts as the initial partitioning. */
+	RefinablePartition blocks( numStates );
+	for ( int s = 0; s < numStates; s++ ) {
+		if ( s == 0 || initPartCompare.compare( statePtrs[s-1], statePtrs[s] ) < 0 ) {
+			if ( s > 0 )
+				blocks.past[blocks.numSets++] = s;
+			blocks.first[blocks.numSets] = s;
+		}
+		blocks.setOf[s] = blocks.numSets;
+	}
+	blocks.past[blocks.numSets++] = numStates;
+
+	/* Label the transitions. Each initial partition gets one label per range
+	 * of its key space and one for the eof target. */
+	MergeSort<Key, CmpKey> keySort;
+	HopcroftTransVect transVect;
+	Vector<Key> keys;
+	int numLabels = 0;
+	for ( int b = 0; b < blocks.numSets; b++ ) {
+		keys.empty();
+		for ( int s = blocks.first[b]; s < blocks.past[b]; s++ ) {
+			TransAp *trans = statePtrs[s]->outList.head;
+			for ( ; trans != 0; trans = hopcroftRunEnd( trans )->next )
+				keys.append( trans->lowKey );
+		}
+
+		/* Sort the low keys and remove duplicates. */
+		keySort.sort( keys.data, keys.length() );
+		int numKeys = 0;
+		for ( int k = 0; k < keys.length(); k++ ) {
+			if ( numKeys == 0 || keys[numKeys-1] < keys[k] )
+				keys[numKeys++] = keys[k];
+		}
+
+		for ( int s = blocks.first[b]; s < blocks.past[b]; s++ ) {
+			StateAp *st = statePtrs[s];
+			TransAp *next;
+			for ( TransAp *trans = st->outList.head; trans != 0; trans = next ) {
+				TransAp *last = hopcroftRunEnd( trans );
+				next = last->next;
+
+				/* Transitions to the error state are left out. */
+				if ( trans->toState == 0 )
+					continue;
+
+				/* Find the first range of the transition. */
+				int low = 0, high = numKeys;
+				while ( low < high ) {
+					int mid = (low + high) / 2;
+					if ( keys[mid] < trans->lowKey )
+						low = mid + 1;
+					else
+						high = mid;
+				}
+
+				for ( int k = low; k < numKeys && keys[k] <= last->highKey; k++ ) {
+					transVect.append( HopcroftTrans( s,
+							trans->toState->alg.stateNum, numLabels + k ) );
+				}
+			}
+
+			if ( st->eofTarget != 0 ) {
+				transVect.append( HopcroftTrans( s,
+						st->eofTarget->alg.stateNum, numLabels + numKeys ) );
+			}
+		}
+
+		numLabels += numKeys + 1;
+	}
+
+	/* The transition partition starts with one set per label. Bucket the
+	 * transitions by label. */
+	int numTrans = transVect.length();
+	RefinablePartition cords( numTrans );
+	int *labelPos = new int[numLabels+1];
+	memset( labelPos, 0, sizeof(int) * (numLabels+1) );
+	for ( int t = 0; t < numTrans; t++ )
+		labelPos[transVect[t].label+1] += 1;
+	for ( int l = 0; l < numLabels; l++ ) {
+		if ( labelPos[l+1] > 0 ) {
+			cords.first[cords.numSets] = labelPos[l];
+			cords.past[cords.numSets] = labelPos[l] + labelPos[l+1];
+			cords.numSets += 1;
+		}
+		labelPos[l+1] += labelPos[l];
+	}
+	for ( int t = 0; t < numTrans; t++ ) {
+		int pos = labelPos[transVect[t].label]++;
+		cords.elements[pos] = t;
+		cords.location[t] = pos;
+	}
+	for ( int c = 0; c < cords.numSets; c++ ) {
+		for ( int i = cords.first[c]; i < cords.past[c]; i++ )
+			cords.setOf[cords.elements[i]] = c;
+	}
+	delete[] labelPos;
+
+	/* Index the transitions by the state they go into. */
+	int *inFirst = new int[numStates+1];
+	int *inTrans = new int[numTrans+1];
+	memset( inFirst, 0, sizeof(int) * (numStates+1) );
+	for ( int t = 0; t < numTrans; t++ )
+		inFirst[transVect[t].head+1] += 1;
+	for ( int s = 0; s < numStates; s++ )
+		inFirst[s+1] += inFirst[s];
+	for ( int t = 0; t < numTrans; t++ )
+		inTrans[inFirst[transVect[t].head]++] = t;
+	for ( int s = numStates; s > 0; s-- )
+		inFirst[s] = inFirst[s-1];
+	inFirst[0] = 0;
+
+	/* Split blocks by the tails of each cord, then split cords by the heads
+	 * of each new block. Every block except the first one needs to be used
+	 * as a splitter. */
+	int b = 1, c = 0;
+	while ( c < cords.numSets ) {
+		for ( int i = cords.first[c]; i < cords.past[c]; i++ )
+			blocks.mark( transVect[cords.elements[i]].tail );
+		blocks.split();
+		c += 1;
+
+		while ( b < blocks.numSets ) {
+			for ( int i = blocks.first[b]; i < blocks.past[b]; i++ ) {
+				int s = blocks.elements[i];
+				for ( int t = inFirst[s]; t < inFirst[s+1]; t++ )
+					cords.mark( inTrans[t] );
+			}
+			cords.split();
+			b += 1;
+		}
+	}
+
+	delete[] inFirst;
+	delete[] inTrans;
+
+	/* Move the states into their final partitions. */
+	int numParts = blocks.numSets;
+	MinPartition *parts = new MinPartition[numParts];
+	for ( int p = 0; p < numParts; p++ ) {
+		for ( int i = blocks.first[p]; i < blocks.past[p]; i++ ) {
+			StateAp *st = statePtrs[blocks.elements[i]];
+			st->alg.partition = &parts[p];
+			parts[p].list.append( st );
+		}
+	}
+
+	/* We just moved all the states from the main list into partitions without
+	 * taking them off the main list. So clean up the main list now. */
+	stateList.abandon();
+
+	/* Fuse states in the same partition. The states will end up back on the
+	 * main list. */
+	fusePartitions( parts, numParts );
+
+	/* Cleanup. */
+	delete[] statePtrs;
+	delete[] parts;
+}
+
 void FsmAp::initialMarkRound( MarkIndex &markIndex )
 {
 	/* P and q for walking pairs. */
@@ -366,7 +703,7 @@ void FsmAp::initialMarkRound( MarkIndex &markIndex )
 	}
 }
 
-bool FsmAp::markRound( MarkIndex &markIndex )
+bool FsmAp::markRound( MarkIndex &markIndex, MarkPairVect &workList )
 {
 	/* P an q for walking pairs. Take note if any pair gets marked. */
 	StateAp *p = stateList.head, *q;
@@ -385,6 +722,7 @@ bool FsmAp::markRound( MarkIndex &markIndex )
 			if ( !markIndex.isPairMarked( p->alg.stateNum, q->alg.stateNum ) ) {
 				if ( markCompare.shouldMark( markIndex, p, q ) ) {
 					markIndex.markPair( p->alg.stateNum, q->alg.stateNum );
+					workList.append( MarkPair( p->alg.stateNum, q->alg.stateNum ) );
 					pairWasMarked = true;
 				}
 			}
@@ -396,12 +734,47 @@ bool FsmAp::markRound( MarkIndex &markIndex )
 	return pairWasMarked;
 }
 
+void FsmAp::markFromWorkList( MarkIndex &markIndex, StateAp **statePtrs,
+		MarkPairVect &workList )
+{
+	/* Need a mark comparison. */
+	MarkCompare markCompare;
+
+	while ( workList.length() > 0 ) {
+		/* Pull the last marked pair. */
+		MarkPair pair = workList[workList.length()-1];
+		workList.remove( workList.length()-1 );
+
+		StateAp *r = statePtrs[pair.state1];
+		StateAp *s = statePtrs[pair.state2];
+
+		/* Any pair (p, q) with transitions into (r, s) may now need to be
+		 * marked. The transitions need not be on the same keys, shouldMark
+		 * sorts that out. */
+		for ( TransInList::Iter t1 = r->inList; t1.lte(); t1++ ) {
+			StateAp *p = t1->fromState;
+			for ( TransInList::Iter t2 = s->inList; t2.lte(); t2++ ) {
+				StateAp *q = t2->fromState;
+				if ( p == q || markIndex.isPairMarked( p->alg.stateNum, q->alg.stateNum ) )
+					continue;
+
+				if ( markCompare.shouldMark( markIndex, p, q ) ) {
+					markIndex.markPair( p->alg.stateNum, q->alg.stateNum );
+					workList.append( MarkPair( p->alg.stateNum, q->alg.stateNum ) );
+				}
+			}
+		}
+	}
+}
+
 
 /**
  * \brief Minimize by pair marking.
  *
- * Decides if each pair of states is distinct or not. Uses O(n^2) memory and
- * should only be used on small graphs. Produces the most minmimal FSM
+ * Decides if each pair of states is distinct or not. Uses one bit for each
+ * pair of states and should only be used on small to medium graphs. After
+ * the initial round and one sweep over all pairs, only pairs leading into
+ * a newly marked pair are reconsidered. Produces the most minmimal FSM
  * possible.
  */
 void FsmAp::minimizeStable()
@@ -409,20 +782,27 @@ void FsmAp::minimizeStable()
 	/* Set the state numbers. */
 	setStateNumbers( 0 );
 
+	/* Map state numbers back to states for the work list. */
+	StateAp **statePtrs = new StateAp*[stateList.length()];
+	for ( StateList::Iter state = stateList; state.lte(); state++ )
+		statePtrs[state->alg.stateNum] = state;
+
 	/* This keeps track of which pairs have been marked. */
 	MarkIndex markIndex( stateList.length() );
 
 	/* Mark pairs where final stateness, out trans, or trans data differ. */
 	initialMarkRound( markIndex );
 
-	/* While the last round of marking succeeded in marking a state
-	 * continue to do another round. */
-	int modified = markRound( markIndex );
-	while (modified)
-		modified = markRound( markIndex );
+	/* Sweep once to pick up pairs leading into the initially marked pairs,
+	 * then follow newly marked pairs back to their predecessors. */
+	MarkPairVect workList;
+	markRound( markIndex, workList );
+	markFromWorkList( markIndex, statePtrs, workList );
 
 	/* Merge pairs that are unmarked. */
 	fuseUnmarkedPairs( markIndex );
+
+	delete[] statePtrs;
 }
 
 bool FsmAp::minimizeRound()
@@ -704,6 +1084,318 @@ void FsmAp::fusePartitions( MinPartition *parts, int numParts )
 }
 
 
+/* The part of a transition that lies in one value block of a state condition
+ * range, in character space. */
+struct CondTransPiece
+{
+	long vals;
+	Key lowKey, highKey;
+	TransAp *trans;
+};
+
+/* A sub-range of a state condition range, in character space, and the
+ * conditions that make no difference in it. */
+struct CondPiece
+{
+	StateCond *stateCond;
+	Key lowKey, highKey;
+	long redundant;
+	CondSpace *toCondSpace;
+};
+
+/* Compares target state and transition data. Either pointer may be null. */
+static bool sameTrans( TransAp *trans1, TransAp *trans2 )
+{
+	if ( trans1 == 0 || trans2 == 0 )
+		return trans1 == trans2;
+	return trans1->toState == trans2->toState &&
+			FsmAp::compareTransData( trans1, trans2 ) == 0;
+}
+
+struct CmpTransLowKey
+{
+	static int compare( const TransAp *trans1, const TransAp *trans2 )
+		{ return CmpKey::compare( trans1->lowKey, trans2->lowKey ); }
+};
+
+/* Break a state condition range into pieces wherever the transitions in any
+ * of its value blocks change and find the conditions that are redundant in
+ * each piece. A condition is redundant when flipping it never changes the
+ * transition taken. Neighbouring pieces with the same redundant conditions
+ * are joined. */
+void FsmAp::findRedundantConds( Vector<CondPiece> &pieces, StateAp *state,
+		StateCond *stateCond )
+{
+	CondSpace *condSpace = stateCond->condSpace;
+	long numConds = condSpace->condSet.length();
+	long numVals = 1 << numConds;
+	Size alphSize = keyOps->alphSize();
+
+	/* Clip the transitions to the blocks of the range. */
+	Vector<CondTransPiece> transPieces;
+	Vector<Key> keys;
+	keys.append( stateCond->lowKey );
+	for ( long vals = 0; vals < numVals; vals++ ) {
+		Key blockBase = condSpace->baseKey + vals * alphSize;
+		Key blockLow = blockBase + (stateCond->lowKey - keyOps->minKey);
+		Key blockHigh = blockBase + (stateCond->highKey - keyOps->minKey);
+		for ( TransList::Iter trans = state->outList; trans.lte(); trans++ ) {
+			if ( trans->highKey < blockLow )
+				continue;
+			if ( trans->lowKey > blockHigh )
+				break;
+
+			CondTransPiece piece;
+			piece.vals = vals;
+			piece.lowKey = ( trans->lowKey < blockLow ? blockLow : trans->lowKey ) -
+					blockBase + keyOps->minKey;
+			piece.highKey = ( trans->highKey > blockHigh ? blockHigh : trans->highKey ) -
+					blockBase + keyOps->minKey;
+			piece.trans = trans;
+			transPieces.append( piece );
+
+			keys.append( piece.lowKey );
+			if ( piece.highKey < stateCond->highKey ) {
+				Key next = piece.highKey;
+				next.increment();
+				keys.append( next );
+			}
+		}
+	}
+
+	/* Sort the piece boundaries and remove duplicates. */
+	MergeSort<Key, CmpKey> keySort;
+	keySort.sort( keys.data, keys.length() );
+	int numKeys = 0;
+	for ( int k = 0; k < keys.length(); k++ ) {
+		if ( numKeys == 0 || keys[numKeys-1] < keys[k] )
+			keys[numKeys++] = keys[k];
+	}
+
+	/* The transition taken in each piece for each value of the conditions. */
+	Vector<TransAp*> pieceTrans;
+	pieceTrans.setAsNew( numKeys * numVals );
+	for ( int p = 0; p < numKeys * numVals; p++ )
+		pieceTrans[p] = 0;
+	for ( Vector<CondTransPiece>::Iter tp = transPieces; tp.lte(); tp++ ) {
+		int low = 0, high = numKeys;
+		while ( low < high ) {
+			int mid = (low + high) / 2;
+			if ( keys[mid] < tp->lowKey )
+				low = mid + 1;
+			else
+				high = mid;
+		}
+
+		for ( int k = low; k < numKeys && keys[k] <= tp->highKey; k++ )
+			pieceTrans[k * numVals + tp->vals] = tp->trans;
+	}
+
+	for ( int k = 0; k < numKeys; k++ ) {
+		TransAp **transForVals = pieceTrans.data + k * numVals;
+		long redundant = 0;
+		for ( long c = 0; c < numConds; c++ ) {
+			long bit = 1 << c;
+			bool same = true;
+			for ( long vals = 0; same && vals < numVals; vals++ ) {
+				if ( !( vals & bit ) && !sameTrans( transForVals[vals],
+						transForVals[vals | bit] ) )
+					same = false;
+			}
+			if ( same )
+				redundant |= bit;
+		}
+
+		Key highKey = stateCond->highKey;
+		if ( k + 1 < numKeys ) {
+			highKey = keys[k+1];
+			highKey.decrement();
+		}
+
+		if ( k > 0 && pieces[pieces.length()-1].redundant == redundant )
+			pieces[pieces.length()-1].highKey = highKey;
+		else {
+			CondPiece piece;
+			piece.stateCond = stateCond;
+			piece.lowKey = keys[k];
+			piece.highKey = highKey;
+			piece.redundant = redundant;
+			piece.toCondSpace = condSpace;
+			pieces.append( piece );
+		}
+	}
+}
+
+/* Find the piece a key in condition space falls in. Sets the condition
+ * values and the key in character space. A key in no piece is given no
+ * condition values and is its own character key. */
+static CondPiece *findCondPiece( Vector<CondPiece> &pieces, Key key,
+		long &vals, Key &charKey )
+{
+	long alphSize = keyOps->alphSize();
+	for ( Vector<CondPiece>::Iter piece = pieces; piece.lte(); piece++ ) {
+		CondSpace *condSpace = piece->stateCond->condSpace;
+		long offset = ( key - condSpace->baseKey ).getVal();
+		if ( key < condSpace->baseKey || offset >= 
+				( 1 << condSpace->condSet.length() ) * alphSize )
+			continue;
+
+		vals = offset / alphSize;
+		charKey = key - condSpace->baseKey - vals * alphSize + keyOps->minKey;
+		if ( piece->lowKey <= charKey && charKey <= piece->highKey )
+			return piece;
+	}
+
+	vals = 0;
+	charKey = key;
+	return 0;
+}
+
+/* Drop the redundant conditions from the state condition ranges of a state.
+ * Transitions are moved into the smaller condition space, or into character
+ * space when no conditions remain. Those for the other sense of a dropped
+ * condition are deleted. */
+void FsmAp::removeRedundantConds( StateAp *state )
+{
+	Vector<CondPiece> pieces;
+	for ( StateCondList::Iter sc = state->stateCondList; sc.lte(); sc++ )
+		findRedundantConds( pieces, state, sc );
+
+	bool anyRedundant = false;
+	for ( Vector<CondPiece>::Iter piece = pieces; piece.lte(); piece++ ) {
+		if ( piece->redundant != 0 ) {
+			CondSet remaining;
+			CondSet &condSet = piece->stateCond->condSpace->condSet;
+			for ( CondSet::Iter csi = condSet; csi.lte(); csi++ ) {
+				if ( !( piece->redundant & (1 << csi.pos()) ) )
+					remaining.insert( *csi );
+			}
+			piece->toCondSpace = remaining.length() > 0 ?
+					addCondSpace( remaining ) : 0;
+			anyRedundant = true;
+		}
+	}
+
+	if ( !anyRedundant )
+		return;
+
+	/* Rekey the transitions. */
+	Vector<TransAp*> transPtrs;
+	for ( TransList::Iter trans = state->outList; trans.lte(); trans++ )
+		transPtrs.append( trans );
+	state->outList.abandon();
+
+	Vector<TransAp*> newTrans;
+	long alphSize = keyOps->alphSize();
+	for ( Vector<TransAp*>::Iter tp = transPtrs; tp.lte(); tp++ ) {
+		TransAp *trans = *tp;
+		if ( trans->lowKey <= keyOps->maxKey ) {
+			newTrans.append( trans );
+			continue;
+		}
+
+		Key lowKey = trans->lowKey, highKey = trans->highKey;
+		bool used = false;
+		while ( true ) {
+			long vals;
+			Key charKey;
+			CondPiece *piece = findCondPiece( pieces, lowKey, vals, charKey );
+
+			Key charHigh, newLow;
+			if ( piece == 0 ) {
+				/* Not in any condition range. Leave it be. */
+				charHigh = charKey + ( highKey - lowKey );
+				newLow = lowKey;
+			}
+			else {
+				charHigh = piece->highKey;
+				if ( charKey + ( highKey - lowKey ) < charHigh )
+					charHigh = charKey + ( highKey - lowKey );
+
+				if ( piece->redundant == 0 )
+					newLow = lowKey;
+				else if ( piece->toCondSpace == 0 )
+					newLow = charKey;
+				else {
+					/* Pack down the values of the remaining conditions. */
+					long newVals = 0, newBit = 0;
+					CondSet &condSet = piece->stateCond->condSpace->condSet;
+					for ( long c = 0; c < condSet.length(); c++ ) {
+						if ( !( piece->redundant & (1 << c) ) ) {
+							if ( vals & (1 << c) )
+								newVals |= 1 << newBit;
+							newBit += 1;
+						}
+					}
+					newLow = piece->toCondSpace->baseKey + newVals * alphSize +
+							(charKey - keyOps->minKey);
+				}
+			}
+
+			if ( piece == 0 || !( vals & piece->redundant ) ) {
+				TransAp *dest = used ? dupTrans( state, trans ) : trans;
+				dest->lowKey = newLow;
+				dest->highKey = newLow + ( charHigh - charKey );
+				newTrans.append( dest );
+				used = true;
+			}
+
+			Key consumed = lowKey + ( charHigh - charKey );
+			if ( consumed >= highKey )
+				break;
+			lowKey = consumed;
+			lowKey.increment();
+		}
+
+		if ( !used ) {
+			detachTrans( state, trans->toState, trans );
+			delete trans;
+		}
+	}
+
+	MergeSort<TransAp*, CmpTransLowKey> transSort;
+	transSort.sort( newTrans.data, newTrans.length() );
+	for ( Vector<TransAp*>::Iter tp = newTrans; tp.lte(); tp++ )
+		state->outList.append( *tp );
+
+	/* Rebuild the state condition ranges. */
+	StateCondList stateCondList;
+	for ( Vector<CondPiece>::Iter piece = pieces; piece.lte(); piece++ ) {
+		if ( piece->toCondSpace == 0 )
+			continue;
+
+		StateCond *last = stateCondList.tail;
+		Key lastHigh;
+		if ( last != 0 ) {
+			lastHigh = last->highKey;
+			lastHigh.increment();
+		}
+
+		if ( last != 0 && last->condSpace == piece->toCondSpace &&
+				lastHigh == piece->lowKey )
+			last->highKey = piece->highKey;
+		else {
+			StateCond *stateCond = new StateCond( piece->lowKey, piece->highKey );
+			stateCond->condSpace = piece->toCondSpace;
+			stateCondList.append( stateCond );
+		}
+	}
+	state->stateCondList.empty();
+	state->stateCondList.transfer( stateCondList );
+}
+
+/* Conditions are expanded before priorities resolve nondeterminism, which
+ * can leave transitions that test a condition only to go to the same place
+ * either way. Remove these conditions. Must be called after priorities are
+ * cleared. */
+void FsmAp::removeTautologicalConds()
+{
+	for ( StateList::Iter st = stateList; st.lte(); st++ ) {
+		if ( st->stateCondList.length() > 0 )
+			removeRedundantConds( st );
+	}
+}
+
 /* Merge neighboring transitions go to the same state and have the same
  * transitions data. */
 void FsmAp::compressTransitions()
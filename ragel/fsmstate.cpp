@@ -27,17 +27,17 @@
 using namespace std;
 
 /* Construct a mark index for a specified number of states. Must new up
- * an array that is states^2 in size. */
+ * one bit for each unordered pair of distinct states. */
 MarkIndex::MarkIndex( int states ) : numStates(states)
 {
-	/* Total pairs is states^2. Actually only use half of these, but we allocate
-	 * them all to make indexing into the array easier. */
-	int total = states * states;
-
-	/* New up chars so that individual DListEl constructors are
-	 * not called. Zero out the mem manually. */
-	array = new bool[total];
-	memset( array, 0, sizeof(bool) * total );
+	/* Total pairs is states * (states-1) / 2. Sized with 64 bit arithmetic
+	 * so large graphs do not overflow. */
+	Size total = (Size)states * (Size)(states > 0 ? states - 1 : 0) / 2;
+	Size bytes = ( total + 7 ) / 8;
+
+	/* New up chars and zero out the mem manually. */
+	array = new unsigned char[bytes];
+	memset( array, 0, bytes );
 }
 
 /* Free the array used to store state pairs. */
@@ -46,26 +46,33 @@ MarkIndex::~MarkIndex()
 	delete[] array;
 }
 
-/* Mark a pair of states. States are specified by their number. The
- * marked states are moved from the unmarked list to the marked list. */
-void MarkIndex::markPair(int state1, int state2)
+/* Position of the bit for a pair of distinct states in the lower triangle.
+ * Ordering of states given does not matter. */
+Size MarkIndex::pairPos( int state1, int state2 )
 {
-	int pos = ( state1 >= state2 ) ?
-		( state1 * numStates ) + state2 :
-		( state2 * numStates ) + state1;
+	Size high = state1 > state2 ? state1 : state2;
+	Size low = state1 > state2 ? state2 : state1;
+	return high * (high - 1) / 2 + low;
+}
 
-	array[pos] = true;
+/* Mark a pair of states. States are specified by their number. */
+void MarkIndex::markPair(int state1, int state2)
+{
+	assert( state1 != state2 );
+	Size pos = pairPos( state1, state2 );
+	array[pos >> 3] |= 1 << (pos & 7);
 }
 
 /* Returns true if the pair of states are marked. Returns false otherwise.
- * Ordering of states given does not matter. */
+ * Ordering of states given does not matter. A state is never marked against
+ * itself. */
 bool MarkIndex::isPairMarked(int state1, int state2)
 {
-	int pos = ( state1 >= state2 ) ?
-		( state1 * numStates ) + state2 :
-		( state2 * numStates ) + state1;
+	if ( state1 == state2 )
+		return false;
 
-	return array[pos];
+	Size pos = pairPos( state1, state2 );
+	return ( array[pos >> 3] & ( 1 << (pos & 7) ) ) != 0;
 }
 
 /* Create a new fsm state. State has not out transitions or in transitions, not
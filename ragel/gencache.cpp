@@ -0,0 +1,636 @@
+/*
+ *  Copyright 2010 Adrian Thurston <thurston@complang.org>
+ */
+
+/*  This file is part of Ragel.
+ *
+ *  Ragel is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Ragel is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Ragel; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+#include "ragel.h"
+#include "gencache.h"
+#include "parsedata.h"
+#include "gendata.h"
+#include "version.h"
+
+using std::ostream;
+using std::ostringstream;
+using std::ifstream;
+using std::ofstream;
+using std::string;
+
+/* Bump when the layout of entries changes. */
+#define CACHE_FORMAT "3"
+
+/* The inline list expressions of the code generator, in the order they are
+ * stored in an entry. */
+#define NUM_CACHED_EXPRS 15
+
+static GenInlineList **cachedExpr( CodeGenData *cgd, int which )
+{
+	switch ( which ) {
+		case 0: return &cgd->getKeyExpr;
+		case 1: return &cgd->accessExpr;
+		case 2: return &cgd->prePushExpr;
+		case 3: return &cgd->postPopExpr;
+		case 4: return &cgd->pExpr;
+		case 5: return &cgd->peExpr;
+		case 6: return &cgd->eofExpr;
+		case 7: return &cgd->csExpr;
+		case 8: return &cgd->topExpr;
+		case 9: return &cgd->stackExpr;
+		case 10: return &cgd->actExpr;
+		case 11: return &cgd->tokstartExpr;
+		case 12: return &cgd->tokendExpr;
+		case 13: return &cgd->dataExpr;
+		case 14: return &cgd->countersExpr;
+	}
+	return 0;
+}
+
+/* 64 bit FNV-1a. */
+void cacheHashBytes( CacheHash &hash, const void *data, long len )
+{
+	const unsigned char *bytes = (const unsigned char*)data;
+	for ( long i = 0; i < len; i++ ) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+}
+
+/* Called by the parser for every token it receives. Tokens from included and
+ * imported files arrive here too, so the hash covers everything the parse
+ * tree is built from. Locations are included because they end up in the
+ * generated code. */
+void ParseData::hashToken( const InputLoc &loc, int tokId, const char *data, int len )
+{
+	cacheHashBytes( inputHash, &tokId, sizeof(tokId) );
+	cacheHashBytes( inputHash, &len, sizeof(len) );
+	if ( len > 0 )
+		cacheHashBytes( inputHash, data, len );
+
+	cacheHashBytes( inputHash, &loc.line, sizeof(loc.line) );
+	cacheHashBytes( inputHash, &loc.col, sizeof(loc.col) );
+	if ( loc.fileName != 0 )
+		cacheHashBytes( inputHash, loc.fileName, strlen(loc.fileName) + 1 );
+}
+
+/* Look for the reduced machine of this specification in the cache directory.
+ * On a hit the machine is not constructed, only the key ops are prepared. */
+bool ParseData::findCachedMachine()
+{
+	/* Only code generation runs use the cache, and it is consulted once per
+	 * specification. If a found entry cannot be loaded the machine is built
+	 * and the entry written again. Profiling needs the machine built. */
+	if ( cacheDir == 0 || profileCompile || phaseTimesOpt || generateDot || ::generateXML || cacheFile.length() > 0 )
+		return false;
+
+	/* Combine the input with the options that affect the reduced machine. */
+	CacheHash hash = inputHash;
+	int options[] = { hostLang->lang, codeStyle, minimizeLevel,
+			minimizeOpt, wantDupsRemoved, dropCondsOpt };
+	cacheHashBytes( hash, options, sizeof(options) );
+
+	/* A machine built within the limits of one run may exceed those of
+	 * another, so the limits are part of the key too. */
+	long limits[] = { maxStates, maxMemory };
+	cacheHashBytes( hash, limits, sizeof(limits) );
+	cacheHashBytes( hash, sectionName, strlen(sectionName) + 1 );
+	cacheHashBytes( hash, VERSION, strlen(VERSION) + 1 );
+
+	char name[32];
+	sprintf( name, "/%016llx.rlc", hash );
+	cacheFile = string( cacheDir ) + name;
+
+	cacheHit = readGenCache( cacheFile.c_str(), cachedMachine );
+	if ( cacheHit ) {
+		beginProcessing();
+		initKeyOps();
+	}
+	return cacheHit;
+}
+
+bool readGenCache( const char *fileName, string &contents )
+{
+	ifstream in( fileName, std::ios::in | std::ios::binary );
+	if ( ! in.is_open() )
+		return false;
+
+	ostringstream buf;
+	buf << in.rdbuf();
+	contents = buf.str();
+	return contents.length() > 0;
+}
+
+/*
+ * Writing entries. Entries are text. Numbers are separated by whitespace,
+ * strings are written as length:bytes and a dash stands for a null string or
+ * list.
+ */
+
+static void writeStr( ostream &out, const char *str )
+{
+	if ( str == 0 )
+		out << " -";
+	else {
+		long len = strlen( str );
+		out << ' ' << len << ':';
+		out.write( str, len );
+	}
+}
+
+static void writeInlineList( ostream &out, GenInlineList *inlineList )
+{
+	if ( inlineList == 0 ) {
+		out << " -";
+		return;
+	}
+
+	out << ' ' << inlineList->length();
+	for ( GenInlineList::Iter item = *inlineList; item.lte(); item++ ) {
+		out << ' ' << (int)item->type;
+		writeStr( out, item->data );
+		out << ' ' << item->targId << ' ' << item->lmId << ' ' << item->offset <<
+				' ' << item->counterId;
+		writeInlineList( out, item->children );
+	}
+}
+
+static long actionTableId( CodeGenData *cgd, RedAction *action )
+{
+	return action != 0 ? action - cgd->allActionTables : -1;
+}
+
+static long stateId( CodeGenData *cgd, RedStateAp *state )
+{
+	return state != 0 ? state - cgd->allStates : -1;
+}
+
+static void writeMachine( ostream &out, CodeGenData *cgd )
+{
+	RedFsmAp *redFsm = cgd->redFsm;
+
+	out << "alphtype";
+	writeStr( out, cgd->thisKeyOps.alphType->internalName );
+	out << "\nexprs";
+	for ( int e = 0; e < NUM_CACHED_EXPRS; e++ )
+		writeInlineList( out, *cachedExpr( cgd, e ) );
+	out << "\nlm " << ( cgd->hasLongestMatch ? 1 : 0 );
+	out << "\ncounters " << cgd->numCounters;
+
+	out << "\nexports " << cgd->exportList.length();
+	for ( ExportList::Iter ex = cgd->exportList; ex.lte(); ex++ ) {
+		writeStr( out, ex->name );
+		out << ' ' << ex->key.getVal();
+	}
+
+	out << "\nactions " << cgd->actionList.length() << '\n';
+	for ( GenActionList::Iter act = cgd->actionList; act.lte(); act++ ) {
+		writeStr( out, act->name );
+		writeStr( out, act->loc.fileName );
+		out << ' ' << act->loc.line << ' ' << act->loc.col;
+		writeInlineList( out, act->inlineList );
+		out << '\n';
+	}
+
+	/* Every action table went into the action map. */
+	out << "tables " << redFsm->actionMap.length() << '\n';
+	for ( int t = 0; t < redFsm->actionMap.length(); t++ ) {
+		RedAction *redAct = cgd->allActionTables + t;
+		out << redAct->key.length();
+		for ( GenActionTable::Iter item = redAct->key; item.lte(); item++ )
+			out << ' ' << item->key << ' ' << item->value - cgd->allActions;
+		out << '\n';
+	}
+
+	out << "condspaces " << cgd->condSpaceList.length() << '\n';
+	for ( CondSpaceList::Iter cs = cgd->condSpaceList; cs.lte(); cs++ ) {
+		out << cs->condSpaceId << ' ' << cs->baseKey.getVal() <<
+				' ' << cs->condSet.length();
+		for ( GenCondSet::Iter csi = cs->condSet; csi.lte(); csi++ )
+			out << ' ' << *csi - cgd->allActions;
+		out << '\n';
+	}
+
+	out << "start " << cgd->startState << " error " << cgd->errState <<
+			" forced " << ( redFsm->forcedErrorState ? 1 : 0 );
+
+	out << "\nentries " << cgd->entryPointIds.length();
+	for ( int en = 0; en < cgd->entryPointIds.length(); en++ ) {
+		writeStr( out, cgd->entryPointNames[en] );
+		out << ' ' << cgd->entryPointIds[en];
+	}
+
+	out << "\nstates " << redFsm->stateList.length() << '\n';
+	for ( int s = 0; s < redFsm->stateList.length(); s++ ) {
+		RedStateAp *st = cgd->allStates + s;
+		out << st->id << ' ' << ( st->isFinal ? 1 : 0 ) << ' ' <<
+				actionTableId( cgd, st->toStateAction ) << ' ' <<
+				actionTableId( cgd, st->fromStateAction ) << ' ' <<
+				actionTableId( cgd, st->eofAction );
+
+		if ( st->eofTrans == 0 )
+			out << " -";
+		else {
+			out << ' ' << stateId( cgd, st->eofTrans->targ ) << ' ' <<
+					st->eofTrans->action - cgd->allActionTables;
+		}
+
+		out << ' ' << st->stateCondList.length();
+		for ( GenStateCondList::Iter sc = st->stateCondList; sc.lte(); sc++ ) {
+			out << ' ' << sc->lowKey.getVal() << ' ' << sc->highKey.getVal() <<
+					' ' << sc->condSpace - cgd->allCondSpaces;
+		}
+
+		/* Ranges going to the error transition filled gaps. They are left
+		 * out and filled again on loading. */
+		long numRanges = 0;
+		for ( RedTransList::Iter rtel = st->outRange; rtel.lte(); rtel++ ) {
+			if ( rtel->value != redFsm->errTrans )
+				numRanges += 1;
+		}
+
+		out << ' ' << numRanges;
+		for ( RedTransList::Iter rtel = st->outRange; rtel.lte(); rtel++ ) {
+			if ( rtel->value != redFsm->errTrans ) {
+				out << ' ' << rtel->lowKey.getVal() << ' ' << rtel->highKey.getVal() <<
+						' ' << stateId( cgd, rtel->value->targ ) <<
+						' ' << actionTableId( cgd, rtel->value->action );
+			}
+		}
+		out << '\n';
+	}
+}
+
+/* Store the machine collected by the backend generator, before the code
+ * generator starts working on it. Failing to write is not an error. The entry
+ * is written under a temporary name and moved into place so concurrent runs
+ * never see a partial entry. */
+void saveGenCache( const char *fileName, CodeGenData *cgd, const string &diags )
+{
+	ostringstream tmpName;
+	tmpName << fileName << ".tmp" << getpid();
+
+	ofstream out( tmpName.str().c_str(), std::ios::out |
+			std::ios::trunc | std::ios::binary );
+	if ( ! out.is_open() )
+		return;
+
+	out << "ragel-cache " VERSION " " CACHE_FORMAT "\n";
+	out << "diags";
+	writeStr( out, diags.c_str() );
+	out << '\n';
+	writeMachine( out, cgd );
+	out << "end\n";
+	out.close();
+
+	if ( out.fail() || rename( tmpName.str().c_str(), fileName ) != 0 )
+		remove( tmpName.str().c_str() );
+}
+
+/*
+ * Loading entries.
+ */
+
+struct CacheReader
+{
+	CacheReader( const string &contents )
+		: p(contents.c_str()), pe(contents.c_str() + contents.length()), ok(true) {}
+
+	const char *p, *pe;
+	bool ok;
+
+	void skipSpace();
+	void word( const char *expected );
+	bool null();
+	long num();
+	long ref( long limit );
+	char *str();
+	GenInlineList *inlineList();
+};
+
+void CacheReader::skipSpace()
+{
+	while ( p < pe && ( *p == ' ' || *p == '\n' ) )
+		p += 1;
+}
+
+void CacheReader::word( const char *expected )
+{
+	skipSpace();
+	long len = strlen( expected );
+	if ( pe - p >= len && memcmp( p, expected, len ) == 0 )
+		p += len;
+	else
+		ok = false;
+}
+
+/* Consumes the null marker if it is next. */
+bool CacheReader::null()
+{
+	skipSpace();
+	if ( p < pe && *p == '-' && ( p + 1 == pe || p[1] < '0' || p[1] > '9' ) ) {
+		p += 1;
+		return true;
+	}
+	return false;
+}
+
+long CacheReader::num()
+{
+	skipSpace();
+	char *end;
+	long value = strtol( p, &end, 10 );
+	if ( end == p )
+		ok = false;
+	p = end;
+	return value;
+}
+
+/* An index into a table of the given length, or -1. */
+long CacheReader::ref( long limit )
+{
+	long value = num();
+	if ( value < -1 || value >= limit )
+		ok = false;
+	return ok ? value : -1;
+}
+
+char *CacheReader::str()
+{
+	if ( null() )
+		return 0;
+
+	long len = num();
+	if ( !ok || len < 0 || pe - p < len + 1 || *p != ':' ) {
+		ok = false;
+		return 0;
+	}
+
+	char *result = new char[len+1];
+	memcpy( result, p + 1, len );
+	result[len] = 0;
+	p += len + 1;
+	return result;
+}
+
+GenInlineList *CacheReader::inlineList()
+{
+	if ( null() )
+		return 0;
+
+	GenInlineList *result = new GenInlineList;
+	long length = num();
+	for ( long i = 0; ok && i < length; i++ ) {
+		long type = num();
+		if ( type < GenInlineItem::Text || type > GenInlineItem::Counter )
+			ok = false;
+
+		GenInlineItem *item = new GenInlineItem( InputLoc(),
+				(GenInlineItem::Type)type );
+		item->data = str();
+		item->targId = num();
+		item->lmId = num();
+		item->offset = num();
+		item->counterId = num();
+		item->children = inlineList();
+		result->append( item );
+	}
+	return result;
+}
+
+/* The diagnostics written while the machine of an entry was constructed. An
+ * entry that cannot be read gives none, it is rebuilt anyway. */
+string genCacheDiags( const string &contents )
+{
+	CacheReader r( contents );
+
+	r.word( "ragel-cache " VERSION " " CACHE_FORMAT );
+	r.word( "diags" );
+	char *diags = r.str();
+	if ( !r.ok || diags == 0 )
+		return string();
+
+	string result( diags );
+	delete[] diags;
+	return result;
+}
+
+/* Replay an entry into the code generator with the same calls, in the same
+ * order, as the backend generator makes. Returns false if the entry is
+ * damaged or from another version. The code generator is then unusable. */
+bool loadGenCache( const string &contents, CodeGenData *cgd )
+{
+	CacheReader r( contents );
+
+	r.word( "ragel-cache " VERSION " " CACHE_FORMAT );
+	r.word( "diags" );
+	delete[] r.str();
+	r.word( "alphtype" );
+	char *alphType = r.str();
+	if ( !r.ok || alphType == 0 || !cgd->setAlphType( alphType ) )
+		return false;
+
+	r.word( "exprs" );
+	for ( int e = 0; r.ok && e < NUM_CACHED_EXPRS; e++ )
+		*cachedExpr( cgd, e ) = r.inlineList();
+
+	r.word( "lm" );
+	cgd->hasLongestMatch = r.num() != 0;
+
+	r.word( "counters" );
+	cgd->numCounters = r.num();
+
+	r.word( "exports" );
+	long numExports = r.num();
+	for ( long e = 0; r.ok && e < numExports; e++ ) {
+		char *name = r.str();
+		Key key = r.num();
+		cgd->exportList.append( new Export( name, key ) );
+	}
+
+	if ( !r.ok )
+		return false;
+
+	cgd->createMachine();
+
+	r.word( "actions" );
+	long numActions = r.num();
+	if ( !r.ok || numActions < 0 )
+		return false;
+
+	cgd->initActionList( numActions );
+	for ( long a = 0; r.ok && a < numActions; a++ ) {
+		char *name = r.str();
+		InputLoc loc;
+		loc.fileName = r.str();
+		loc.line = r.num();
+		loc.col = r.num();
+		GenInlineList *inlineList = r.inlineList();
+		cgd->newAction( a, name, loc, inlineList );
+	}
+
+	r.word( "tables" );
+	long numTables = r.num();
+	if ( !r.ok || numTables < 0 )
+		return false;
+
+	cgd->initActionTableList( numTables );
+	for ( long t = 0; r.ok && t < numTables; t++ ) {
+		RedAction *redAct = cgd->allActionTables + t;
+		redAct->actListId = t;
+
+		long length = r.num();
+		if ( !r.ok || length < 0 )
+			return false;
+
+		redAct->key.setAsNew( length );
+		for ( long i = 0; i < length; i++ ) {
+			redAct->key[i].key = r.num();
+			long action = r.ref( numActions );
+			redAct->key[i].value = action >= 0 ? cgd->allActions + action : 0;
+		}
+
+		cgd->redFsm->actionMap.insert( redAct );
+	}
+
+	r.word( "condspaces" );
+	long numCondSpaces = r.num();
+	if ( !r.ok || numCondSpaces < 0 )
+		return false;
+
+	if ( numCondSpaces > 0 ) {
+		cgd->initCondSpaceList( numCondSpaces );
+		for ( long c = 0; r.ok && c < numCondSpaces; c++ ) {
+			long condSpaceId = r.num();
+			Key baseKey = r.num();
+			cgd->newCondSpace( c, condSpaceId, baseKey );
+
+			long length = r.num();
+			for ( long i = 0; r.ok && i < length; i++ ) {
+				long action = r.ref( numActions );
+				if ( action >= 0 )
+					cgd->condSpaceItem( c, action );
+			}
+		}
+	}
+
+	r.word( "start" );
+	long startState = r.num();
+	r.word( "error" );
+	long errState = r.num();
+	r.word( "forced" );
+	bool forced = r.num() != 0;
+
+	r.word( "entries" );
+	long numEntries = r.num();
+	Vector<char*> entryNames;
+	Vector<long> entryIds;
+	for ( long en = 0; r.ok && en < numEntries; en++ ) {
+		entryNames.append( r.str() );
+		entryIds.append( r.num() );
+	}
+
+	r.word( "states" );
+	long numStates = r.num();
+	if ( !r.ok || numStates <= 0 || startState < 0 || startState >= numStates ||
+			errState < -1 || errState >= numStates )
+		return false;
+
+	for ( long en = 0; en < entryIds.length(); en++ ) {
+		if ( entryIds[en] < 0 || entryIds[en] >= numStates )
+			return false;
+	}
+
+	cgd->setStartState( startState );
+	if ( errState >= 0 )
+		cgd->setErrorState( errState );
+
+	if ( forced )
+		cgd->setForcedErrorState();
+	for ( long en = 0; en < entryIds.length(); en++ )
+		cgd->addEntryPoint( entryNames[en], entryIds[en] );
+
+	cgd->initStateList( numStates );
+	for ( long s = 0; r.ok && s < numStates; s++ ) {
+		long id = r.num();
+		bool final = r.num() != 0;
+
+		long to = r.ref( numTables );
+		long from = r.ref( numTables );
+		long eof = r.ref( numTables );
+		cgd->setStateActions( s, to, from, eof );
+
+		if ( !r.null() ) {
+			long targ = r.ref( numStates );
+			long action = r.ref( numTables );
+			if ( targ < 0 )
+				return false;
+			cgd->setEofTrans( s, targ, action );
+		}
+
+		long numConds = r.num();
+		if ( numConds > 0 )
+			cgd->initStateCondList( s, numConds );
+		for ( long c = 0; r.ok && c < numConds; c++ ) {
+			Key lowKey = r.num();
+			Key highKey = r.num();
+			long condSpace = r.ref( numCondSpaces );
+			if ( condSpace < 0 )
+				return false;
+			cgd->addStateCond( s, lowKey, highKey, condSpace );
+		}
+
+		long numRanges = r.num();
+		if ( !r.ok || numRanges < 0 )
+			return false;
+
+		cgd->initTransList( s, numRanges );
+		for ( long t = 0; r.ok && t < numRanges; t++ ) {
+			Key lowKey = r.num();
+			Key highKey = r.num();
+			long targ = r.ref( numStates );
+			long action = r.ref( numTables );
+			cgd->newTrans( s, t, lowKey, highKey, targ, action );
+		}
+		cgd->finishTransList( s );
+
+		cgd->setId( s, id );
+		if ( final )
+			cgd->setFinal( s );
+	}
+
+	r.word( "end" );
+	if ( !r.ok )
+		return false;
+
+	cgd->closeMachine();
+
+	/* As in BackendGen::close_ragel_def. */
+	cgd->redFsm->maxKey = cgd->findMaxKey();
+	cgd->redFsm->assignActionLocs();
+	cgd->redFsm->findFirstFinState();
+	cgd->finishRagelDef();
+
+	return true;
+}
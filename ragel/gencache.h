@@ -0,0 +1,44 @@
+/*
+ *  Copyright 2010 Adrian Thurston <thurston@complang.org>
+ */
+
+/*  This file is part of Ragel.
+ *
+ *  Ragel is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Ragel is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Ragel; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _GENCACHE_H
+#define _GENCACHE_H
+
+#include <string>
+
+struct CodeGenData;
+
+/* Hash of everything that goes into a machine specification. This is the
+ * key of its entry in the compilation cache. */
+typedef unsigned long long CacheHash;
+
+#define CACHE_HASH_INIT 14695981039346656037ULL
+
+void cacheHashBytes( CacheHash &hash, const void *data, long len );
+
+/* Entries hold the reduced machine, as it is handed to the code generator
+ * by the backend generator, and the diagnostics of its construction. */
+bool readGenCache( const char *fileName, std::string &contents );
+void saveGenCache( const char *fileName, CodeGenData *cgd, const std::string &diags );
+std::string genCacheDiags( const std::string &contents );
+bool loadGenCache( const std::string &contents, CodeGenData *cgd );
+
+#endif
@@ -40,6 +40,7 @@
 #include "cdftable.h"
 #include "cdflat.h"
 #include "cdfflat.h"
+#include "cdcomb.h"
 #include "cdgoto.h"
 #include "cdfgoto.h"
 #include "cdipgoto.h"
@@ -48,8 +49,12 @@
 #include "dotcodegen.h"
 
 #include "javacodegen.h"
+#include "javaflat.h"
+#include "javafflat.h"
 
 #include "goipgoto.h"
+#include "gotable.h"
+#include "goflat.h"
 
 #include "rubytable.h"
 #include "rubyftable.h"
@@ -97,6 +102,9 @@ CodeGenData *cdMakeCodeGen( const char *sourceFileName, const char *fsmName, ost
 		case GenFTables:
 			codeGen = new CFTabCodeGen(out);
 			break;
+		case GenCombTables:
+			codeGen = new CCombCodeGen(out);
+			break;
 		case GenFlat:
 			codeGen = new CFlatCodeGen(out);
 			break;
@@ -126,6 +134,9 @@ CodeGenData *cdMakeCodeGen( const char *sourceFileName, const char *fsmName, ost
 		case GenFTables:
 			codeGen = new DFTabCodeGen(out);
 			break;
+		case GenCombTables:
+			codeGen = new DCombCodeGen(out);
+			break;
 		case GenFlat:
 			codeGen = new DFlatCodeGen(out);
 			break;
@@ -159,7 +170,19 @@ CodeGenData *cdMakeCodeGen( const char *sourceFileName, const char *fsmName, ost
 /* Invoked by the parser when a ragel definition is opened. */
 CodeGenData *javaMakeCodeGen( const char *sourceFileName, const char *fsmName, ostream &out )
 {
-	CodeGenData *codeGen = new JavaTabCodeGen(out);
+	CodeGenData *codeGen;
+
+	switch ( codeStyle ) {
+	case GenFlat:
+		codeGen = new JavaFlatCodeGen(out);
+		break;
+	case GenFFlat:
+		codeGen = new JavaFFlatCodeGen(out);
+		break;
+	default:
+		codeGen = new JavaTabCodeGen(out);
+		break;
+	}
 
 	codeGen->sourceFileName = sourceFileName;
 	codeGen->fsmName = fsmName;
@@ -173,13 +196,25 @@ CodeGenData *goMakeCodeGen( const char *sourceFileName, const char *fsmName, ost
 	CodeGenData *codeGen;
 
 	switch ( codeStyle ) {
+	case GenTables:
+		codeGen = new GoTabCodeGen(out);
+		break;
+	case GenFTables:
+		codeGen = new GoFTabCodeGen(out);
+		break;
+	case GenFlat:
+		codeGen = new GoFlatCodeGen(out);
+		break;
+	case GenFFlat:
+		codeGen = new GoFFlatCodeGen(out);
+		break;
 	case GenIpGoto:
 		codeGen = new GoIpGotoCodeGen(out);
 		break;
 	default:
-		cerr << "I only support the -G2 output style for Go.  Please "
-			"rerun ragel including this flag.\n";
-		exit(1);
+		/* Rejected by checkCodeStyle. */
+		assert( false );
+		return 0;
 	}
 
 	codeGen->sourceFileName = sourceFileName;
@@ -206,20 +241,13 @@ CodeGenData *rubyMakeCodeGen( const char *sourceFileName, const char *fsmName, o
 			codeGen = new RubyFFlatCodeGen(out);
 			break;
 		case GenGoto:
-			if ( rubyImpl == Rubinius ) {
-				codeGen = new RbxGotoCodeGen(out);
-			} else {
-				cerr << "Goto style is still _very_ experimental " 
-					"and only supported using Rubinius.\n"
-					"You may want to enable the --rbx flag "
-					" to give it a try.\n";
-				exit(1);
-			}
+			assert( rubyImpl == Rubinius );
+			codeGen = new RbxGotoCodeGen(out);
 			break;
 		default:
-			cout << "Invalid code style\n";
-			exit(1);
-			break;
+			/* Rejected by checkCodeStyle. */
+			assert( false );
+			return 0;
 	}
 	codeGen->sourceFileName = sourceFileName;
 	codeGen->fsmName = fsmName;
@@ -257,6 +285,10 @@ CodeGenData *csharpMakeCodeGen( const char *sourceFileName, const char *fsmName,
 	case GenSplit:
 		codeGen = new CSharpSplitCodeGen(out);
 		break;
+	default:
+		/* Rejected by checkCodeStyle. */
+		assert( false );
+		return 0;
 	}
 
 	codeGen->sourceFileName = sourceFileName;
@@ -266,6 +298,43 @@ CodeGenData *csharpMakeCodeGen( const char *sourceFileName, const char *fsmName,
 }
 
 
+/* Code generators are made on the compile threads, where exiting would take
+ * down the others. A style the host language has no generator for is
+ * rejected before any machine is compiled. */
+void checkCodeStyle()
+{
+	if ( generateDot )
+		return;
+
+	if ( hostLang == &hostLangGo ) {
+		switch ( codeStyle ) {
+		case GenTables: case GenFTables: case GenFlat: case GenFFlat: case GenIpGoto:
+			break;
+		default:
+			error() << "only the -T0 -T1 -F0 -F1 and -G2 output styles "
+					"are supported for Go" << endl;
+		}
+	}
+	else if ( hostLang == &hostLangRuby ) {
+		switch ( codeStyle ) {
+		case GenTables: case GenFTables: case GenFlat: case GenFFlat:
+			break;
+		case GenGoto:
+			if ( rubyImpl != Rubinius ) {
+				error() << "goto style is still _very_ experimental and only "
+						"supported using Rubinius, enable --rbx to try it" << endl;
+			}
+			break;
+		default:
+			error() << "invalid code style for Ruby" << endl;
+		}
+	}
+	else if ( hostLang == &hostLangCSharp ) {
+		if ( codeStyle == GenCombTables )
+			error() << "invalid code style for C#" << endl;
+	}
+}
+
 CodeGenData *makeCodeGen( const char *sourceFileName, const char *fsmName, ostream &out )
 {
 	CodeGenData *cgd = 0;
@@ -343,8 +412,10 @@ CodeGenData::CodeGenData( ostream &out )
 	tokstartExpr(0),
 	tokendExpr(0),
 	dataExpr(0),
+	countersExpr(0),
 	wantComplete(true),
 	hasLongestMatch(false),
+	numCounters(0),
 	noEnd(false),
 	noPrefix(false),
 	noFinal(false),
@@ -851,7 +922,7 @@ void CodeGenData::setValueLimits()
 		}
 
 		/* Max key span. */
-		if ( st->transList != 0 ) {
+		if ( st->transList != 0 || st->pageList != 0 ) {
 			unsigned long long span = keyOps->span( st->lowKey, st->highKey );
 			if ( span > redFsm->maxSpan )
 				redFsm->maxSpan = span;
@@ -36,7 +36,7 @@ typedef DList<GenAction> GenActionList;
 
 typedef unsigned long ulong;
 
-extern int gblErrorCount;
+extern THREAD_LOCAL int gblErrorCount;
 
 struct CodeGenData;
 
@@ -78,7 +78,7 @@ struct CodeGenData
 	/********************/
 
 	CodeGenData( ostream &out );
-	virtual ~CodeGenData() {}
+	virtual ~CodeGenData() { delete redFsm; }
 
 	/* 
 	 * Collecting the machine.
@@ -115,6 +115,7 @@ struct CodeGenData
 	GenInlineList *tokstartExpr;
 	GenInlineList *tokendExpr;
 	GenInlineList *dataExpr;
+	GenInlineList *countersExpr;
 
 	KeyOps thisKeyOps;
 	bool wantComplete;
@@ -123,6 +124,9 @@ struct CodeGenData
 	bool hasLongestMatch;
 	ExportList exportList;
 
+	/* Length of the counters array used by counted repetitions. */
+	int numCounters;
+
 	/* Write options. */
 	bool noEnd;
 	bool noPrefix;
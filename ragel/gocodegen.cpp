@@ -0,0 +1,272 @@
+/*
+ *  Copyright 2010 Adrian Thurston <thurston@complang.org>
+ */
+
+/*  This file is part of Ragel.
+ *
+ *  Ragel is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Ragel is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Ragel; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ragel.h"
+#include "gocodegen.h"
+#include "redfsm.h"
+#include "gendata.h"
+#include <sstream>
+
+using std::ostringstream;
+using std::streambuf;
+
+void gothicLineDirective( ostream &out, const char *fileName, int line )
+{
+	/* Write the preprocessor line info for to the input file. */
+	out << "// line " << line  << " \"";
+	for ( const char *pc = fileName; *pc != 0; pc++ ) {
+		if ( *pc == '\\' )
+			out << "\\\\";
+		else
+			out << *pc;
+	}
+	out << "\"\n";
+}
+
+string GoCodeGen::NULL_ITEM()
+{
+	return "0";
+}
+
+string GoCodeGen::POINTER()
+{
+	return "";
+}
+
+ostream &GoCodeGen::SWITCH_DEFAULT()
+{
+	return out;
+}
+
+/* The items written until the close go to arrayItems. */
+ostream &GoCodeGen::OPEN_ARRAY( string type, string name )
+{
+	out << "var " << name << " = [...]" << type << "{\n";
+	arrayItems.str( "" );
+	arrayBuf = out.rdbuf( arrayItems.rdbuf() );
+	return out;
+}
+
+ostream &GoCodeGen::CLOSE_ARRAY()
+{
+	out.rdbuf( arrayBuf );
+	arrayBuf = 0;
+
+	string items = arrayItems.str();
+	string::size_type end = items.find_last_not_of( " \t\n" );
+	if ( end != string::npos )
+		out << items.substr( 0, end + 1 ) << ",\n";
+	return out << "}\n";
+}
+
+ostream &GoCodeGen::STATIC_VAR( string type, string name )
+{
+	out << "var " << name << " " << type;
+	return out;
+}
+
+ostream &GoCodeGen::PROF_ARRAY( string name, long length )
+{
+	out << "var " << name << " [" << length << "]uint64\n";
+	return out;
+}
+
+string GoCodeGen::PROF_FORMAT()
+{
+	return "%d";
+}
+
+string GoCodeGen::ARR_OFF( string ptr, string offset )
+{
+	return ptr + "[" + offset + ":]";
+}
+
+/* Conversions are written as calls: CAST(type) << "(" << expr << ")". */
+string GoCodeGen::CAST( string type )
+{
+	return type;
+}
+
+string GoCodeGen::UINT()
+{
+	return "uint";
+}
+
+string GoCodeGen::PTR_CONST()
+{
+	return "";
+}
+
+string GoCodeGen::CTRL_FLOW()
+{
+	return "";
+}
+
+string GoCodeGen::GET_KEY()
+{
+	ostringstream ret;
+	if ( getKeyExpr != 0 ) {
+		/* Emit the user supplied method of retrieving the key. */
+		ret << "(";
+		INLINE_LIST( ret, getKeyExpr, 0, false, false );
+		ret << ")";
+	}
+	else {
+		/* Expression for retrieving the key, use simple dereference. */
+		ret << "data[" << P() << "]";
+	}
+	return ret.str();
+}
+
+void GoCodeGen::writeExports()
+{
+	if ( exportList.length() > 0 ) {
+		for ( ExportList::Iter ex = exportList; ex.lte(); ex++ ) {
+			out << "const " << DATA_PREFIX() << "ex_" << ex->name << " " <<
+					ALPH_TYPE() << " = " << KEY(ex->key) << "\n";
+		}
+		out << "\n";
+	}
+}
+
+void GoCodeGen::writeInit()
+{
+	if ( !noCS )
+		out << "\t" << vCS() << " = " << START() << "\n";
+
+	/* If there are any calls, then the stack top needs initialization. */
+	if ( redFsm->anyActionCalls() || redFsm->anyActionRets() )
+		out << "\t" << TOP() << " = 0\n";
+
+	if ( hasLongestMatch ) {
+		out <<
+			"	" << TOKSTART() << " = " << NULL_ITEM() << "\n"
+			"	" << TOKEND() << " = " << NULL_ITEM() << "\n"
+			"	" << ACT() << " = 0\n";
+	}
+}
+
+void GoCodeGen::STATE_IDS()
+{
+	if ( redFsm->startState != 0 )
+		out << "var " << START() << " int = " << START_STATE_ID() << "\n";
+
+	if ( !noFinal )
+		out << "var " << FIRST_FINAL() << " int = " << FIRST_FINAL_STATE() << "\n";
+
+	if ( !noError )
+		out << "var " << ERROR() << " int = " << ERROR_STATE() << "\n";
+
+	if ( numCounters > 0 ) {
+		out << "var " << (DATA_PREFIX() + "num_counters") <<
+				" int = " << numCounters << "\n";
+	}
+
+	out << "\n";
+
+	if ( entryPointNames.length() > 0 ) {
+		for ( EntryNameVect::Iter en = entryPointNames; en.lte(); en++ ) {
+			out <<
+				"var " << (DATA_PREFIX() + "en_" + *en) <<
+				" int = " << entryPointIds[en.pos()] << "\n";
+		}
+		out << "\n";
+	}
+}
+
+void GoCodeGen::ACTION( ostream &ret, GenAction *action, int targState,
+		bool inFinish, bool csForced )
+{
+	/* Write the preprocessor line info for going into the source file. */
+	gothicLineDirective( ret, action->loc.fileName, action->loc.line );
+
+	/* Write the block and close it off. */
+	ret << "\t{";
+	INLINE_LIST( ret, action->inlineList, targState, inFinish, csForced );
+	ret << "}\n";
+}
+
+void GoCodeGen::CONDITION( ostream &ret, GenAction *condition )
+{
+	ret << "\n";
+	gothicLineDirective( ret, condition->loc.fileName, condition->loc.line );
+	INLINE_LIST( ret, condition->inlineList, 0, false, false );
+}
+
+void GoCodeGen::genLineDirective( ostream &out )
+{
+	streambuf *sbuf = out.rdbuf();
+	output_filter *filter = static_cast<output_filter*>(sbuf);
+	gothicLineDirective( out, filter->fileName, filter->line + 1 );
+}
+
+/* A block followed by a statement on the same line needs a semicolon. */
+void GoCodeGen::EXEC( ostream &ret, GenInlineItem *item, int targState, int inFinish )
+{
+	ret << "{" << P() << " = (";
+	INLINE_LIST( ret, item->children, targState, inFinish, false );
+	ret << ") - 1};";
+}
+
+void GoCodeGen::CALL( ostream &ret, int callDest, int targState, bool inFinish )
+{
+	if ( prePushExpr != 0 ) {
+		ret << "{";
+		INLINE_LIST( ret, prePushExpr, 0, false, false );
+	}
+
+	ret << "{" << STACK() << "[" << TOP() << "] = " << vCS() << "; " <<
+			TOP() << "++; " << vCS() << " = " << callDest << "; " <<
+			CTRL_FLOW() << "goto _again;}";
+
+	if ( prePushExpr != 0 )
+		ret << "}";
+}
+
+void GoCodeGen::CALL_EXPR( ostream &ret, GenInlineItem *ilItem, int targState, bool inFinish )
+{
+	if ( prePushExpr != 0 ) {
+		ret << "{";
+		INLINE_LIST( ret, prePushExpr, 0, false, false );
+	}
+
+	ret << "{" << STACK() << "[" << TOP() << "] = " << vCS() << "; " <<
+			TOP() << "++; " << vCS() << " = (";
+	INLINE_LIST( ret, ilItem->children, targState, inFinish, false );
+	ret << "); " << CTRL_FLOW() << "goto _again;}";
+
+	if ( prePushExpr != 0 )
+		ret << "}";
+}
+
+void GoCodeGen::RET( ostream &ret, bool inFinish )
+{
+	ret << "{" << TOP() << "--; " << vCS() << " = " << STACK() << "[" <<
+			TOP() << "]; ";
+
+	if ( postPopExpr != 0 ) {
+		ret << "{";
+		INLINE_LIST( ret, postPopExpr, 0, false, false );
+		ret << "}";
+	}
+
+	ret << CTRL_FLOW() << "goto _again;}";
+}
@@ -0,0 +1,79 @@
+/*
+ *  Copyright 2010 Adrian Thurston <thurston@complang.org>
+ */
+
+/*  This file is part of Ragel.
+ *
+ *  Ragel is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Ragel is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Ragel; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _GOCODEGEN_H
+#define _GOCODEGEN_H
+
+#include <iostream>
+#include <sstream>
+#include "cdcodegen.h"
+
+void gothicLineDirective( ostream &out, const char *fileName, int line );
+
+/*
+ * Go specific, but style independent code generation. Arrays are written
+ * as arrays of fixed length, so the compiler knows their bounds, and all
+ * the arrays indexed by the state have the same length.
+ */
+class GoCodeGen : virtual public FsmCodeGen
+{
+public:
+	GoCodeGen( ostream &out ) : FsmCodeGen(out), arrayBuf(0) {}
+
+	virtual string NULL_ITEM();
+	virtual string POINTER();
+	virtual ostream &SWITCH_DEFAULT();
+	virtual ostream &OPEN_ARRAY( string type, string name );
+	virtual ostream &CLOSE_ARRAY();
+	virtual ostream &STATIC_VAR( string type, string name );
+	virtual ostream &PROF_ARRAY( string name, long length );
+	virtual string PROF_FORMAT();
+	virtual string ARR_OFF( string ptr, string offset );
+	virtual string CAST( string type );
+	virtual string UINT();
+	virtual string PTR_CONST();
+	virtual string CTRL_FLOW();
+	virtual string GET_KEY();
+
+	virtual void writeExports();
+	virtual void writeInit();
+	virtual void STATE_IDS();
+	virtual void ACTION( ostream &ret, GenAction *action, int targState,
+			bool inFinish, bool csForced );
+	virtual void CONDITION( ostream &ret, GenAction *condition );
+	virtual void genLineDirective( ostream &out );
+	virtual void EXEC( ostream &ret, GenInlineItem *item, int targState, int inFinish );
+
+	/* Calls and returns of the table and flat styles. Go has no increment
+	 * expressions, the stack top moves in a statement of its own. */
+	virtual void CALL( ostream &ret, int callDest, int targState, bool inFinish );
+	virtual void CALL_EXPR( ostream &ret, GenInlineItem *ilItem,
+			int targState, bool inFinish );
+	virtual void RET( ostream &ret, bool inFinish );
+
+protected:
+	/* The items of an open array are collected here, as the last item of a
+	 * Go composite literal written over several lines needs a comma. */
+	std::streambuf *arrayBuf;
+	std::ostringstream arrayItems;
+};
+
+#endif
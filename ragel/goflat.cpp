@@ -0,0 +1,483 @@
+/*
+ *  Copyright 2010 Adrian Thurston <thurston@complang.org>
+ */
+
+/*  This file is part of Ragel.
+ *
+ *  Ragel is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Ragel is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Ragel; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ragel.h"
+#include "goflat.h"
+#include "redfsm.h"
+#include "gendata.h"
+
+/* Assigns the class of the key to _cls. Where the classes start at zero the
+ * key is the index, and a key type the class array covers needs no bounds
+ * check. Alphabets too wide for a class map search the class intervals. */
+void GoFlatSearch::CLASS_OF_KEY()
+{
+	if ( redFsm->anyClassIntervals() ) {
+		out <<
+			"	_lower = 1\n"
+			"	_upper = " << redFsm->numClassInts << "\n"
+			"	for _lower < _upper {\n"
+			"		_mid = _lower + ((_upper - _lower) >> 1)\n"
+			"		if " << GET_KEY() << " < " << CLK() << "[_mid] {\n"
+			"			_upper = _mid\n"
+			"		} else {\n"
+			"			_lower = _mid + 1\n"
+			"		}\n"
+			"	}\n"
+			"	_cls = " << CC() << "[_lower - 1]\n";
+		return;
+	}
+
+	string index = GET_KEY();
+	if ( redFsm->classLowKey != 0 )
+		index = "int(" + GET_KEY() + ") - " + KEY( redFsm->classLowKey );
+
+	if ( redFsm->classLowKey != keyOps->minKey || redFsm->classHighKey != keyOps->maxKey ) {
+		out <<
+			"	if " << GET_KEY() << " < " << KEY( redFsm->classLowKey ) << " || " <<
+					GET_KEY() << " > " << KEY( redFsm->classHighKey ) << " {\n"
+			"		_cls = " << redFsm->numClasses << "\n"
+			"	} else {\n"
+			"		_cls = " << CC() << "[" << index << "]\n"
+			"	}\n";
+	}
+	else {
+		out << "	_cls = " << CC() << "[" << index << "]\n";
+	}
+}
+
+void GoFlatSearch::LOCATE_TRANS()
+{
+	if ( redFsm->flatPaged ) {
+		unsigned long long pageMask = (1ULL << redFsm->pageBits) - 1;
+		out <<
+			"	_keys = " << vCS() << " << 1\n"
+			"	_slen = int(" << SP() << "[" << vCS() << "])\n"
+			"	if _slen > 0 && " << K() << "[_keys] <= " << GET_WIDE_KEY() << " &&\n"
+			"			" << GET_WIDE_KEY() << " <= " << K() << "[_keys+1] {\n"
+			"		_off = uint(int(" << GET_WIDE_KEY() << ") - int(" << K() << "[_keys]))\n"
+			"		_trans = int(" << I() << "[(uint(" << PG() << "[uint(" << PO() << "[" <<
+					vCS() << "])+(_off>>" << redFsm->pageBits << ")]) << " <<
+					redFsm->pageBits << ") + (_off & " << pageMask << ")])\n"
+			"	} else {\n"
+			"		_trans = int(" << ID() << "[" << vCS() << "])\n"
+			"	}\n"
+			"\n";
+		return;
+	}
+
+	out <<
+		"	_keys = " << vCS() << " << 1\n"
+		"	_inds = int(" << IO() << "[" << vCS() << "])\n"
+		"\n";
+
+	if ( redFsm->anyCharClasses() ) {
+		CLASS_OF_KEY();
+
+		out <<
+			"	_slen = int(" << SP() << "[" << vCS() << "])\n"
+			"	if _slen > 0 && " << K() << "[_keys] <= _cls && _cls <= " << K() << "[_keys+1] {\n"
+			"		_trans = int(" << I() << "[_inds+int(_cls)-int(" << K() << "[_keys])])\n"
+			"	} else {\n"
+			"		_trans = int(" << I() << "[_inds+_slen])\n"
+			"	}\n"
+			"\n";
+	}
+	else {
+		out <<
+			"	_slen = int(" << SP() << "[" << vCS() << "])\n"
+			"	if _slen > 0 && " << K() << "[_keys] <= " << GET_WIDE_KEY() << " &&\n"
+			"			" << GET_WIDE_KEY() << " <= " << K() << "[_keys+1] {\n"
+			"		_trans = int(" << I() << "[_inds+int(" << GET_WIDE_KEY() <<
+					")-int(" << K() << "[_keys])])\n"
+			"	} else {\n"
+			"		_trans = int(" << I() << "[_inds+_slen])\n"
+			"	}\n"
+			"\n";
+	}
+}
+
+void GoFlatSearch::COND_TRANSLATE()
+{
+	out <<
+		"	_widec = " << CAST(WIDE_ALPH_TYPE()) << "(" << GET_KEY() << ")\n"
+		"	_keys = " << vCS() << " << 1\n"
+		"	_conds = int(" << CO() << "[" << vCS() << "])\n"
+		"\n"
+		"	_slen = int(" << CSP() << "[" << vCS() << "])\n"
+		"	_cond = 0\n"
+		"	if _slen > 0 && " << CK() << "[_keys] <= _widec && _widec <= " << CK() << "[_keys+1] {\n"
+		"		_cond = int(" << C() << "[_conds+int(_widec)-int(" << CK() << "[_keys])])\n"
+		"	}\n"
+		"\n"
+		"	switch _cond {\n";
+
+	for ( CondSpaceList::Iter csi = condSpaceList; csi.lte(); csi++ ) {
+		GenCondSpace *condSpace = csi;
+		out << "	case " << condSpace->condSpaceId + 1 << ":\n";
+		out << TABS(2) << "_widec = " << CAST(WIDE_ALPH_TYPE()) << "(" <<
+				KEY(condSpace->baseKey) << " + (int(" << GET_KEY() <<
+				") - " << KEY(keyOps->minKey) << "))\n";
+
+		for ( GenCondSet::Iter csi = condSpace->condSet; csi.lte(); csi++ ) {
+			out << TABS(2) << "if ";
+			CONDITION( out, *csi );
+			Size condValOffset = ((1 << csi.pos()) * keyOps->alphSize());
+			out << " {\n" << TABS(3) << "_widec += " << condValOffset << "\n" <<
+					TABS(2) << "}\n";
+		}
+	}
+
+	out <<
+		"	}\n"
+		"\n";
+}
+
+void GoFlatCodeGen::writeExec()
+{
+	testEofUsed = false;
+	outLabelUsed = false;
+
+	out <<
+		"	{\n"
+		"	var _slen int\n";
+
+	if ( redFsm->anyRegCurStateRef() )
+		out << "	var _ps int\n";
+
+	out <<
+		"	var _trans int\n";
+
+	if ( redFsm->anyConditions() )
+		out << "	var _cond int\n";
+
+	if ( redFsm->anyCharClasses() )
+		out << "	var _cls " << KEYS_TYPE() << "\n";
+	if ( redFsm->anyClassIntervals() )
+		out << "	var _lower, _upper, _mid int\n";
+
+	if ( redFsm->anyToStateActions() || redFsm->anyRegActions()
+			|| redFsm->anyFromStateActions() )
+		out << "	var _acts int\n";
+
+	out <<
+		"	var _keys int\n";
+
+	if ( redFsm->flatPaged )
+		out << "	var _off uint\n";
+	else
+		out << "	var _inds int\n";
+
+	if ( redFsm->anyConditions() ) {
+		out <<
+			"	var _conds int\n"
+			"	var _widec " << WIDE_ALPH_TYPE() << "\n";
+	}
+
+	out << "\n";
+
+	if ( !noEnd ) {
+		testEofUsed = true;
+		out <<
+			"	if " << P() << " == " << PE() << " {\n"
+			"		goto _test_eof\n"
+			"	}\n";
+	}
+
+	if ( redFsm->errState != 0 ) {
+		outLabelUsed = true;
+		out <<
+			"	if " << vCS() << " == " << redFsm->errState->id << " {\n"
+			"		goto _out\n"
+			"	}\n";
+	}
+
+	out << "_resume:\n";
+
+	if ( redFsm->anyFromStateActions() ) {
+		out <<
+			"	_acts = int(" << FSA() << "[" << vCS() << "])\n"
+			"	for _, _act := range " << A() << "[_acts+1 : _acts+1+int(" << A() << "[_acts])] {\n"
+			"		switch _act {\n";
+			FROM_STATE_ACTION_SWITCH() <<
+			"		}\n"
+			"	}\n"
+			"\n";
+	}
+
+	if ( redFsm->anyConditions() )
+		GoFlatSearch::COND_TRANSLATE();
+
+	GoFlatSearch::LOCATE_TRANS();
+
+	if ( redFsm->anyEofTrans() )
+		out << "_eof_trans:\n";
+
+	if ( redFsm->anyRegCurStateRef() )
+		out << "	_ps = " << vCS() << "\n";
+
+	out <<
+		"	" << vCS() << " = int(" << TT() << "[_trans])\n"
+		"\n";
+
+	if ( redFsm->anyRegActions() ) {
+		out <<
+			"	if " << TA() << "[_trans] == 0 {\n"
+			"		goto _again\n"
+			"	}\n"
+			"\n"
+			"	_acts = int(" << TA() << "[_trans])\n"
+			"	for _, _act := range " << A() << "[_acts+1 : _acts+1+int(" << A() << "[_acts])] {\n"
+			"		switch _act {\n";
+			ACTION_SWITCH() <<
+			"		}\n"
+			"	}\n"
+			"\n";
+	}
+
+	if ( redFsm->anyRegActions() || redFsm->anyActionGotos() ||
+			redFsm->anyActionCalls() || redFsm->anyActionRets() )
+		out << "_again:\n";
+
+	if ( redFsm->anyToStateActions() ) {
+		out <<
+			"	_acts = int(" << TSA() << "[" << vCS() << "])\n"
+			"	for _, _act := range " << A() << "[_acts+1 : _acts+1+int(" << A() << "[_acts])] {\n"
+			"		switch _act {\n";
+			TO_STATE_ACTION_SWITCH() <<
+			"		}\n"
+			"	}\n"
+			"\n";
+	}
+
+	if ( redFsm->errState != 0 ) {
+		outLabelUsed = true;
+		out <<
+			"	if " << vCS() << " == " << redFsm->errState->id << " {\n"
+			"		goto _out\n"
+			"	}\n";
+	}
+
+	if ( !noEnd ) {
+		out <<
+			"	" << P() << "++\n"
+			"	if " << P() << " != " << PE() << " {\n"
+			"		goto _resume\n"
+			"	}\n";
+	}
+	else {
+		out <<
+			"	" << P() << "++\n"
+			"	goto _resume\n";
+	}
+
+	if ( testEofUsed )
+		out << "	_test_eof: {}\n";
+
+	if ( redFsm->anyEofTrans() || redFsm->anyEofActions() ) {
+		out <<
+			"	if " << P() << " == " << vEOF() << " {\n";
+
+		if ( redFsm->anyEofTrans() ) {
+			out <<
+				"	if " << ET() << "[" << vCS() << "] > 0 {\n"
+				"		_trans = int(" << ET() << "[" << vCS() << "]) - 1\n"
+				"		goto _eof_trans\n"
+				"	}\n";
+		}
+
+		if ( redFsm->anyEofActions() ) {
+			out <<
+				"	__acts := int(" << EA() << "[" << vCS() << "])\n"
+				"	for _, _act := range " << A() << "[__acts+1 : __acts+1+int(" << A() << "[__acts])] {\n"
+				"		switch _act {\n";
+				EOF_ACTION_SWITCH() <<
+				"		}\n"
+				"	}\n";
+		}
+
+		out <<
+			"	}\n"
+			"\n";
+	}
+
+	if ( outLabelUsed )
+		out << "	_out: {}\n";
+
+	out << "	}\n";
+}
+
+void GoFFlatCodeGen::writeExec()
+{
+	testEofUsed = false;
+	outLabelUsed = false;
+
+	out <<
+		"	{\n"
+		"	var _slen int\n";
+
+	if ( redFsm->anyRegCurStateRef() )
+		out << "	var _ps int\n";
+
+	out <<
+		"	var _trans int\n";
+
+	if ( redFsm->anyConditions() )
+		out << "	var _cond int\n";
+
+	if ( redFsm->anyCharClasses() )
+		out << "	var _cls " << KEYS_TYPE() << "\n";
+	if ( redFsm->anyClassIntervals() )
+		out << "	var _lower, _upper, _mid int\n";
+
+	out <<
+		"	var _keys int\n";
+
+	if ( redFsm->flatPaged )
+		out << "	var _off uint\n";
+	else
+		out << "	var _inds int\n";
+
+	if ( redFsm->anyConditions() ) {
+		out <<
+			"	var _conds int\n"
+			"	var _widec " << WIDE_ALPH_TYPE() << "\n";
+	}
+
+	out << "\n";
+
+	if ( !noEnd ) {
+		testEofUsed = true;
+		out <<
+			"	if " << P() << " == " << PE() << " {\n"
+			"		goto _test_eof\n"
+			"	}\n";
+	}
+
+	if ( redFsm->errState != 0 ) {
+		outLabelUsed = true;
+		out <<
+			"	if " << vCS() << " == " << redFsm->errState->id << " {\n"
+			"		goto _out\n"
+			"	}\n";
+	}
+
+	out << "_resume:\n";
+
+	if ( redFsm->anyFromStateActions() ) {
+		out <<
+			"	switch " << FSA() << "[" << vCS() << "] {\n";
+			FROM_STATE_ACTION_SWITCH() <<
+			"	}\n"
+			"\n";
+	}
+
+	if ( redFsm->anyConditions() )
+		GoFlatSearch::COND_TRANSLATE();
+
+	GoFlatSearch::LOCATE_TRANS();
+
+	if ( redFsm->anyEofTrans() )
+		out << "_eof_trans:\n";
+
+	if ( redFsm->anyRegCurStateRef() )
+		out << "	_ps = " << vCS() << "\n";
+
+	out <<
+		"	" << vCS() << " = int(" << TT() << "[_trans])\n"
+		"\n";
+
+	if ( redFsm->anyRegActions() ) {
+		out <<
+			"	if " << TA() << "[_trans] == 0 {\n"
+			"		goto _again\n"
+			"	}\n"
+			"\n"
+			"	switch " << TA() << "[_trans] {\n";
+			ACTION_SWITCH() <<
+			"	}\n"
+			"\n";
+	}
+
+	if ( redFsm->anyRegActions() || redFsm->anyActionGotos() ||
+			redFsm->anyActionCalls() || redFsm->anyActionRets() )
+		out << "_again:\n";
+
+	if ( redFsm->anyToStateActions() ) {
+		out <<
+			"	switch " << TSA() << "[" << vCS() << "] {\n";
+			TO_STATE_ACTION_SWITCH() <<
+			"	}\n"
+			"\n";
+	}
+
+	if ( redFsm->errState != 0 ) {
+		outLabelUsed = true;
+		out <<
+			"	if " << vCS() << " == " << redFsm->errState->id << " {\n"
+			"		goto _out\n"
+			"	}\n";
+	}
+
+	if ( !noEnd ) {
+		out <<
+			"	" << P() << "++\n"
+			"	if " << P() << " != " << PE() << " {\n"
+			"		goto _resume\n"
+			"	}\n";
+	}
+	else {
+		out <<
+			"	" << P() << "++\n"
+			"	goto _resume\n";
+	}
+
+	if ( testEofUsed )
+		out << "	_test_eof: {}\n";
+
+	if ( redFsm->anyEofTrans() || redFsm->anyEofActions() ) {
+		out <<
+			"	if " << P() << " == " << vEOF() << " {\n";
+
+		if ( redFsm->anyEofTrans() ) {
+			out <<
+				"	if " << ET() << "[" << vCS() << "] > 0 {\n"
+				"		_trans = int(" << ET() << "[" << vCS() << "]) - 1\n"
+				"		goto _eof_trans\n"
+				"	}\n";
+		}
+
+		if ( redFsm->anyEofActions() ) {
+			out <<
+				"	switch " << EA() << "[" << vCS() << "] {\n";
+				EOF_ACTION_SWITCH() <<
+				"	}\n";
+		}
+
+		out <<
+			"	}\n"
+			"\n";
+	}
+
+	if ( outLabelUsed )
+		out << "	_out: {}\n";
+
+	out << "	}\n";
+}
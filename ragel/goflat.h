@@ -0,0 +1,84 @@
+/*
+ *  Copyright 2010 Adrian Thurston <thurston@complang.org>
+ */
+
+/*  This file is part of Ragel.
+ *
+ *  Ragel is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Ragel is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Ragel; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _GOFLAT_H
+#define _GOFLAT_H
+
+#include "cdflat.h"
+#include "cdfflat.h"
+#include "gocodegen.h"
+
+/*
+ * GoFlatSearch
+ *
+ * The flat tables with offsets in place of the pointers of the C code.
+ * Shared by the plain and the fast flat tables.
+ */
+class GoFlatSearch : virtual public FsmCodeGen
+{
+public:
+	GoFlatSearch( ostream &out ) : FsmCodeGen(out) {}
+
+protected:
+	void CLASS_OF_KEY();
+	void LOCATE_TRANS();
+	void COND_TRANSLATE();
+};
+
+/*
+ * GoFlatCodeGen
+ */
+struct GoFlatCodeGen
+	: public FlatCodeGen, public GoCodeGen, public GoFlatSearch
+{
+	GoFlatCodeGen( ostream &out ) :
+		FsmCodeGen(out), FlatCodeGen(out), GoCodeGen(out), GoFlatSearch(out) {}
+
+	void CALL( ostream &ret, int callDest, int targState, bool inFinish )
+		{ GoCodeGen::CALL( ret, callDest, targState, inFinish ); }
+	void CALL_EXPR( ostream &ret, GenInlineItem *ilItem, int targState, bool inFinish )
+		{ GoCodeGen::CALL_EXPR( ret, ilItem, targState, inFinish ); }
+	void RET( ostream &ret, bool inFinish )
+		{ GoCodeGen::RET( ret, inFinish ); }
+
+	virtual void writeExec();
+};
+
+/*
+ * GoFFlatCodeGen
+ */
+struct GoFFlatCodeGen
+	: public FFlatCodeGen, public GoCodeGen, public GoFlatSearch
+{
+	GoFFlatCodeGen( ostream &out ) :
+		FsmCodeGen(out), FFlatCodeGen(out), GoCodeGen(out), GoFlatSearch(out) {}
+
+	void CALL( ostream &ret, int callDest, int targState, bool inFinish )
+		{ GoCodeGen::CALL( ret, callDest, targState, inFinish ); }
+	void CALL_EXPR( ostream &ret, GenInlineItem *ilItem, int targState, bool inFinish )
+		{ GoCodeGen::CALL_EXPR( ret, ilItem, targState, inFinish ); }
+	void RET( ostream &ret, bool inFinish )
+		{ GoCodeGen::RET( ret, inFinish ); }
+
+	virtual void writeExec();
+};
+
+#endif
@@ -32,7 +32,6 @@
 #include <sstream>
 
 using std::ostringstream;
-using std::streambuf;
 
 void GoIpGotoCodeGen::writeExec()
 {
@@ -103,25 +102,6 @@ void GoIpGotoCodeGen::writeExec()
 		"	}\n";
 }
 
-void GoIpGotoCodeGen::STATE_IDS()
-{
-	if ( redFsm->startState != 0 )
-		out << "var " << START() << " int = " << START_STATE_ID() << "\n";
-	if ( !noFinal )
-		out << "var " << FIRST_FINAL() << " int = " << FIRST_FINAL_STATE() << "\n";
-	if ( !noError )
-		out << "var " << ERROR() << " int = " << ERROR_STATE() << "\n";
-	out << "\n";
-	if ( entryPointNames.length() > 0 ) {
-		for ( EntryNameVect::Iter en = entryPointNames; en.lte(); en++ ) {
-			out <<
-				"var " << (DATA_PREFIX() + "en_" + *en) << 
-				" int = " << entryPointIds[en.pos()] << "\n";
-		}
-		out << "\n";
-	}
-}
-
 void GoIpGotoCodeGen::CALL( ostream &ret, int callDest, int targState, bool inFinish )
 {
 	if ( prePushExpr != 0 ) {
@@ -219,12 +199,6 @@ void GoIpGotoCodeGen::GOTO_HEADER( RedStateAp *state )
 		out << "	_ps = " << state->id << "\n";
 }
 
-ostream &GoIpGotoCodeGen::STATIC_VAR( string type, string name )
-{
-	out << "var " << name << " " << type;
-	return out;
-}
-
 void GoIpGotoCodeGen::LM_SWITCH( ostream &ret, GenInlineItem *item, 
 				 int targState, int inFinish, bool csForced )
 {
@@ -247,22 +221,6 @@ void GoIpGotoCodeGen::LM_SWITCH( ostream &ret, GenInlineItem *item,
 	ret << "	}\n	";
 }
 
-string GoIpGotoCodeGen::GET_KEY()
-{
-	ostringstream ret;
-	if ( getKeyExpr != 0 ) { 
-		/* Emit the user supplied method of retrieving the key. */
-		ret << "(";
-		INLINE_LIST( ret, getKeyExpr, 0, false, false );
-		ret << ")";
-	}
-	else {
-		/* Expression for retrieving the key, use simple dereference. */
-		ret << "data[" << P() << "]";
-	}
-	return ret.str();
-}
-
 void GoIpGotoCodeGen::emitSingleSwitch( RedStateAp *state )
 {
 	/* Load up the singles. */
@@ -429,46 +387,11 @@ ostream &GoIpGotoCodeGen::TRANS_GOTO( RedTransAp *trans, int level )
 	return out;
 }
 
-void GoIpGotoCodeGen::writeInit()
-{
-	if ( !noCS )
-		out << "\t" << vCS() << " = " << START() << "\n";
-	/* If there are any calls, then the stack top needs initialization. */
-	if ( redFsm->anyActionCalls() || redFsm->anyActionRets() )
-		out << "\t" << TOP() << " = 0\n";
-	if ( hasLongestMatch ) {
-		out << 
-			"	" << TOKSTART() << " = " << NULL_ITEM() << "\n"
-			"	" << TOKEND() << " = " << NULL_ITEM() << "\n"
-			"	" << ACT() << " = 0\n";
-	}
-}
-
 void GoIpGotoCodeGen::writeData()
 {
 	STATE_IDS();
 }
 
-void gothicLineDirective( ostream &out, const char *fileName, int line )
-{
-	/* Write the preprocessor line info for to the input file. */
-	out << "// line " << line  << " \"";
-	for ( const char *pc = fileName; *pc != 0; pc++ ) {
-		if ( *pc == '\\' )
-			out << "\\\\";
-		else
-			out << *pc;
-	}
-	out << "\"\n";
-}
-
-void GoIpGotoCodeGen::genLineDirective( ostream &out )
-{
-	streambuf *sbuf = out.rdbuf();
-	output_filter *filter = static_cast<output_filter*>(sbuf);
-	gothicLineDirective( out, filter->fileName, filter->line + 1 );
-}
-
 bool GoIpGotoCodeGen::IN_TRANS_ACTIONS( RedStateAp *state )
 {
 	bool anyWritten = false;
@@ -501,24 +424,6 @@ bool GoIpGotoCodeGen::IN_TRANS_ACTIONS( RedStateAp *state )
 	return anyWritten;
 }
 
-void GoIpGotoCodeGen::ACTION( ostream &ret, GenAction *action, int targState, 
-			      bool inFinish, bool csForced )
-{
-	/* Write the preprocessor line info for going into the source file. */
-	gothicLineDirective( ret, action->loc.fileName, action->loc.line );
-	/* Write the block and close it off. */
-	ret << "\t{";
-	INLINE_LIST( ret, action->inlineList, targState, inFinish, csForced );
-	ret << "}\n";
-}
-
-void GoIpGotoCodeGen::CONDITION( ostream &ret, GenAction *condition )
-{
-	ret << "\n";
-	gothicLineDirective( ret, condition->loc.fileName, condition->loc.line );
-	INLINE_LIST( ret, condition->inlineList, 0, false, false );
-}
-
 ostream &GoIpGotoCodeGen::FINISH_CASES()
 {
 	bool anyWritten = false;
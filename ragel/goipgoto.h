@@ -26,6 +26,7 @@
 #define _GOIPGOTO_H
 
 #include "cdipgoto.h"
+#include "gocodegen.h"
 
 /*
  * class GoIpGotoCodeGen
@@ -33,34 +34,26 @@
  * Keep overriding methods until it works.
  */
 struct GoIpGotoCodeGen
-	: public IpGotoCodeGen, public CCodeGen
+	: public IpGotoCodeGen, public GoCodeGen
 {
 public:
 	GoIpGotoCodeGen( ostream &out ) :
-		FsmCodeGen(out), IpGotoCodeGen(out), CCodeGen(out) {}
+		FsmCodeGen(out), IpGotoCodeGen(out), GoCodeGen(out) {}
 
 	void writeExec();
 	void writeData();
-	void writeInit();
-	void STATE_IDS();
 	void CALL( ostream &ret, int callDest, int targState, bool inFinish );
 	void CALL_EXPR( ostream &ret, GenInlineItem *ilItem, int targState, bool inFinish );
 	void RET( ostream &ret, bool inFinish );
 	void GOTO_HEADER( RedStateAp *state );
 	void LM_SWITCH( ostream &ret, GenInlineItem *item, 
 			int targState, int inFinish, bool csForced );
-	string GET_KEY();
 	void emitSingleSwitch( RedStateAp *state );
 	void emitRangeBSearch( RedStateAp *state, int level, int low, int high );
 	void COND_TRANSLATE( GenStateCond *stateCond, int level );
 	ostream &STATE_GOTOS();
-	ostream &STATIC_VAR( string type, string name );
 	ostream &TRANS_GOTO( RedTransAp *trans, int level );
-	void genLineDirective( ostream &out );
 	bool IN_TRANS_ACTIONS( RedStateAp *state );
-	void ACTION( ostream &ret, GenAction *action, int targState, 
-		     bool inFinish, bool csForced );
-	void CONDITION( ostream &ret, GenAction *condition );
 	ostream &FINISH_CASES();
 
 protected:
@@ -0,0 +1,425 @@
+/*
+ *  Copyright 2010 Adrian Thurston <thurston@complang.org>
+ */
+
+/*  This file is part of Ragel.
+ *
+ *  Ragel is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Ragel is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Ragel; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ragel.h"
+#include "gotable.h"
+#include "redfsm.h"
+#include "gendata.h"
+
+/* The binary searches run over a half open interval and end on a probe
+ * inside a slice of the keys, so one bounds check is left per probe. */
+void GoTabSearch::LOCATE_TRANS()
+{
+	out <<
+		"	_keys = int(" << KO() << "[" << vCS() << "])\n"
+		"	_trans = int(" << IO() << "[" << vCS() << "])\n"
+		"\n"
+		"	_klen = int(" << SL() << "[" << vCS() << "])\n"
+		"	if _klen > 0 {\n"
+		"		_singles := " << K() << "[_keys : _keys+_klen]\n"
+		"		_lower, _upper := 0, len(_singles)\n"
+		"		for _lower < _upper {\n"
+		"			_mid := int(uint(_lower+_upper) >> 1)\n"
+		"			if " << GET_WIDE_KEY() << " < _singles[_mid] {\n"
+		"				_upper = _mid\n"
+		"			} else if " << GET_WIDE_KEY() << " > _singles[_mid] {\n"
+		"				_lower = _mid + 1\n"
+		"			} else {\n"
+		"				_trans += _mid\n"
+		"				goto _match\n"
+		"			}\n"
+		"		}\n"
+		"		_keys += _klen\n"
+		"		_trans += _klen\n"
+		"	}\n"
+		"\n"
+		"	_klen = int(" << RL() << "[" << vCS() << "])\n"
+		"	if _klen > 0 {\n"
+		"		_ranges := " << K() << "[_keys : _keys+_klen*2]\n"
+		"		_lower, _upper := 0, _klen\n"
+		"		for _lower < _upper {\n"
+		"			_mid := int(uint(_lower+_upper) >> 1)\n"
+		"			_range := _ranges[_mid*2 : _mid*2+2]\n"
+		"			if " << GET_WIDE_KEY() << " < _range[0] {\n"
+		"				_upper = _mid\n"
+		"			} else if " << GET_WIDE_KEY() << " > _range[1] {\n"
+		"				_lower = _mid + 1\n"
+		"			} else {\n"
+		"				_trans += _mid\n"
+		"				goto _match\n"
+		"			}\n"
+		"		}\n"
+		"		_trans += _klen\n"
+		"	}\n"
+		"\n";
+}
+
+void GoTabSearch::COND_TRANSLATE()
+{
+	out <<
+		"	_widec = " << CAST(WIDE_ALPH_TYPE()) << "(" << GET_KEY() << ")\n"
+		"	_klen = int(" << CL() << "[" << vCS() << "])\n"
+		"	_keys = int(" << CO() << "[" << vCS() << "])\n"
+		"	if _klen > 0 {\n"
+		"		_ranges := " << CK() << "[_keys*2 : _keys*2+_klen*2]\n"
+		"		_lower, _upper := 0, _klen\n"
+		"		for _lower < _upper {\n"
+		"			_mid := int(uint(_lower+_upper) >> 1)\n"
+		"			_range := _ranges[_mid*2 : _mid*2+2]\n"
+		"			if " << GET_WIDE_KEY() << " < _range[0] {\n"
+		"				_upper = _mid\n"
+		"			} else if " << GET_WIDE_KEY() << " > _range[1] {\n"
+		"				_lower = _mid + 1\n"
+		"			} else {\n"
+		"				switch " << C() << "[_keys+_mid] {\n";
+
+	for ( CondSpaceList::Iter csi = condSpaceList; csi.lte(); csi++ ) {
+		GenCondSpace *condSpace = csi;
+		out << "				case " << condSpace->condSpaceId << ":\n";
+		out << TABS(5) << "_widec = " << CAST(WIDE_ALPH_TYPE()) << "(" <<
+				KEY(condSpace->baseKey) << " + (int(" << GET_KEY() <<
+				") - " << KEY(keyOps->minKey) << "))\n";
+
+		for ( GenCondSet::Iter csi = condSpace->condSet; csi.lte(); csi++ ) {
+			out << TABS(5) << "if ";
+			CONDITION( out, *csi );
+			Size condValOffset = ((1 << csi.pos()) * keyOps->alphSize());
+			out << " {\n" << TABS(6) << "_widec += " << condValOffset << "\n" <<
+					TABS(5) << "}\n";
+		}
+	}
+
+	out <<
+		"				}\n"
+		"				break\n"
+		"			}\n"
+		"		}\n"
+		"	}\n"
+		"\n";
+}
+
+void GoTabCodeGen::writeExec()
+{
+	testEofUsed = false;
+	outLabelUsed = false;
+
+	out <<
+		"	{\n"
+		"	var _klen int\n";
+
+	if ( redFsm->anyRegCurStateRef() )
+		out << "	var _ps int\n";
+
+	out <<
+		"	var _trans int\n";
+
+	if ( redFsm->anyConditions() )
+		out << "	var _widec " << WIDE_ALPH_TYPE() << "\n";
+
+	if ( redFsm->anyToStateActions() || redFsm->anyRegActions()
+			|| redFsm->anyFromStateActions() )
+		out << "	var _acts int\n";
+
+	out <<
+		"	var _keys int\n"
+		"\n";
+
+	if ( !noEnd ) {
+		testEofUsed = true;
+		out <<
+			"	if " << P() << " == " << PE() << " {\n"
+			"		goto _test_eof\n"
+			"	}\n";
+	}
+
+	if ( redFsm->errState != 0 ) {
+		outLabelUsed = true;
+		out <<
+			"	if " << vCS() << " == " << redFsm->errState->id << " {\n"
+			"		goto _out\n"
+			"	}\n";
+	}
+
+	out << "_resume:\n";
+
+	if ( redFsm->anyFromStateActions() ) {
+		out <<
+			"	_acts = int(" << FSA() << "[" << vCS() << "])\n"
+			"	for _, _act := range " << A() << "[_acts+1 : _acts+1+int(" << A() << "[_acts])] {\n"
+			"		switch _act {\n";
+			FROM_STATE_ACTION_SWITCH() <<
+			"		}\n"
+			"	}\n"
+			"\n";
+	}
+
+	if ( redFsm->anyConditions() )
+		GoTabSearch::COND_TRANSLATE();
+
+	GoTabSearch::LOCATE_TRANS();
+
+	out << "_match:\n";
+
+	if ( useIndicies )
+		out << "	_trans = int(" << I() << "[_trans])\n";
+
+	if ( redFsm->anyEofTrans() )
+		out << "_eof_trans:\n";
+
+	if ( redFsm->anyRegCurStateRef() )
+		out << "	_ps = " << vCS() << "\n";
+
+	out <<
+		"	" << vCS() << " = int(" << TT() << "[_trans])\n"
+		"\n";
+
+	if ( redFsm->anyRegActions() ) {
+		out <<
+			"	if " << TA() << "[_trans] == 0 {\n"
+			"		goto _again\n"
+			"	}\n"
+			"\n"
+			"	_acts = int(" << TA() << "[_trans])\n"
+			"	for _, _act := range " << A() << "[_acts+1 : _acts+1+int(" << A() << "[_acts])] {\n"
+			"		switch _act {\n";
+			ACTION_SWITCH() <<
+			"		}\n"
+			"	}\n"
+			"\n";
+	}
+
+	if ( redFsm->anyRegActions() || redFsm->anyActionGotos() ||
+			redFsm->anyActionCalls() || redFsm->anyActionRets() )
+		out << "_again:\n";
+
+	if ( redFsm->anyToStateActions() ) {
+		out <<
+			"	_acts = int(" << TSA() << "[" << vCS() << "])\n"
+			"	for _, _act := range " << A() << "[_acts+1 : _acts+1+int(" << A() << "[_acts])] {\n"
+			"		switch _act {\n";
+			TO_STATE_ACTION_SWITCH() <<
+			"		}\n"
+			"	}\n"
+			"\n";
+	}
+
+	if ( redFsm->errState != 0 ) {
+		outLabelUsed = true;
+		out <<
+			"	if " << vCS() << " == " << redFsm->errState->id << " {\n"
+			"		goto _out\n"
+			"	}\n";
+	}
+
+	if ( !noEnd ) {
+		out <<
+			"	" << P() << "++\n"
+			"	if " << P() << " != " << PE() << " {\n"
+			"		goto _resume\n"
+			"	}\n";
+	}
+	else {
+		out <<
+			"	" << P() << "++\n"
+			"	goto _resume\n";
+	}
+
+	if ( testEofUsed )
+		out << "	_test_eof: {}\n";
+
+	if ( redFsm->anyEofTrans() || redFsm->anyEofActions() ) {
+		out <<
+			"	if " << P() << " == " << vEOF() << " {\n";
+
+		if ( redFsm->anyEofTrans() ) {
+			out <<
+				"	if " << ET() << "[" << vCS() << "] > 0 {\n"
+				"		_trans = int(" << ET() << "[" << vCS() << "]) - 1\n"
+				"		goto _eof_trans\n"
+				"	}\n";
+		}
+
+		if ( redFsm->anyEofActions() ) {
+			out <<
+				"	__acts := int(" << EA() << "[" << vCS() << "])\n"
+				"	for _, _act := range " << A() << "[__acts+1 : __acts+1+int(" << A() << "[__acts])] {\n"
+				"		switch _act {\n";
+				EOF_ACTION_SWITCH() <<
+				"		}\n"
+				"	}\n";
+		}
+
+		out <<
+			"	}\n"
+			"\n";
+	}
+
+	if ( outLabelUsed )
+		out << "	_out: {}\n";
+
+	out << "	}\n";
+}
+
+void GoFTabCodeGen::writeExec()
+{
+	testEofUsed = false;
+	outLabelUsed = false;
+
+	out <<
+		"	{\n"
+		"	var _klen int\n";
+
+	if ( redFsm->anyRegCurStateRef() )
+		out << "	var _ps int\n";
+
+	out <<
+		"	var _trans int\n";
+
+	if ( redFsm->anyConditions() )
+		out << "	var _widec " << WIDE_ALPH_TYPE() << "\n";
+
+	out <<
+		"	var _keys int\n"
+		"\n";
+
+	if ( !noEnd ) {
+		testEofUsed = true;
+		out <<
+			"	if " << P() << " == " << PE() << " {\n"
+			"		goto _test_eof\n"
+			"	}\n";
+	}
+
+	if ( redFsm->errState != 0 ) {
+		outLabelUsed = true;
+		out <<
+			"	if " << vCS() << " == " << redFsm->errState->id << " {\n"
+			"		goto _out\n"
+			"	}\n";
+	}
+
+	out << "_resume:\n";
+
+	if ( redFsm->anyFromStateActions() ) {
+		out <<
+			"	switch " << FSA() << "[" << vCS() << "] {\n";
+			FROM_STATE_ACTION_SWITCH() <<
+			"	}\n"
+			"\n";
+	}
+
+	if ( redFsm->anyConditions() )
+		GoTabSearch::COND_TRANSLATE();
+
+	GoTabSearch::LOCATE_TRANS();
+
+	out << "_match:\n";
+
+	if ( useIndicies )
+		out << "	_trans = int(" << I() << "[_trans])\n";
+
+	if ( redFsm->anyEofTrans() )
+		out << "_eof_trans:\n";
+
+	if ( redFsm->anyRegCurStateRef() )
+		out << "	_ps = " << vCS() << "\n";
+
+	out <<
+		"	" << vCS() << " = int(" << TT() << "[_trans])\n"
+		"\n";
+
+	if ( redFsm->anyRegActions() ) {
+		out <<
+			"	if " << TA() << "[_trans] == 0 {\n"
+			"		goto _again\n"
+			"	}\n"
+			"\n"
+			"	switch " << TA() << "[_trans] {\n";
+			ACTION_SWITCH() <<
+			"	}\n"
+			"\n";
+	}
+
+	if ( redFsm->anyRegActions() || redFsm->anyActionGotos() ||
+			redFsm->anyActionCalls() || redFsm->anyActionRets() )
+		out << "_again:\n";
+
+	if ( redFsm->anyToStateActions() ) {
+		out <<
+			"	switch " << TSA() << "[" << vCS() << "] {\n";
+			TO_STATE_ACTION_SWITCH() <<
+			"	}\n"
+			"\n";
+	}
+
+	if ( redFsm->errState != 0 ) {
+		outLabelUsed = true;
+		out <<
+			"	if " << vCS() << " == " << redFsm->errState->id << " {\n"
+			"		goto _out\n"
+			"	}\n";
+	}
+
+	if ( !noEnd ) {
+		out <<
+			"	" << P() << "++\n"
+			"	if " << P() << " != " << PE() << " {\n"
+			"		goto _resume\n"
+			"	}\n";
+	}
+	else {
+		out <<
+			"	" << P() << "++\n"
+			"	goto _resume\n";
+	}
+
+	if ( testEofUsed )
+		out << "	_test_eof: {}\n";
+
+	if ( redFsm->anyEofTrans() || redFsm->anyEofActions() ) {
+		out <<
+			"	if " << P() << " == " << vEOF() << " {\n";
+
+		if ( redFsm->anyEofTrans() ) {
+			out <<
+				"	if " << ET() << "[" << vCS() << "] > 0 {\n"
+				"		_trans = int(" << ET() << "[" << vCS() << "]) - 1\n"
+				"		goto _eof_trans\n"
+				"	}\n";
+		}
+
+		if ( redFsm->anyEofActions() ) {
+			out <<
+				"	switch " << EA() << "[" << vCS() << "] {\n";
+				EOF_ACTION_SWITCH() <<
+				"	}\n";
+		}
+
+		out <<
+			"	}\n"
+			"\n";
+	}
+
+	if ( outLabelUsed )
+		out << "	_out: {}\n";
+
+	out << "	}\n";
+}
@@ -0,0 +1,84 @@
+/*
+ *  Copyright 2010 Adrian Thurston <thurston@complang.org>
+ */
+
+/*  This file is part of Ragel.
+ *
+ *  Ragel is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Ragel is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Ragel; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _GOTABLE_H
+#define _GOTABLE_H
+
+#include "cdtable.h"
+#include "cdftable.h"
+#include "gocodegen.h"
+
+/*
+ * GoTabSearch
+ *
+ * The tables are those of the C code. Go has no pointer arithmetic, so the
+ * exec works with offsets into the tables and searches the keys of a state
+ * in a slice of them. Shared by the plain and the fast tables.
+ */
+class GoTabSearch : virtual public FsmCodeGen
+{
+public:
+	GoTabSearch( ostream &out ) : FsmCodeGen(out) {}
+
+protected:
+	void LOCATE_TRANS();
+	void COND_TRANSLATE();
+};
+
+/*
+ * GoTabCodeGen
+ */
+struct GoTabCodeGen
+	: public TabCodeGen, public GoCodeGen, public GoTabSearch
+{
+	GoTabCodeGen( ostream &out ) :
+		FsmCodeGen(out), TabCodeGen(out), GoCodeGen(out), GoTabSearch(out) {}
+
+	void CALL( ostream &ret, int callDest, int targState, bool inFinish )
+		{ GoCodeGen::CALL( ret, callDest, targState, inFinish ); }
+	void CALL_EXPR( ostream &ret, GenInlineItem *ilItem, int targState, bool inFinish )
+		{ GoCodeGen::CALL_EXPR( ret, ilItem, targState, inFinish ); }
+	void RET( ostream &ret, bool inFinish )
+		{ GoCodeGen::RET( ret, inFinish ); }
+
+	virtual void writeExec();
+};
+
+/*
+ * GoFTabCodeGen
+ */
+struct GoFTabCodeGen
+	: public FTabCodeGen, public GoCodeGen, public GoTabSearch
+{
+	GoFTabCodeGen( ostream &out ) :
+		FsmCodeGen(out), FTabCodeGen(out), GoCodeGen(out), GoTabSearch(out) {}
+
+	void CALL( ostream &ret, int callDest, int targState, bool inFinish )
+		{ GoCodeGen::CALL( ret, callDest, targState, inFinish ); }
+	void CALL_EXPR( ostream &ret, GenInlineItem *ilItem, int targState, bool inFinish )
+		{ GoCodeGen::CALL_EXPR( ret, ilItem, targState, inFinish ); }
+	void RET( ostream &ret, bool inFinish )
+		{ GoCodeGen::RET( ret, inFinish ); }
+
+	virtual void writeExec();
+};
+
+#endif
@@ -25,7 +25,13 @@
 #include "parsedata.h"
 #include "rlparse.h"
 #include <iostream>
+#include <sstream>
 #include "dotcodegen.h"
+#include "compprof.h"
+
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 using std::cout;
 using std::cerr;
@@ -183,6 +189,10 @@ void InputData::prepareMachineGen()
 
 		dotGenParser->pd->prepareMachineGen( gdEl );
 	}
+	else if ( numJobs > 1 ) {
+		/* Generate everything, spread over threads. */
+		compileParallel( false );
+	}
 	else {
 		/* No machine spec or machine name given. Generate everything. */
 		for ( ParserDict::Iter parser = parserDict; parser.lte(); parser++ ) {
@@ -197,6 +207,8 @@ void InputData::generateReduced()
 {
 	if ( generateDot )
 		dotGenParser->pd->generateReduced( *this );
+	else if ( numJobs > 1 )
+		compileParallel( true );
 	else {
 		for ( ParserDict::Iter parser = parserDict; parser.lte(); parser++ ) {
 			ParseData *pd = parser->value->pd;
@@ -206,6 +218,114 @@ void InputData::generateReduced()
 	}
 }
 
+/* Machine specifications handed out to the threads of a parallel compile.
+ * Each section collects its own error messages and count. */
+struct CompileJobs
+{
+	InputData *id;
+	bool reduce;
+
+	ParseData **sections;
+	std::ostringstream *diags;
+	int *errorCounts;
+	int numSections;
+	int nextSection;
+
+#ifdef HAVE_LIBPTHREAD
+	pthread_mutex_t mutex;
+#endif
+};
+
+/* Pull sections off the job list until there are none left. Keyops, cond
+ * data, the error count and the diagnostics stream are all thread local. */
+static void *compileWorker( void *arg )
+{
+	CompileJobs *jobs = (CompileJobs*)arg;
+
+	while ( true ) {
+#ifdef HAVE_LIBPTHREAD
+		pthread_mutex_lock( &jobs->mutex );
+#endif
+		int s = jobs->nextSection++;
+#ifdef HAVE_LIBPTHREAD
+		pthread_mutex_unlock( &jobs->mutex );
+#endif
+		if ( s >= jobs->numSections )
+			break;
+
+		diagStream = &jobs->diags[s];
+		gblErrorCount = 0;
+
+		if ( jobs->reduce )
+			jobs->sections[s]->generateReduced( *jobs->id );
+		else
+			jobs->sections[s]->prepareMachineGen( 0 );
+
+		jobs->errorCounts[s] = gblErrorCount;
+	}
+
+	diagStream = 0;
+	return 0;
+}
+
+/* Construct and minimize (or reduce) every machine specification using
+ * numJobs threads. Errors are reported afterwards in the same order that the
+ * serial compile reports them. Without thread support the sections are
+ * compiled one after another. */
+void InputData::compileParallel( bool reduce )
+{
+	CompileJobs jobs;
+	jobs.id = this;
+	jobs.reduce = reduce;
+	jobs.sections = new ParseData*[parserDict.length()];
+	jobs.numSections = 0;
+	jobs.nextSection = 0;
+
+	for ( ParserDict::Iter parser = parserDict; parser.lte(); parser++ ) {
+		ParseData *pd = parser->value->pd;
+		if ( pd->instanceList.length() > 0 )
+			jobs.sections[jobs.numSections++] = pd;
+	}
+
+	jobs.diags = new std::ostringstream[jobs.numSections];
+	jobs.errorCounts = new int[jobs.numSections];
+
+	/* The main thread works too. Its own error count is set aside. */
+	int mainErrorCount = gblErrorCount;
+
+#ifdef HAVE_LIBPTHREAD
+	pthread_mutex_init( &jobs.mutex, 0 );
+
+	int numThreads = 0;
+	pthread_t *threads = new pthread_t[numJobs];
+	while ( numThreads < numJobs - 1 && numThreads < jobs.numSections - 1 ) {
+		if ( pthread_create( &threads[numThreads], 0, compileWorker, &jobs ) != 0 )
+			break;
+		numThreads += 1;
+	}
+
+	compileWorker( &jobs );
+
+	for ( int t = 0; t < numThreads; t++ )
+		pthread_join( threads[t], 0 );
+
+	delete[] threads;
+	pthread_mutex_destroy( &jobs.mutex );
+#else
+	compileWorker( &jobs );
+#endif
+
+	gblErrorCount = mainErrorCount;
+	for ( int s = 0; s < jobs.numSections; s++ ) {
+		cerr << jobs.diags[s].str();
+		gblErrorCount += jobs.errorCounts[s];
+	}
+
+	delete[] jobs.sections;
+	delete[] jobs.diags;
+	delete[] jobs.errorCounts;
+}
+
 /* Send eof to all parsers. */
 void InputData::terminateAllParsers( )
 {
@@ -235,14 +355,17 @@ void InputData::writeOutput()
 {
 	if ( generateXML )
 		writeXML( *outStream );
-	else if ( generateDot )
+	else if ( generateDot ) {
+		PhaseTimer phaseTimer( dotGenParser->pd->phaseTimes, PhaseEmit );
 		static_cast<GraphvizDotGen*>(dotGenParser->pd->cgd)->writeDotFile();
+	}
 	else {
 		for ( InputItemList::Iter ii = inputItems; ii.lte(); ii++ ) {
 			if ( ii->type == InputItem::Write ) {
 				CodeGenData *cgd = ii->pd->cgd;
 				::keyOps = &cgd->thisKeyOps;
 
+				PhaseTimer phaseTimer( ii->pd->phaseTimes, PhaseEmit );
 				cgd->writeStatement( ii->loc, ii->writeArgs.length()-1, ii->writeArgs.data );
 			}
 			else {
@@ -251,6 +374,19 @@ void InputData::writeOutput()
 				*outStream << ii->data.str();
 			}
 		}
+
+		/* Every machine has been written. */
+		for ( ParserList::Iter parser = parserList; parser.lte(); parser++ ) {
+			delete parser->pd->cgd;
+			parser->pd->cgd = 0;
+		}
 	}
 }
 
+/* Phase times come out once the output is written, in the order the
+ * specifications appear. */
+void InputData::reportPhaseTimes()
+{
+	for ( ParserList::Iter parser = parserList; parser.lte(); parser++ )
+		parser->pd->reportPhaseTimes();
+}
@@ -90,6 +90,8 @@ struct InputData
 	void openOutput();
 	void generateReduced();
 	void prepareMachineGen();
+	void compileParallel( bool reduce );
+	void reportPhaseTimes();
 	void terminateAllParsers();
 
 	void cdDefaultFileName( const char *inputFile );
@@ -237,6 +237,9 @@ void JavaTabCodeGen::INLINE_LIST( ostream &ret, GenInlineList *inlineList,
 		case GenInlineItem::Break:
 			BREAK( ret, targState );
 			break;
+		case GenInlineItem::Counter:
+			ret << COUNTERS() << "[" << item->counterId << "]";
+			break;
 		}
 	}
 }
@@ -972,6 +975,16 @@ void JavaTabCodeGen::writeData()
 		"\n";
 	}
 
+	STATE_IDS();
+}
+
+/* The unpack functions of packed tables and the state ids, which follow the
+ * tables of every style. */
+void JavaTabCodeGen::STATE_IDS()
+{
+	if ( packedTablesOpt )
+		UNPACK_FUNCS();
+
 	if ( redFsm->startState != 0 )
 		STATIC_VAR( "int", START() ) << " = " << START_STATE_ID() << ";\n";
 
@@ -980,6 +993,11 @@ void JavaTabCodeGen::writeData()
 
 	if ( !noError )
 		STATIC_VAR( "int", ERROR() ) << " = " << ERROR_STATE() << ";\n";
+
+	if ( numCounters > 0 ) {
+		STATIC_VAR( "int", DATA_PREFIX() + "num_counters" ) <<
+				" = " << numCounters << ";\n";
+	}
 	
 	out << "\n";
 
@@ -1174,6 +1192,15 @@ std::ostream &JavaTabCodeGen::OPEN_ARRAY( string type, string name )
 	item_count = 0;
 	div_count = 1;
 
+	if ( packedTablesOpt ) {
+		packedItems.empty();
+		for ( int i = 0; i < hostLang->numHostTypes; i++ ) {
+			if ( type == hostLang->hostTypes[i].data1 )
+				packedTypes |= 1ul << i;
+		}
+		return out;
+	}
+
 	out <<  "private static " << type << "[] init_" << name << "_0()\n"
 		"{\n\t"
 		"return new " << type << " [] {\n\t";
@@ -1184,6 +1211,11 @@ std::ostream &JavaTabCodeGen::ARRAY_ITEM( string item, bool last )
 {
 	item_count++;
 
+	if ( packedTablesOpt ) {
+		packedItems.append( strtol( item.c_str(), 0, 10 ) );
+		return out;
+	}
+
 	out << setw(5) << setiosflags(ios::right) << item;
 	
 	if ( !last ) {
@@ -1205,6 +1237,31 @@ std::ostream &JavaTabCodeGen::ARRAY_ITEM( string item, bool last )
 
 std::ostream &JavaTabCodeGen::CLOSE_ARRAY()
 {
+	if ( packedTablesOpt ) {
+		/* Run length encode the items as pairs of a count and a value. An int
+		 * value takes two chars, the high half first. */
+		Vector<long> chars;
+		bool wide = array_type == "int";
+		for ( long i = 0; i < packedItems.length(); ) {
+			long count = 1;
+			while ( i + count < packedItems.length() && count < 0xffff &&
+					packedItems[i + count] == packedItems[i] )
+				count++;
+
+			chars.append( count );
+			if ( wide )
+				chars.append( ( packedItems[i] >> 16 ) & 0xffff );
+			chars.append( packedItems[i] & 0xffff );
+			i += count;
+		}
+
+		out << "private static final " << array_type << " " << array_name <<
+				"[] = _" << DATA_PREFIX() << "unpack_" << array_type << "(\n\t";
+		PACKED_STRING( chars );
+		out << ", " << item_count << " );\n";
+		return out;
+	}
+
 	out << "\n\t};\n}\n\n";
 
 	if (item_count < SAIIC) {
@@ -1233,6 +1290,91 @@ std::ostream &JavaTabCodeGen::CLOSE_ARRAY()
 	return out;
 }
 
+/* Write chars as an array of string literals. The constant pool holds a
+ * literal in at most 65535 bytes of modified UTF-8, so a new literal is
+ * started before that is reached. A pair is never split. */
+void JavaTabCodeGen::PACKED_STRING( const Vector<long> &chars )
+{
+	int pairLen = array_type == "int" ? 3 : 2;
+	long utfLen = 0, lineLen = 0;
+
+	out << "new String[] {\n\t\"";
+	for ( long i = 0; i < chars.length(); i++ ) {
+		long c = chars[i];
+		int cLen = c == 0 ? 2 : c < 0x80 ? 1 : c < 0x800 ? 2 : 3;
+
+		if ( i % pairLen == 0 && i > 0 ) {
+			if ( utfLen + pairLen * 3 > 65535 ) {
+				out << "\",\n\t\"";
+				utfLen = lineLen = 0;
+			}
+			else if ( lineLen >= 64 ) {
+				out << "\" +\n\t\"";
+				lineLen = 0;
+			}
+		}
+
+		/* Unicode escapes are translated before the lexer sees them, so the
+		 * chars that may be a newline, a quote or a backslash are written in
+		 * octal. */
+		if ( c >= 0x20 && c < 0x7f && c != '"' && c != '\\' ) {
+			out << (char) c;
+			lineLen += 1;
+		}
+		else if ( c < 0x100 ) {
+			out << "\\" << std::oct << setw(3) << std::setfill('0') << c <<
+					std::dec << std::setfill(' ');
+			lineLen += 4;
+		}
+		else {
+			out << "\\u" << std::hex << setw(4) << std::setfill('0') << c <<
+					std::dec << std::setfill(' ');
+			lineLen += 6;
+		}
+		utfLen += cLen;
+	}
+	out << "\"\n\t}";
+}
+
+/* The unpack functions of the element types of the packed arrays. */
+void JavaTabCodeGen::UNPACK_FUNCS()
+{
+	for ( int i = 0; i < hostLang->numHostTypes; i++ ) {
+		if ( !( packedTypes & ( 1ul << i ) ) )
+			continue;
+
+		string type = hostLang->hostTypes[i].data1;
+		out <<
+			"private static " << type << "[] _" << DATA_PREFIX() << "unpack_" << type <<
+					"( String[] packed, int length )\n"
+			"{\n"
+			"	" << type << "[] a = new " << type << "[length];\n"
+			"	int i = 0;\n"
+			"	for ( int s = 0; s < packed.length; s++ ) {\n"
+			"		String p = packed[s];\n"
+			"		for ( int j = 0; j < p.length(); ) {\n"
+			"			int count = p.charAt( j++ );\n";
+
+		if ( type == "int" ) {
+			out <<
+				"			int value = ( p.charAt( j ) << 16 ) | p.charAt( j + 1 );\n"
+				"			j += 2;\n";
+		}
+		else {
+			out <<
+				"			" << type << " value = (" << type << ") p.charAt( j++ );\n";
+		}
+
+		out <<
+			"			while ( count-- > 0 )\n"
+			"				a[i++] = value;\n"
+			"		}\n"
+			"	}\n"
+			"	return a;\n"
+			"}\n"
+			"\n";
+	}
+}
 
 std::ostream &JavaTabCodeGen::STATIC_VAR( string type, string name )
 {
@@ -1403,6 +1545,19 @@ string JavaTabCodeGen::TOP()
 	return ret.str();
 }
 
+string JavaTabCodeGen::COUNTERS()
+{
+	ostringstream ret;
+	if ( countersExpr == 0 )
+		ret << ACCESS() + "counters";
+	else {
+		ret << "(";
+		INLINE_LIST( ret, countersExpr, 0, false );
+		ret << ")";
+	}
+	return ret.str();
+}
+
 string JavaTabCodeGen::STACK()
 {
 	ostringstream ret;
@@ -1651,7 +1806,10 @@ void JavaTabCodeGen::finishRagelDef()
 	redFsm->chooseDefaultSpan();
 		
 	/* Maybe do flat expand, otherwise choose single. */
-	redFsm->chooseSingle();
+	if ( codeStyle == GenFlat || codeStyle == GenFFlat )
+		redFsm->makeFlat();
+	else
+		redFsm->chooseSingle();
 
 	/* If any errors have occured in the input file then don't write anything. */
 	if ( gblErrorCount > 0 )
@@ -38,12 +38,12 @@ using std::ostream;
 struct JavaTabCodeGen : public CodeGenData
 {
 	JavaTabCodeGen( ostream &out ) : 
-		CodeGenData(out) {}
+		CodeGenData(out), packedTypes(0) {}
 
-	std::ostream &TO_STATE_ACTION_SWITCH();
-	std::ostream &FROM_STATE_ACTION_SWITCH();
-	std::ostream &EOF_ACTION_SWITCH();
-	std::ostream &ACTION_SWITCH();
+	virtual std::ostream &TO_STATE_ACTION_SWITCH();
+	virtual std::ostream &FROM_STATE_ACTION_SWITCH();
+	virtual std::ostream &EOF_ACTION_SWITCH();
+	virtual std::ostream &ACTION_SWITCH();
 
 	std::ostream &COND_KEYS();
 	std::ostream &COND_SPACES();
@@ -76,6 +76,7 @@ struct JavaTabCodeGen : public CodeGenData
 
 	virtual void writeExec();
 	virtual void writeData();
+	void STATE_IDS();
 	virtual void writeInit();
 	virtual void writeExports();
 	virtual void writeStart();
@@ -86,20 +87,29 @@ struct JavaTabCodeGen : public CodeGenData
 	void NEXT( ostream &ret, int nextDest, bool inFinish );
 	void NEXT_EXPR( ostream &ret, GenInlineItem *ilItem, bool inFinish );
 
-	int TO_STATE_ACTION( RedStateAp *state );
-	int FROM_STATE_ACTION( RedStateAp *state );
-	int EOF_ACTION( RedStateAp *state );
-	int TRANS_ACTION( RedTransAp *trans );
+	virtual int TO_STATE_ACTION( RedStateAp *state );
+	virtual int FROM_STATE_ACTION( RedStateAp *state );
+	virtual int EOF_ACTION( RedStateAp *state );
+	virtual int TRANS_ACTION( RedTransAp *trans );
 
 	/* Determine if we should use indicies. */
 	void calcIndexSize();
 
-private:
+protected:
 	string array_type;
 	string array_name;
 	int item_count;
 	int div_count;
 
+	/* With --packed-tables the items of the open array are collected and
+	 * written as string literals. The host types that need an unpack
+	 * function, one bit each, are written after the data. */
+	Vector<long> packedItems;
+	unsigned long packedTypes;
+
+	void PACKED_STRING( const Vector<long> &chars );
+	void UNPACK_FUNCS();
+
 public:
 
 	virtual string NULL_ITEM();
@@ -135,6 +145,7 @@ public:
 	string vCS();
 	string STACK();
 	string TOP();
+	string COUNTERS();
 	string TOKSTART();
 	string TOKEND();
 	string ACT();
@@ -161,6 +172,7 @@ public:
 	string ET() { return "_" + DATA_PREFIX() + "eof_trans"; }
 	string SP() { return "_" + DATA_PREFIX() + "key_spans"; }
 	string CSP() { return "_" + DATA_PREFIX() + "cond_key_spans"; }
+	string CC() { return "_" + DATA_PREFIX() + "char_class"; }
 	string START() { return DATA_PREFIX() + "start"; }
 	string ERROR() { return DATA_PREFIX() + "error"; }
 	string FIRST_FINAL() { return DATA_PREFIX() + "first_final"; }
@@ -0,0 +1,391 @@
+/*
+ *  Copyright 2010 Adrian Thurston <thurston@complang.org>
+ */
+
+/*  This file is part of Ragel.
+ *
+ *  Ragel is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Ragel is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Ragel; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ragel.h"
+#include "javafflat.h"
+#include "redfsm.h"
+#include "gendata.h"
+
+/* Labels of the goto loop, as in javacodegen.cpp. */
+#define _resume    1
+#define _again     2
+#define _eof_trans 3
+#define _test_eof  4
+#define _out       5
+
+int JavaFFlatCodeGen::TO_STATE_ACTION( RedStateAp *state )
+{
+	int act = 0;
+	if ( state->toStateAction != 0 )
+		act = state->toStateAction->actListId+1;
+	return act;
+}
+
+int JavaFFlatCodeGen::FROM_STATE_ACTION( RedStateAp *state )
+{
+	int act = 0;
+	if ( state->fromStateAction != 0 )
+		act = state->fromStateAction->actListId+1;
+	return act;
+}
+
+int JavaFFlatCodeGen::EOF_ACTION( RedStateAp *state )
+{
+	int act = 0;
+	if ( state->eofAction != 0 )
+		act = state->eofAction->actListId+1;
+	return act;
+}
+
+int JavaFFlatCodeGen::TRANS_ACTION( RedTransAp *trans )
+{
+	int act = 0;
+	if ( trans->action != 0 )
+		act = trans->action->actListId+1;
+	return act;
+}
+
+std::ostream &JavaFFlatCodeGen::TO_STATE_ACTION_SWITCH()
+{
+	/* Loop the action tables. */
+	for ( GenActionTableMap::Iter redAct = redFsm->actionMap; redAct.lte(); redAct++ ) {
+		if ( redAct->numToStateRefs > 0 ) {
+			/* Write the entry label. */
+			out << "\tcase " << redAct->actListId+1 << ":\n";
+
+			/* Write each action in the list of action items. */
+			for ( GenActionTable::Iter item = redAct->key; item.lte(); item++ )
+				ACTION( out, item->value, 0, false );
+
+			out << "\tbreak;\n";
+		}
+	}
+
+	genLineDirective( out );
+	return out;
+}
+
+std::ostream &JavaFFlatCodeGen::FROM_STATE_ACTION_SWITCH()
+{
+	/* Loop the action tables. */
+	for ( GenActionTableMap::Iter redAct = redFsm->actionMap; redAct.lte(); redAct++ ) {
+		if ( redAct->numFromStateRefs > 0 ) {
+			/* Write the entry label. */
+			out << "\tcase " << redAct->actListId+1 << ":\n";
+
+			/* Write each action in the list of action items. */
+			for ( GenActionTable::Iter item = redAct->key; item.lte(); item++ )
+				ACTION( out, item->value, 0, false );
+
+			out << "\tbreak;\n";
+		}
+	}
+
+	genLineDirective( out );
+	return out;
+}
+
+std::ostream &JavaFFlatCodeGen::EOF_ACTION_SWITCH()
+{
+	/* Loop the action tables. */
+	for ( GenActionTableMap::Iter redAct = redFsm->actionMap; redAct.lte(); redAct++ ) {
+		if ( redAct->numEofRefs > 0 ) {
+			/* Write the entry label. */
+			out << "\tcase " << redAct->actListId+1 << ":\n";
+
+			/* Write each action in the list of action items. */
+			for ( GenActionTable::Iter item = redAct->key; item.lte(); item++ )
+				ACTION( out, item->value, 0, true );
+
+			out << "\tbreak;\n";
+		}
+	}
+
+	genLineDirective( out );
+	return out;
+}
+
+std::ostream &JavaFFlatCodeGen::ACTION_SWITCH()
+{
+	/* Loop the action tables. */
+	for ( GenActionTableMap::Iter redAct = redFsm->actionMap; redAct.lte(); redAct++ ) {
+		if ( redAct->numTransRefs > 0 ) {
+			/* Write the entry label. */
+			out << "\tcase " << redAct->actListId+1 << ":\n";
+
+			/* Write each action in the list of action items. */
+			for ( GenActionTable::Iter item = redAct->key; item.lte(); item++ )
+				ACTION( out, item->value, 0, false );
+
+			out << "\tbreak;\n";
+		}
+	}
+
+	genLineDirective( out );
+	return out;
+}
+
+void JavaFFlatCodeGen::writeData()
+{
+	if ( redFsm->anyConditions() ) {
+		OPEN_ARRAY( WIDE_ALPH_TYPE(), CK() );
+		COND_KEYS();
+		CLOSE_ARRAY() <<
+		"\n";
+
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxCondSpan), CSP() );
+		COND_KEY_SPANS();
+		CLOSE_ARRAY() <<
+		"\n";
+
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxCond), C() );
+		CONDS();
+		CLOSE_ARRAY() <<
+		"\n";
+
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxCondIndexOffset), CO() );
+		COND_INDEX_OFFSET();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+
+	if ( redFsm->anyCharClasses() ) {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->numClasses), CC() );
+		CHAR_CLASS();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+
+	OPEN_ARRAY( KEYS_TYPE(), K() );
+	KEYS();
+	CLOSE_ARRAY() <<
+	"\n";
+
+	OPEN_ARRAY( ARRAY_TYPE(redFsm->maxSpan), SP() );
+	KEY_SPANS();
+	CLOSE_ARRAY() <<
+	"\n";
+
+	OPEN_ARRAY( ARRAY_TYPE(redFsm->maxFlatIndexOffset), IO() );
+	FLAT_INDEX_OFFSET();
+	CLOSE_ARRAY() <<
+	"\n";
+
+	OPEN_ARRAY( ARRAY_TYPE(redFsm->maxIndex), I() );
+	INDICIES();
+	CLOSE_ARRAY() <<
+	"\n";
+
+	OPEN_ARRAY( ARRAY_TYPE(redFsm->maxState), TT() );
+	TRANS_TARGS_WI();
+	CLOSE_ARRAY() <<
+	"\n";
+
+	if ( redFsm->anyActions() ) {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxActListId), TA() );
+		TRANS_ACTIONS_WI();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+
+	if ( redFsm->anyToStateActions() ) {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxActListId), TSA() );
+		TO_STATE_ACTIONS();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+
+	if ( redFsm->anyFromStateActions() ) {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxActListId), FSA() );
+		FROM_STATE_ACTIONS();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+
+	if ( redFsm->anyEofActions() ) {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxActListId), EA() );
+		EOF_ACTIONS();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+
+	if ( redFsm->anyEofTrans() ) {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->maxIndexOffset+1), ET() );
+		EOF_TRANS();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+
+	STATE_IDS();
+}
+
+void JavaFFlatCodeGen::writeExec()
+{
+	out <<
+		"	{\n"
+		"	int _slen";
+
+	if ( redFsm->anyRegCurStateRef() )
+		out << ", _ps";
+
+	out <<
+		";\n"
+		"	int _trans = 0;\n"
+		"	int _keys;\n"
+		"	int _inds;\n";
+
+	if ( redFsm->anyConditions() ) {
+		out <<
+			"	int _cond;\n"
+			"	int _conds;\n"
+			"	int _widec;\n";
+	}
+
+	if ( redFsm->anyCharClasses() )
+		out << "	int _cls;\n";
+
+	out <<
+		"	int _goto_targ = 0;\n"
+		"\n";
+
+	out <<
+		"	_goto: while (true) {\n"
+		"	switch ( _goto_targ ) {\n"
+		"	case 0:\n";
+
+	if ( !noEnd ) {
+		out <<
+			"	if ( " << P() << " == " << PE() << " ) {\n"
+			"		_goto_targ = " << _test_eof << ";\n"
+			"		continue _goto;\n"
+			"	}\n";
+	}
+
+	if ( redFsm->errState != 0 ) {
+		out <<
+			"	if ( " << vCS() << " == " << redFsm->errState->id << " ) {\n"
+			"		_goto_targ = " << _out << ";\n"
+			"		continue _goto;\n"
+			"	}\n";
+	}
+
+	out << "case " << _resume << ":\n";
+
+	if ( redFsm->anyFromStateActions() ) {
+		out <<
+			"	switch ( " << FSA() << "[" << vCS() << "] ) {\n";
+			FROM_STATE_ACTION_SWITCH() <<
+			"	}\n"
+			"\n";
+	}
+
+	if ( redFsm->anyConditions() )
+		COND_TRANSLATE();
+
+	LOCATE_TRANS();
+
+	if ( redFsm->anyEofTrans() )
+		out << "case " << _eof_trans << ":\n";
+
+	if ( redFsm->anyRegCurStateRef() )
+		out << "	_ps = " << vCS() << ";\n";
+
+	out <<
+		"	" << vCS() << " = " << TT() << "[_trans];\n"
+		"\n";
+
+	if ( redFsm->anyRegActions() ) {
+		out <<
+			"	switch ( " << TA() << "[_trans] ) {\n";
+			ACTION_SWITCH() <<
+			"	}\n"
+			"\n";
+	}
+
+	out << "case " << _again << ":\n";
+
+	if ( redFsm->anyToStateActions() ) {
+		out <<
+			"	switch ( " << TSA() << "[" << vCS() << "] ) {\n";
+			TO_STATE_ACTION_SWITCH() <<
+			"	}\n"
+			"\n";
+	}
+
+	if ( redFsm->errState != 0 ) {
+		out <<
+			"	if ( " << vCS() << " == " << redFsm->errState->id << " ) {\n"
+			"		_goto_targ = " << _out << ";\n"
+			"		continue _goto;\n"
+			"	}\n";
+	}
+
+	if ( !noEnd ) {
+		out <<
+			"	if ( ++" << P() << " != " << PE() << " ) {\n"
+			"		_goto_targ = " << _resume << ";\n"
+			"		continue _goto;\n"
+			"	}\n";
+	}
+	else {
+		out <<
+			"	" << P() << " += 1;\n"
+			"	_goto_targ = " << _resume << ";\n"
+			"	continue _goto;\n";
+	}
+
+	out << "case " << _test_eof << ":\n";
+
+	if ( redFsm->anyEofTrans() || redFsm->anyEofActions() ) {
+		out <<
+			"	if ( " << P() << " == " << vEOF() << " )\n"
+			"	{\n";
+
+		if ( redFsm->anyEofTrans() ) {
+			out <<
+				"	if ( " << ET() << "[" << vCS() << "] > 0 ) {\n"
+				"		_trans = " << ET() << "[" << vCS() << "] - 1;\n"
+				"		_goto_targ = " << _eof_trans << ";\n"
+				"		continue _goto;\n"
+				"	}\n";
+		}
+
+		if ( redFsm->anyEofActions() ) {
+			out <<
+				"	switch ( " << EA() << "[" << vCS() << "] ) {\n";
+				EOF_ACTION_SWITCH() <<
+				"	}\n";
+		}
+
+		out <<
+			"	}\n"
+			"\n";
+	}
+
+	out << "case " << _out << ":\n";
+
+	/* The switch and goto loop. */
+	out << "	}\n";
+	out << "	break; }\n";
+
+	/* The execute block. */
+	out << "	}\n";
+}
@@ -0,0 +1,52 @@
+/*
+ *  Copyright 2010 Adrian Thurston <thurston@complang.org>
+ */
+
+/*  This file is part of Ragel.
+ *
+ *  Ragel is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Ragel is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Ragel; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _JAVAFFLAT_H
+#define _JAVAFFLAT_H
+
+#include <iostream>
+#include "javaflat.h"
+
+/*
+ * JavaFFlatCodeGen
+ *
+ * The flat tables with the action lists expanded into the action switches.
+ */
+struct JavaFFlatCodeGen : public JavaFlatCodeGen
+{
+	JavaFFlatCodeGen( ostream &out ) :
+		JavaFlatCodeGen(out) {}
+
+	virtual std::ostream &TO_STATE_ACTION_SWITCH();
+	virtual std::ostream &FROM_STATE_ACTION_SWITCH();
+	virtual std::ostream &EOF_ACTION_SWITCH();
+	virtual std::ostream &ACTION_SWITCH();
+
+	virtual int TO_STATE_ACTION( RedStateAp *state );
+	virtual int FROM_STATE_ACTION( RedStateAp *state );
+	virtual int EOF_ACTION( RedStateAp *state );
+	virtual int TRANS_ACTION( RedTransAp *trans );
+
+	virtual void writeData();
+	virtual void writeExec();
+};
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ *  Copyright 2010 Adrian Thurston <thurston@complang.org>
+ */
+
+/*  This file is part of Ragel.
+ *
+ *  Ragel is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Ragel is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Ragel; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _JAVAFLAT_H
+#define _JAVAFLAT_H
+
+#include <iostream>
+#include "javacodegen.h"
+
+/*
+ * JavaFlatCodeGen
+ *
+ * The transition of a key is found in a state's span of the keys, or of the
+ * character classes, without a search. All input is read through getkey, so
+ * the data can be a byte[] or a java.nio.ByteBuffer.
+ */
+struct JavaFlatCodeGen : public JavaTabCodeGen
+{
+	JavaFlatCodeGen( ostream &out ) :
+		JavaTabCodeGen(out) {}
+
+	std::ostream &KEYS();
+	std::ostream &CHAR_CLASS();
+	std::ostream &INDICIES();
+	std::ostream &FLAT_INDEX_OFFSET();
+	std::ostream &KEY_SPANS();
+
+	std::ostream &COND_KEYS();
+	std::ostream &COND_KEY_SPANS();
+	std::ostream &CONDS();
+	std::ostream &COND_INDEX_OFFSET();
+
+	string KEYS_TYPE();
+	string CLASS_OF_KEY();
+	void LOCATE_TRANS();
+	void COND_TRANSLATE();
+
+	virtual void writeData();
+	virtual void writeExec();
+};
+
+#endif
@@ -86,6 +86,41 @@ CodeStyle codeStyle = GenTables;
 int numSplitPartitions = 0;
 bool noLineDirectives = false;
 
+/* Number of threads compiling machine specifications. */
+int numJobs = 1;
+
+/* Where reduced machines are kept between runs. */
+const char *cacheDir = 0;
+
+/* Limits on the size of a machine under construction. Zero is unlimited. */
+long maxStates = 0;
+long maxMemory = 0;
+
+/* Report where machine construction spends its time. */
+bool profileCompile = false;
+bool phaseTimesOpt = false;
+
+/* Drop conditions whose two senses lead to the same transition. */
+bool dropCondsOpt = false;
+
+/* Cut flat tables into pages even when the alphabet is narrow. */
+bool flatPagesOpt = false;
+
+/* Transition counts of an instrumented run, used to lay out machines. */
+const char *profileUseFile = 0;
+
+/* Count state entries, transitions and actions in the generated code. */
+bool instrumentOpt = false;
+
+/* Write the tables as packed strings that are unpacked at load time. */
+bool packedTablesOpt = false;
+
+/* Write the tables as spans over constant data. */
+bool spanTablesOpt = false;
+
+/* Read the input through a pointer to the pinned data. */
+bool fixedDataOpt = false;
+
 bool displayPrintables = false;
 
 /* Target ruby impl */
@@ -104,6 +139,17 @@ void usage()
 "   -d                   Do not remove duplicates from action lists\n"
 "   -I <dir>             Add <dir> to the list of directories to search\n"
 "                        for included an imported files\n"
+"   --jobs=<N>           Compile independent machine specifications\n"
+"                        on <N> threads\n"
+"   --cache-dir=<dir>    Reuse machines compiled by earlier runs, keeping\n"
+"                        them in <dir>\n"
+"   --max-states=<N>     Fail if a machine grows past <N> states\n"
+"   --max-memory=<N>     Fail if machine construction uses more than <N>\n"
+"                        bytes, suffixes k, m and g are accepted\n"
+"   --profile-compile    Report the parse tree nodes that took the longest\n"
+"                        to construct\n"
+"   --phase-times        Report the time and peak memory of each phase of\n"
+"                        compiling each machine specification\n"
 "error reporting format:\n"
 "   --error-format=gnu   file:line:column: message (default)\n"
 "   --error-format=msvc  file(line,column): message\n"
@@ -112,6 +158,8 @@ void usage()
 "   -m                   Minimize at the end of the compilation\n"
 "   -l                   Minimize after most operations (default)\n"
 "   -e                   Minimize after every operation\n"
+"   --drop-conds         When minimizing, drop conditions that lead the same\n"
+"                        way in either sense, so they are not evaluated\n"
 "visualization:\n"
 "   -x                   Run the frontend only: emit XML intermediate format\n"
 "   -V                   Generate a dot file for Graphviz\n"
@@ -127,18 +175,31 @@ void usage()
 "   -A                   The host language is C#\n"
 "line direcives: (C/D/C#)\n"
 "   -L                   Inhibit writing of #line directives\n"
-"code style: (C/D/Java/Ruby/C#)\n"
+"code style: (C/D/Java/Ruby/C#/Go)\n"
 "   -T0                  Table driven FSM (default)\n"
-"code style: (C/D/Ruby/C#)\n"
+"code style: (C/D/Ruby/C#/Go)\n"
 "   -T1                  Faster table driven FSM\n"
+"code style: (C/D/Java/Ruby/C#/Go)\n"
 "   -F0                  Flat table driven FSM\n"
 "   -F1                  Faster flat table-driven FSM\n"
 "code style: (C/D/C#)\n"
 "   -G0                  Goto-driven FSM\n"
 "   -G1                  Faster goto-driven FSM\n"
 "code style: (C/D)\n"
+"   -T2                  Row displacement table driven FSM\n"
 "   -G2                  Really fast goto-driven FSM\n"
 "   -P<N>                N-Way Split really fast goto-driven FSM\n"
+"   --flat-pages         Cut -F0 and -F1 tables into shared pages\n"
+"   --profile-use=FILE   Lay out goto and -P machines by the counts in FILE\n"
+"   --instrument         Count state entries, transitions and actions (not -P)\n"
+"code style: (Java/Ruby)\n"
+"   --packed-tables      Write tables as string literals, unpacked when the\n"
+"                        code is loaded\n"
+"code style: (C#)\n"
+"   --span-tables        Write byte tables as ReadOnlySpan<T> over constant\n"
+"                        data\n"
+"   --fixed-data         Read the input through a pointer to the data pinned\n"
+"                        with fixed, in an unsafe context (not -P)\n"
 	;	
 
 	exit(0);
@@ -181,29 +242,41 @@ ostream &operator<<( ostream &out, const InputLoc &loc )
 	return out;
 }
 
-/* Total error count. */
-int gblErrorCount = 0;
+/* Total error count. Threads compiling machines in parallel count their own
+ * errors, which are added in when the threads finish. */
+THREAD_LOCAL int gblErrorCount = 0;
+
+/* Errors go to stderr unless redirected. */
+THREAD_LOCAL ostream *diagStream = 0;
+
+ostream &diagnostics()
+{
+	return diagStream != 0 ? *diagStream : cerr;
+}
 
 /* Print the opening to a warning in the input, then return the error ostream. */
 ostream &warning( const InputLoc &loc )
 {
-	cerr << loc << ": warning: ";
-	return cerr;
+	ostream &out = diagnostics();
+	out << loc << ": warning: ";
+	return out;
 }
 
 /* Print the opening to a program error, then return the error stream. */
 ostream &error()
 {
 	gblErrorCount += 1;
-	cerr << PROGNAME ": ";
-	return cerr;
+	ostream &out = diagnostics();
+	out << PROGNAME ": ";
+	return out;
 }
 
 ostream &error( const InputLoc &loc )
 {
 	gblErrorCount += 1;
-	cerr << loc << ": ";
-	return cerr;
+	ostream &out = diagnostics();
+	out << loc << ": ";
+	return out;
 }
 
 void escapeLineDirectivePath( std::ostream &out, char *path )
@@ -216,9 +289,32 @@ void escapeLineDirectivePath( std::ostream &out, char *path )
 	}
 }
 
+/* Read a byte count with an optional k, m or g suffix. Returns zero if the
+ * value is malformed. */
+long parseMemSize( const char *str )
+{
+	char *end;
+	long size = strtol( str, &end, 10 );
+	switch ( *end ) {
+		case 'k': case 'K':
+			size *= 1024L;
+			end += 1;
+			break;
+		case 'm': case 'M':
+			size *= 1024L * 1024L;
+			end += 1;
+			break;
+		case 'g': case 'G':
+			size *= 1024L * 1024L * 1024L;
+			end += 1;
+			break;
+	}
+	return *end == 0 ? size : 0;
+}
+
 void processArgs( int argc, const char **argv, InputData &id )
 {
-	ParamCheck pc("xo:dnmleabjkS:M:I:CDJZRAvHh?-:sT:F:G:P:LpV", argc, argv);
+	ParamCheck pc("xo:dnmleabjkyS:M:I:CDJZRAvHh?-:sT:F:G:P:LpV", argc, argv);
 
 	/* FIXME: Need to check code styles VS langauge. */
 
@@ -276,6 +372,9 @@ void processArgs( int argc, const char **argv, InputData &id )
 			case 'k':
 				minimizeLevel = MinimizePartition2;
 				break;
+			case 'y':
+				minimizeLevel = MinimizeHopcroft;
+				break;
 
 			/* Machine spec. */
 			case 'S':
@@ -362,6 +461,58 @@ void processArgs( int argc, const char **argv, InputData &id )
 				}
 				else if ( strcmp( arg, "rbx" ) == 0 )
 					rubyImpl = Rubinius;
+				else if ( strcmp( arg, "jobs" ) == 0 ) {
+					if ( eq == 0 )
+						error() << "expecting '=value' for jobs" << endl;
+					else if ( atoi( eq ) < 1 )
+						error() << "invalid value for jobs" << endl;
+					else
+						numJobs = atoi( eq );
+				}
+				else if ( strcmp( arg, "cache-dir" ) == 0 ) {
+					if ( eq == 0 || *eq == 0 )
+						error() << "expecting '=value' for cache-dir" << endl;
+					else
+						cacheDir = strdup( eq );
+				}
+				else if ( strcmp( arg, "max-states" ) == 0 ) {
+					if ( eq == 0 )
+						error() << "expecting '=value' for max-states" << endl;
+					else if ( atol( eq ) < 1 )
+						error() << "invalid value for max-states" << endl;
+					else
+						maxStates = atol( eq );
+				}
+				else if ( strcmp( arg, "max-memory" ) == 0 ) {
+					if ( eq == 0 )
+						error() << "expecting '=value' for max-memory" << endl;
+					else if ( parseMemSize( eq ) < 1 )
+						error() << "invalid value for max-memory" << endl;
+					else
+						maxMemory = parseMemSize( eq );
+				}
+				else if ( strcmp( arg, "profile-compile" ) == 0 )
+					profileCompile = true;
+				else if ( strcmp( arg, "phase-times" ) == 0 )
+					phaseTimesOpt = true;
+				else if ( strcmp( arg, "drop-conds" ) == 0 )
+					dropCondsOpt = true;
+				else if ( strcmp( arg, "flat-pages" ) == 0 )
+					flatPagesOpt = true;
+				else if ( strcmp( arg, "instrument" ) == 0 )
+					instrumentOpt = true;
+				else if ( strcmp( arg, "packed-tables" ) == 0 )
+					packedTablesOpt = true;
+				else if ( strcmp( arg, "span-tables" ) == 0 )
+					spanTablesOpt = true;
+				else if ( strcmp( arg, "fixed-data" ) == 0 )
+					fixedDataOpt = true;
+				else if ( strcmp( arg, "profile-use" ) == 0 ) {
+					if ( eq == 0 || *eq == 0 )
+						error() << "expecting '=value' for profile-use" << endl;
+					else
+						profileUseFile = strdup( eq );
+				}
 				else {
 					error() << "--" << pc.paramArg << 
 							" is an invalid argument" << endl;
@@ -376,6 +527,8 @@ void processArgs( int argc, const char **argv, InputData &id )
 					codeStyle = GenTables;
 				else if ( pc.paramArg[0] == '1' )
 					codeStyle = GenFTables;
+				else if ( pc.paramArg[0] == '2' )
+					codeStyle = GenCombTables;
 				else {
 					error() << "-T" << pc.paramArg[0] << 
 							" is an invalid argument" << endl;
@@ -501,6 +654,9 @@ void process( InputData &id )
 	id.openOutput();
 	id.writeOutput();
 
+	if ( phaseTimesOpt )
+		id.reportPhaseTimes();
+
 	/* Close the input and the intermediate file. */
 	delete inFile;
 
@@ -544,10 +700,31 @@ int main( int argc, const char **argv )
 	if ( id.inputFileName == 0 )
 		error() << "no input file given" << endl;
 
+	if ( instrumentOpt && ( codeStyle == GenSplit || 
+			( hostLang->lang != HostLang::C && hostLang->lang != HostLang::D ) ) )
+		error() << "--instrument is only supported by the C/D styles other than -P" << endl;
+
+	if ( packedTablesOpt && hostLang->lang != HostLang::Java && hostLang->lang != HostLang::Ruby )
+		error() << "--packed-tables is only supported by Java and Ruby" << endl;
+
+	if ( spanTablesOpt && hostLang->lang != HostLang::CSharp )
+		error() << "--span-tables is only supported by C#" << endl;
+
+	if ( fixedDataOpt && ( codeStyle == GenSplit || hostLang->lang != HostLang::CSharp ) )
+		error() << "--fixed-data is only supported by the C# styles other than -P" << endl;
+
+	if ( !generateXML )
+		checkCodeStyle();
+
 	/* Bail on argument processing errors. */
 	if ( gblErrorCount > 0 )
 		exit(1);
 
+	/* Phase times and peak memory are taken from the whole process. They
+	 * only belong to one section when sections are compiled one at a time. */
+	if ( phaseTimesOpt )
+		numJobs = 1;
+
 	/* Make sure we are not writing to the same file as the input file. */
 	if ( id.inputFileName != 0 && id.outputFileName != 0 && 
 			strcmp( id.inputFileName, id.outputFileName  ) == 0 )
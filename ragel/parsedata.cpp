@@ -21,6 +21,7 @@
 
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include <errno.h>
 #include <stdlib.h>
 #include <limits.h>
@@ -33,6 +34,7 @@
 #include "xmlcodegen.h"
 #include "version.h"
 #include "inputdata.h"
+#include "compprof.h"
 
 using namespace std;
 
@@ -63,6 +65,8 @@ void afterOpMinimize( FsmAp *fsm, bool lastInSeq )
 {
 	/* Switch on the prefered minimization algorithm. */
 	if ( minimizeOpt == MinimizeEveryOp || ( minimizeOpt == MinimizeMostOps && lastInSeq ) ) {
+		CompileProfMin profMin( fsm );
+
 		/* First clean up the graph. FsmAp operations may leave these
 		 * lying around. There should be no dead end states. The subtract
 		 * intersection operators are the only places where they may be
@@ -82,6 +86,9 @@ void afterOpMinimize( FsmAp *fsm, bool lastInSeq )
 			case MinimizeStable:
 				fsm->minimizeStable();
 				break;
+			case MinimizeHopcroft:
+				fsm->minimizeHopcroft();
+				break;
 		}
 	}
 }
@@ -442,6 +449,7 @@ ParseData::ParseData( const char *fileName, char *sectionName,
 	tokstartExpr(0),
 	tokendExpr(0),
 	dataExpr(0),
+	countersExpr(0),
 	lowerNum(0),
 	upperNum(0),
 	fileName(fileName),
@@ -454,7 +462,11 @@ ParseData::ParseData( const char *fileName, char *sectionName,
 	nextEpsilonResolvedLink(0),
 	nextLongestMatchId(1),
 	lmRequiresErrorState(false),
-	cgd(0)
+	nextCounterId(0),
+	cgd(0),
+	inputHash(CACHE_HASH_INIT),
+	cacheHit(false),
+	phaseTimes(0)
 {
 	/* Initialize the dictionary of graphs. This is our symbol table. The
 	 * initialization needs to be done on construction which happens at the
@@ -469,6 +481,7 @@ ParseData::~ParseData()
 	/* Delete all the nodes in the action list. Will cause all the
 	 * string data that represents the actions to be deallocated. */
 	actionList.empty();
+	delete phaseTimes;
 }
 
 /* Make a name id in the current name instantiation scope if it is not
@@ -899,6 +912,8 @@ bool ParseData::setVariable( char *var, InlineList *inlineList )
 		tokstartExpr = inlineList;
 	else if ( strcmp( var, "te" ) == 0 )
 		tokendExpr = inlineList;
+	else if ( strcmp( var, "counters" ) == 0 )
+		countersExpr = inlineList;
 	else
 		set = false;
 
@@ -979,6 +994,27 @@ Action *ParseData::newAction( const char *name, InlineList *inlineList )
 	return action;
 }
 
+/* Actions of counted repetitions are the counter followed by some text. The
+ * code generator decides how the counter is accessed. The bound, if given, is
+ * appended to the text. */
+Action *ParseData::newCounterAction( const InputLoc &loc, const char *name,
+		int counterId, const char *text, long bound )
+{
+	ostringstream tail;
+	tail << text;
+	if ( bound >= 0 )
+		tail << bound;
+
+	InlineList *inlineList = new InlineList;
+	inlineList->append( new InlineItem( loc, counterId, InlineItem::Counter ) );
+	inlineList->append( new InlineItem( loc, strdup( tail.str().c_str() ),
+			InlineItem::Text ) );
+
+	Action *action = newAction( name, inlineList );
+	action->loc = loc;
+	return action;
+}
+
 void ParseData::initLongestMatchData()
 {
 	if ( lmList.length() > 0 ) {
@@ -1058,13 +1094,36 @@ void ParseData::setLongestMatchData( FsmAp *graph )
 /* Make the graph from a graph dict node. Does minimization and state sorting. */
 FsmAp *ParseData::makeInstance( GraphDictEl *gdNode )
 {
+	CompileProfFrame profFrame( gdNode, "instance", gdNode->loc, gdNode->key );
+
 	/* Build the graph from a walk of the parse tree. */
-	FsmAp *graph = gdNode->value->walk( this );
+	FsmAp *graph;
+	{
+		PhaseTimer phaseTimer( phaseTimes, PhaseWalk );
+		graph = gdNode->value->walk( this );
+	}
+
+	/* Leaving conditions still pending on final states are never tested.
+	 * For the lower bound of a counted repetition that ends the machine
+	 * this means it is not enforced. */
+	ActionSet unchecked;
+	for ( StateSet::Iter state = graph->finStateSet; state.lte(); state++ ) {
+		for ( OutCondSet::Iter cond = (*state)->outCondSet; cond.lte(); cond++ ) {
+			if ( cond->action->isCounterMin && unchecked.insert( cond->action ) ) {
+				warning(cond->action->loc) << "lower bound of counted "
+						"repetition is not checked at the end of " <<
+						gdNode->key << endl;
+			}
+		}
+	}
 
 	/* Resolve any labels that point to multiple states. Any labels that are
 	 * still around are referenced only by gotos and calls and they need to be
 	 * made into deterministic entry points. */
-	graph->deterministicEntry();
+	{
+		PhaseTimer phaseTimer( phaseTimes, PhaseDeterministicEntry );
+		graph->deterministicEntry();
+	}
 
 	/*
 	 * All state construction is now complete.
@@ -1078,8 +1137,10 @@ FsmAp *ParseData::makeInstance( GraphDictEl *gdNode )
 	for ( StateList::Iter state = graph->stateList; state.lte(); state++ )
 		graph->transferErrorActions( state, 0 );
 	
-	if ( ::wantDupsRemoved )
+	if ( ::wantDupsRemoved ) {
+		PhaseTimer phaseTimer( phaseTimes, PhaseRemoveActionDups );
 		removeActionDups( graph );
+	}
 
 	/* Remove unreachable states. There should be no dead end states. The
 	 * subtract and intersection operators are the only places where they may
@@ -1095,6 +1156,14 @@ FsmAp *ParseData::makeInstance( GraphDictEl *gdNode )
 	graph->clearAllPriorities();
 
 	if ( minimizeOpt != MinimizeNone ) {
+		CompileProfMin profMin( graph );
+		PhaseTimer phaseTimer( phaseTimes, PhaseMinimize );
+
+		/* With priorities gone, conditions that lead the same way in either
+		 * sense can be dropped. Doing so first shrinks the minimization. */
+		if ( dropCondsOpt )
+			graph->removeTautologicalConds();
+
 		/* Minimize here even if we minimized at every op. Now that function
 		 * keys have been cleared we may get a more minimal fsm. */
 		switch ( minimizeLevel ) {
@@ -1110,11 +1179,22 @@ FsmAp *ParseData::makeInstance( GraphDictEl *gdNode )
 			case MinimizePartition2:
 				graph->minimizePartition2();
 				break;
+			case MinimizeHopcroft:
+				graph->minimizeHopcroft();
+				break;
 		}
+
+		/* Fusing equivalent states can make more conditions redundant. */
+		if ( dropCondsOpt )
+			graph->removeTautologicalConds();
 	}
 
-	graph->compressTransitions();
+	{
+		PhaseTimer phaseTimer( phaseTimes, PhaseCompressTransitions );
+		graph->compressTransitions();
+	}
 
+	profFrame.result( graph );
 	return graph;
 }
 
@@ -1360,12 +1440,59 @@ void ParseData::makeExports()
 
 }
 
+/* Report a machine that outgrew --max-states or --max-memory, blaming the
+ * operator that was being applied when it did. */
+void ParseData::reportLimitFail( const FsmConstructFail &fail )
+{
+	const InputLoc &loc = fail.opLoc.line > 0 ? fail.opLoc : sectionLoc;
+
+	ostream &out = error(loc);
+	if ( fail.reason == FsmConstructFail::StateLimit )
+		out << "state limit of " << maxStates << " exceeded";
+	else
+		out << "memory limit of " << maxMemory << " bytes exceeded";
+	if ( fail.defName != 0 )
+		out << " while building \"" << fail.defName << "\"";
+	out << endl;
+
+	/* The operation continues the same error. */
+	if ( fail.opName != 0 ) {
+		out << "  during " << fail.opName;
+		if ( fail.rhsStates > 0 ) {
+			out << " of machines with " << fail.lhsStates <<
+					" and " << fail.rhsStates << " states" << endl;
+		}
+		else {
+			out << " of a machine with " << fail.lhsStates <<
+					" states" << endl;
+		}
+	}
+}
+
 /* Construct the machine and catch failures which can occur during
  * construction. */
 void ParseData::prepareMachineGen( GraphDictEl *graphDictEl )
 {
+	/* Whole specifications may come out of the compilation cache. */
+	if ( graphDictEl == 0 && findCachedMachine() )
+		return;
+
+	if ( profileCompile )
+		compileProfile = new CompileProfile;
+
+	if ( phaseTimesOpt && phaseTimes == 0 )
+		phaseTimes = new PhaseTimes;
+
+	/* A machine going into the cache keeps the diagnostics of its
+	 * construction, so a hit can give them again. */
+	ostream *prevDiagStream = diagStream;
+	ostringstream constructDiags;
+	if ( cacheFile.length() > 0 )
+		diagStream = &constructDiags;
+
 	try {
 		/* This machine construction can fail. */
+		PhaseTimer phaseTimer( phaseTimes, PhaseBuild );
 		prepareMachineGenTBWrapped( graphDictEl );
 	}
 	catch ( FsmConstructFail fail ) {
@@ -1380,7 +1507,28 @@ void ParseData::prepareMachineGen( GraphDictEl *graphDictEl )
 						"conditions are embedded" << endl;
 				break;
 			}
+			case FsmConstructFail::StateLimit:
+			case FsmConstructFail::MemoryLimit: {
+				reportLimitFail( fail );
+				break;
+			}
 		}
+
+		/* Graphs built before the failure may still point into the slabs, so
+		 * the pool is not cleared. The error ends the run. */
+	}
+
+	if ( cacheFile.length() > 0 ) {
+		diagStream = prevDiagStream;
+		cacheDiags = constructDiags.str();
+		diagnostics() << cacheDiags;
+	}
+
+	if ( compileProfile != 0 ) {
+		compileProfile->finish();
+		compileProfile->report( diagnostics(), sectionName, sectionLoc );
+		delete compileProfile;
+		compileProfile = 0;
 	}
 }
 
@@ -1434,17 +1582,59 @@ void ParseData::generateReduced( InputData &inputData )
 
 	cgd = makeCodeGen( inputData.inputFileName, sectionName, *inputData.outStream );
 
+	if ( cacheHit ) {
+		if ( loadGenCache( cachedMachine, cgd ) ) {
+			/* Give the warnings of the construction, as a cold build would.
+			 * They wait until the entry has loaded, because a damaged entry is
+			 * rebuilt and the construction gives them again. */
+			diagnostics() << genCacheDiags( cachedMachine );
+
+			if ( printStatistics ) {
+				diagnostics() << "fsm name  : " << sectionName << endl;
+				diagnostics() << "num states: " << cgd->redFsm->stateList.length() << endl;
+				diagnostics() << endl;
+			}
+			return;
+		}
+
+		/* The entry could not be read back. Construct the machine after all. */
+		delete cgd;
+		cgd = 0;
+		cacheHit = false;
+
+		prepareMachineGen( 0 );
+		if ( gblErrorCount > 0 )
+			return;
+
+		cgd = makeCodeGen( inputData.inputFileName, sectionName, *inputData.outStream );
+	}
+
 	/* Make the generator. */
 	BackendGen backendGen( sectionName, this, sectionGraph, cgd );
 
 	/* Write out with it. */
-	backendGen.makeBackend();
+	{
+		PhaseTimer phaseTimer( phaseTimes, PhaseMakeBackend );
+		backendGen.makeBackend();
+	}
 
 	if ( printStatistics ) {
-		cerr << "fsm name  : " << sectionName << endl;
-		cerr << "num states: " << sectionGraph->stateList.length() << endl;
-		cerr << endl;
+		diagnostics() << "fsm name  : " << sectionName << endl;
+		diagnostics() << "num states: " << sectionGraph->stateList.length() << endl;
+		diagnostics() << endl;
 	}
+
+	/* The code generator has its own copy of the machine. The graph goes,
+	 * then the slabs it was drawn from are released in bulk. */
+	delete sectionGraph;
+	sectionGraph = 0;
+	slabPool.clear();
+}
+
+void ParseData::reportPhaseTimes()
+{
+	if ( phaseTimes != 0 )
+		phaseTimes->report( diagnostics(), sectionName, sectionLoc );
 }
 
 void ParseData::generateXML( ostream &out )
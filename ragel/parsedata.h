@@ -34,6 +34,7 @@
 #include "vector.h"
 #include "common.h"
 #include "parsetree.h"
+#include "gencache.h"
 
 /* Forwards. */
 using std::ostream;
@@ -56,6 +57,7 @@ struct ReOrItem;
 struct LongestMatch;
 struct InputData;
 struct CodeGenData;
+struct PhaseTimes;
 typedef DList<LongestMatch> LmList;
 
 
@@ -229,6 +231,8 @@ struct ParseData
 
 	void prepareMachineGen( GraphDictEl *graphDictEl );
 	void prepareMachineGenTBWrapped( GraphDictEl *graphDictEl );
+	void reportLimitFail( const FsmConstructFail &fail );
+	bool findCachedMachine();
 	void generateXML( ostream &out );
 	void generateReduced( InputData &inputData );
 	FsmAp *sectionGraph;
@@ -291,6 +295,7 @@ struct ParseData
 	InlineList *tokstartExpr;
 	InlineList *tokendExpr;
 	InlineList *dataExpr;
+	InlineList *countersExpr;
 
 	/* The alphabet range. */
 	char *lowerNum, *upperNum;
@@ -341,10 +346,15 @@ struct ParseData
 	int nextLongestMatchId;
 	bool lmRequiresErrorState;
 
+	/* Counted repetitions each get an element of the counters array. */
+	int nextCounterId;
+
 	/* List of all longest match parse tree items. */
 	LmList lmList;
 
 	Action *newAction( const char *name, InlineList *inlineList );
+	Action *newCounterAction( const InputLoc &loc, const char *name,
+			int counterId, const char *text, long bound = -1 );
 
 	Action *initTokStart;
 	int initTokStartOrd;
@@ -362,18 +372,37 @@ struct ParseData
 	{
 		::condData = &thisCondData;
 		::keyOps = &thisKeyOps;
+		::fsmSlabPool = &slabPool;
 	}
 
 	CondData thisCondData;
 	KeyOps thisKeyOps;
 
+	/* The states and transitions of all graphs built for this
+	 * specification. */
+	FsmSlabPool slabPool;
+
 	ExportList exportList;
 	LengthDefList lengthDefList;
 
 	CodeGenData *cgd;
+
+	/* Compilation cache. The input hash accumulates over all tokens sent to
+	 * the parser of this specification. */
+	void hashToken( const InputLoc &loc, int tokId, const char *data, int len );
+	CacheHash inputHash;
+	std::string cacheFile;
+	std::string cachedMachine;
+	std::string cacheDiags;
+	bool cacheHit;
+
+	/* Collected when --phase-times is given. */
+	PhaseTimes *phaseTimes;
+	void reportPhaseTimes();
 };
 
 void afterOpMinimize( FsmAp *fsm, bool lastInSeq = true );
+int countTransitions( FsmAp *fsm );
 Key makeFsmKeyHex( char *str, const InputLoc &loc, ParseData *pd );
 Key makeFsmKeyDec( char *str, const InputLoc &loc, ParseData *pd );
 Key makeFsmKeyNum( char *str, const InputLoc &loc, ParseData *pd );
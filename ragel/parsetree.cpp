@@ -29,6 +29,7 @@
 #include "ragel.h"
 #include "rlparse.h"
 #include "parsetree.h"
+#include "compprof.h"
 
 using namespace std;
 ostream &operator<<( ostream &out, const NameRef &nameRef );
@@ -89,6 +90,10 @@ FsmAp *VarDef::walk( ParseData *pd )
 {
 	/* We enter into a new name scope. */
 	NameFrame nameFrame = pd->enterNameScope( true, 1 );
+	FsmOpContext defContext( name );
+	/* Builtin machines have no location and are not worth profiling. */
+	CompileProfFrame profFrame( this, loc.fileName != 0 ?
+			"definition" : 0, loc, name );
 
 	/* Recurse on the expression. */
 	FsmAp *rtnVal = machineDef->walk( pd );
@@ -116,6 +121,7 @@ FsmAp *VarDef::walk( ParseData *pd )
 
 	/* Pop the name scope. */
 	pd->popNameScope( nameFrame );
+	profFrame.result( rtnVal );
 	return rtnVal;
 }
 
@@ -491,6 +497,7 @@ FsmAp *LongestMatch::walk( ParseData *pd )
 {
 	/* The longest match has it's own name scope. */
 	NameFrame nameFrame = pd->enterNameScope( true, 1 );
+	CompileProfFrame profFrame( this, "scanner", loc );
 
 	/* Make each part of the longest match. */
 	FsmAp **parts = new FsmAp*[longestMatchList->length()];
@@ -522,6 +529,7 @@ FsmAp *LongestMatch::walk( ParseData *pd )
 	pd->popNameScope( nameFrame );
 
 	delete[] parts;
+	profFrame.result( rtnVal );
 	return rtnVal;
 }
 
@@ -726,9 +734,22 @@ Expression::~Expression()
 	}
 }
 
+/* Operator names used in compile profiles. */
+static const char *exprProfKind( Expression::Type type )
+{
+	switch ( type ) {
+		case Expression::OrType: return "union";
+		case Expression::IntersectType: return "intersection";
+		case Expression::SubtractType: return "subtraction";
+		case Expression::StrongSubtractType: return "strong subtraction";
+		default: return 0;
+	}
+}
+
 /* Evaluate a single expression node. */
 FsmAp *Expression::walk( ParseData *pd, bool lastInSeq )
 {
+	CompileProfFrame profFrame( this, exprProfKind( type ), loc );
 	FsmAp *rtnVal = 0;
 	switch ( type ) {
 		case OrType: {
@@ -737,6 +758,7 @@ FsmAp *Expression::walk( ParseData *pd, bool lastInSeq )
 			/* Evaluate the term. */
 			FsmAp *rhs = term->walk( pd );
 			/* Perform union. */
+			FsmOpContext opContext( loc, "union", rtnVal, rhs );
 			rtnVal->unionOp( rhs );
 			afterOpMinimize( rtnVal, lastInSeq );
 			break;
@@ -747,6 +769,7 @@ FsmAp *Expression::walk( ParseData *pd, bool lastInSeq )
 			/* Evaluate the term. */
 			FsmAp *rhs = term->walk( pd );
 			/* Perform intersection. */
+			FsmOpContext opContext( loc, "intersection", rtnVal, rhs );
 			rtnVal->intersectOp( rhs );
 			afterOpMinimize( rtnVal, lastInSeq );
 			break;
@@ -757,6 +780,7 @@ FsmAp *Expression::walk( ParseData *pd, bool lastInSeq )
 			/* Evaluate the term. */
 			FsmAp *rhs = term->walk( pd );
 			/* Perform subtraction. */
+			FsmOpContext opContext( loc, "subtraction", rtnVal, rhs );
 			rtnVal->subtractOp( rhs );
 			afterOpMinimize( rtnVal, lastInSeq );
 			break;
@@ -773,6 +797,7 @@ FsmAp *Expression::walk( ParseData *pd, bool lastInSeq )
 			rhs->concatOp( trailAnyStar );
 
 			/* Perform subtraction. */
+			FsmOpContext opContext( loc, "strong subtraction", rtnVal, rhs );
 			rtnVal->subtractOp( rhs );
 			afterOpMinimize( rtnVal, lastInSeq );
 			break;
@@ -789,6 +814,7 @@ FsmAp *Expression::walk( ParseData *pd, bool lastInSeq )
 		}
 	}
 
+	profFrame.result( rtnVal );
 	return rtnVal;
 }
 
@@ -845,9 +871,21 @@ Term::~Term()
 	}
 }
 
+static const char *termProfKind( Term::Type type )
+{
+	switch ( type ) {
+		case Term::ConcatType: return "concatenation";
+		case Term::RightStartType: return "entry-guarded concatenation";
+		case Term::RightFinishType: return "finish-guarded concatenation";
+		case Term::LeftType: return "left-guarded concatenation";
+		default: return 0;
+	}
+}
+
 /* Evaluate a term node. */
 FsmAp *Term::walk( ParseData *pd, bool lastInSeq )
 {
+	CompileProfFrame profFrame( this, termProfKind( type ), loc );
 	FsmAp *rtnVal = 0;
 	switch ( type ) {
 		case ConcatType: {
@@ -856,6 +894,7 @@ FsmAp *Term::walk( ParseData *pd, bool lastInSeq )
 			/* Evaluate the FactorWithRep. */
 			FsmAp *rhs = factorWithAug->walk( pd );
 			/* Perform concatenation. */
+			FsmOpContext opContext( loc, "concatenation", rtnVal, rhs );
 			rtnVal->concatOp( rhs );
 			afterOpMinimize( rtnVal, lastInSeq );
 			break;
@@ -880,6 +919,7 @@ FsmAp *Term::walk( ParseData *pd, bool lastInSeq )
 			rhs->startFsmPrior( pd->curPriorOrd++, &priorDescs[1] );
 
 			/* Perform concatenation. */
+			FsmOpContext opContext( loc, "entry-guarded concatenation", rtnVal, rhs );
 			rtnVal->concatOp( rhs );
 			afterOpMinimize( rtnVal, lastInSeq );
 			break;
@@ -913,6 +953,7 @@ FsmAp *Term::walk( ParseData *pd, bool lastInSeq )
 			}
 
 			/* Perform concatenation. */
+			FsmOpContext opContext( loc, "finish-guarded concatenation", rtnVal, rhs );
 			rtnVal->concatOp( rhs );
 			afterOpMinimize( rtnVal, lastInSeq );
 			break;
@@ -940,6 +981,7 @@ FsmAp *Term::walk( ParseData *pd, bool lastInSeq )
 			rhs->startFsmPrior( pd->curPriorOrd++, &priorDescs[1] );
 
 			/* Perform concatenation. */
+			FsmOpContext opContext( loc, "left-guarded concatenation", rtnVal, rhs );
 			rtnVal->concatOp( rhs );
 			afterOpMinimize( rtnVal, lastInSeq );
 			break;
@@ -949,6 +991,7 @@ FsmAp *Term::walk( ParseData *pd, bool lastInSeq )
 			break;
 		}
 	}
+	profFrame.result( rtnVal );
 	return rtnVal;
 }
 
@@ -1185,9 +1228,33 @@ void FactorWithAug::assignConditions( FsmAp *graph )
 }
 
 
+/* Location of the first embedding in a factor with augmentation, for compile
+ * profiles. Priorities carry no location. */
+static InputLoc augProfLoc( FactorWithAug *fwa )
+{
+	if ( fwa->labels.length() > 0 )
+		return fwa->labels[0].loc;
+	if ( fwa->actions.length() > 0 )
+		return fwa->actions[0].loc;
+	if ( fwa->conditions.length() > 0 )
+		return fwa->conditions[0].loc;
+	if ( fwa->epsilonLinks.length() > 0 )
+		return fwa->epsilonLinks[0].loc;
+
+	InputLoc loc = { 0, 0, 0 };
+	return loc;
+}
+
 /* Evaluate a factor with augmentation node. */
 FsmAp *FactorWithAug::walk( ParseData *pd )
 {
+	/* Only factors with something embedded in them are profiled. */
+	bool augmented = labels.length() > 0 || actions.length() > 0 ||
+			conditions.length() > 0 || epsilonLinks.length() > 0 ||
+			priorityAugs.length() > 0;
+	CompileProfFrame profFrame( this, augmented ? "embedding" : 0,
+			augProfLoc( this ) );
+
 	/* Enter into the scopes created for the labels. */
 	NameFrame nameFrame = pd->enterNameScope( false, labels.length() );
 
@@ -1291,6 +1358,7 @@ FsmAp *FactorWithAug::walk( ParseData *pd )
 		delete[] priorOrd;
 	if ( actionOrd != 0 )
 		delete[] actionOrd;	
+	profFrame.result( rtnVal );
 	return rtnVal;
 }
 
@@ -1384,11 +1452,120 @@ FactorWithRep::~FactorWithRep()
 	}
 }
 
+static const char *repProfKind( FactorWithRep::Type type )
+{
+	switch ( type ) {
+		case FactorWithRep::StarType: return "kleene star";
+		case FactorWithRep::StarStarType: return "kleene star";
+		case FactorWithRep::OptionalType: return "optional";
+		case FactorWithRep::PlusType: return "plus";
+		case FactorWithRep::ExactType: return "repetition";
+		case FactorWithRep::MaxType: return "max repetition";
+		case FactorWithRep::MinType: return "min repetition";
+		case FactorWithRep::RangeType: return "range repetition";
+		default: return 0;
+	}
+}
+
+/* Bounds of a counted repetition, with an upper bound of zero meaning there is
+ * none. Fails if the usual construction would not copy the machine or if the
+ * bounds are bad, leaving these to the usual construction. */
+bool FactorWithRep::countedBounds( int &lower, int &upper )
+{
+	switch ( type ) {
+		case ExactType:
+			lower = upper = lowerRep;
+			break;
+		case MaxType:
+			lower = 0;
+			upper = upperRep;
+			break;
+		case MinType:
+			lower = lowerRep;
+			upper = 0;
+			break;
+		case RangeType:
+			lower = lowerRep;
+			upper = upperRep;
+			break;
+		default:
+			return false;
+	}
+
+	if ( upper > 0 && upper < lower )
+		return false;
+	return upper > 1 || ( upper == 0 && lower > 1 );
+}
+
+/* A counted repetition is one copy of the machine, which sets the counter to
+ * one, followed by a loop over a second copy, which increments it. Going
+ * around the loop is guarded by the upper bound and leaving the repetition by
+ * the lower bound. */
+FsmAp *FactorWithRep::walkCounted( ParseData *pd, int lower, int upper )
+{
+	/* Evaluate the repeated machine. */
+	FsmAp *retFsm = factorWithRep->walk( pd );
+	if ( retFsm->startState->isFinState() ) {
+		warning(loc) << "applying counted repetition to a machine that "
+				"accepts zero length word" << endl;
+	}
+
+	int counterId = pd->nextCounterId++;
+	Action *initCount = pd->newCounterAction( loc, "count_init", counterId, " = 1;" );
+	Action *incCount = pd->newCounterAction( loc, "count_inc", counterId, " += 1;" );
+
+	FsmOpContext opContext( loc, "counted repetition", retFsm );
+	FsmAp *loop = new FsmAp( *retFsm );
+
+	/* The first iteration sets the counter before its own start actions. */
+	int initOrd = pd->curActionOrd++;
+	pd->curActionOrd += retFsm->shiftStartActionOrder( pd->curActionOrd );
+	retFsm->startFsmAction( initOrd, initCount );
+
+	/* The following iterations. */
+	int incOrd = pd->curActionOrd++;
+	pd->curActionOrd += loop->shiftStartActionOrder( pd->curActionOrd );
+	loop->startFsmAction( incOrd, incCount );
+	if ( upper > 0 ) {
+		Action *belowMax = pd->newCounterAction( loc, "count_max",
+				counterId, " < ", upper );
+		loop->startFsmCondition( belowMax, true );
+	}
+	loop->starOp( );
+	afterOpMinimize( loop );
+
+	retFsm->concatOp( loop );
+	afterOpMinimize( retFsm );
+
+	if ( lower > 1 ) {
+		Action *atMin = pd->newCounterAction( loc, "count_min",
+				counterId, " >= ", lower );
+		atMin->isCounterMin = true;
+		retFsm->leaveFsmCondition( atMin, true );
+	}
+	else if ( lower == 0 ) {
+		FsmAp *nu = new FsmAp();
+		nu->lambdaFsm( );
+		retFsm->unionOp( nu );
+		afterOpMinimize( retFsm );
+	}
+
+	return retFsm;
+}
+
 /* Evaluate a factor with repetition node. */
 FsmAp *FactorWithRep::walk( ParseData *pd )
 {
+	CompileProfFrame profFrame( this, repProfKind( type ), loc );
 	FsmAp *retFsm = 0;
 
+	int lower, upper;
+	if ( counted && countedBounds( lower, upper ) ) {
+		retFsm = walkCounted( pd, lower, upper );
+		profFrame.result( retFsm );
+		return retFsm;
+	}
+
 	switch ( type ) {
 	case StarType: {
 		/* Evaluate the FactorWithRep. */
@@ -1401,6 +1578,7 @@ FsmAp *FactorWithRep::walk( ParseData *pd )
 
 		/* Shift over the start action orders then do the kleene star. */
 		pd->curActionOrd += retFsm->shiftStartActionOrder( pd->curActionOrd );
+		FsmOpContext opContext( loc, "kleene star", retFsm );
 		retFsm->starOp( );
 		afterOpMinimize( retFsm );
 		break;
@@ -1427,6 +1605,7 @@ FsmAp *FactorWithRep::walk( ParseData *pd )
 
 		/* Shift over the start action orders then do the kleene star. */
 		pd->curActionOrd += retFsm->shiftStartActionOrder( pd->curActionOrd );
+		FsmOpContext opContext( loc, "kleene star", retFsm );
 		retFsm->starOp( );
 		afterOpMinimize( retFsm );
 		break;
@@ -1440,6 +1619,7 @@ FsmAp *FactorWithRep::walk( ParseData *pd )
 		retFsm = factorWithRep->walk( pd );
 
 		/* Perform the question operator. */
+		FsmOpContext opContext( loc, "optional", retFsm );
 		retFsm->unionOp( nu );
 		afterOpMinimize( retFsm );
 		break;
@@ -1453,6 +1633,7 @@ FsmAp *FactorWithRep::walk( ParseData *pd )
 		}
 
 		/* Need a duplicated for the star end. */
+		FsmOpContext opContext( loc, "plus", retFsm );
 		FsmAp *dup = new FsmAp( *retFsm );
 
 		/* The start func orders need to be shifted before doing the star. */
@@ -1490,6 +1671,7 @@ FsmAp *FactorWithRep::walk( ParseData *pd )
 			pd->curActionOrd += retFsm->shiftStartActionOrder( pd->curActionOrd );
 
 			/* Do the repetition on the machine. Already guarded against n == 0 */
+			FsmOpContext opContext( loc, "repetition", retFsm );
 			retFsm->repeatOp( lowerRep );
 			afterOpMinimize( retFsm );
 		}
@@ -1519,6 +1701,7 @@ FsmAp *FactorWithRep::walk( ParseData *pd )
 			pd->curActionOrd += retFsm->shiftStartActionOrder( pd->curActionOrd );
 
 			/* Do the repetition on the machine. Already guarded against n == 0 */
+			FsmOpContext opContext( loc, "max repetition", retFsm );
 			retFsm->optionalRepeatOp( upperRep );
 			afterOpMinimize( retFsm );
 		}
@@ -1535,6 +1718,7 @@ FsmAp *FactorWithRep::walk( ParseData *pd )
 		/* The start func orders need to be shifted before doing the repetition
 		 * and the kleene star. */
 		pd->curActionOrd += retFsm->shiftStartActionOrder( pd->curActionOrd );
+		FsmOpContext opContext( loc, "min repetition", retFsm );
 	
 		if ( lowerRep == 0 ) {
 			/* Acts just like a star op on the machine to return. */
@@ -1588,6 +1772,7 @@ FsmAp *FactorWithRep::walk( ParseData *pd )
 			/* The start func orders need to be shifted before doing both kinds
 			 * of repetition. */
 			pd->curActionOrd += retFsm->shiftStartActionOrder( pd->curActionOrd );
+			FsmOpContext opContext( loc, "range repetition", retFsm );
 
 			if ( lowerRep == 0 ) {
 				/* Just doing max repetition. Already guarded against n == 0. */
@@ -1624,6 +1809,7 @@ FsmAp *FactorWithRep::walk( ParseData *pd )
 		retFsm = factorWithNeg->walk( pd );
 		break;
 	}}
+	profFrame.result( retFsm );
 	return retFsm;
 }
 
@@ -223,13 +223,16 @@ struct PriorityAug
 struct VarDef
 {
 	VarDef( const char *name, MachineDef *machineDef )
-		: name(name), machineDef(machineDef), isExport(false) { }
+		: name(name), machineDef(machineDef), isExport(false)
+		{ loc.fileName = 0; loc.line = 0; loc.col = 0; }
 	
 	/* Parse tree traversal. */
 	FsmAp *walk( ParseData *pd );
 	void makeNameTree( const InputLoc &loc, ParseData *pd );
 	void resolveNameRefs( ParseData *pd );
 
+	/* Location of the definition, unset for builtin machines. */
+	InputLoc loc;
 	const char *name;
 	MachineDef *machineDef;
 	bool isExport;
@@ -383,8 +386,8 @@ struct Expression
 	};
 
 	/* Construct with an expression on the left and a term on the right. */
-	Expression( Expression *expression, Term *term, Type type ) : 
-		expression(expression), term(term), 
+	Expression( const InputLoc &loc, Expression *expression, Term *term, Type type ) : 
+		loc(loc), expression(expression), term(term), 
 		builtin(builtin), type(type), prev(this), next(this) { }
 
 	/* Construct with only a term. */
@@ -405,6 +408,7 @@ struct Expression
 	void resolveNameRefs( ParseData *pd );
 
 	/* Node data. */
+	InputLoc loc;
 	Expression *expression;
 	Term *term;
 	BuiltinMachine builtin;
@@ -427,10 +431,11 @@ struct Term
 	};
 
 	Term( Term *term, FactorWithAug *factorWithAug ) :
-		term(term), factorWithAug(factorWithAug), type(ConcatType) { }
+		term(term), factorWithAug(factorWithAug), type(ConcatType)
+		{ loc.fileName = 0; loc.line = 0; loc.col = 0; }
 
-	Term( Term *term, FactorWithAug *factorWithAug, Type type ) :
-		term(term), factorWithAug(factorWithAug), type(type) { }
+	Term( const InputLoc &loc, Term *term, FactorWithAug *factorWithAug, Type type ) :
+		loc(loc), term(term), factorWithAug(factorWithAug), type(type) { }
 
 	Term( FactorWithAug *factorWithAug ) :
 		term(0), factorWithAug(factorWithAug), type(FactorWithAugType) { }
@@ -441,6 +446,8 @@ struct Term
 	void makeNameTree( ParseData *pd );
 	void resolveNameRefs( ParseData *pd );
 
+	/* Location of the operator, unset for plain concatenation. */
+	InputLoc loc;
 	Term *term;
 	FactorWithAug *factorWithAug;
 	Type type;
@@ -498,10 +505,10 @@ struct FactorWithRep
 			int lowerRep, int upperRep, Type type ) :
 		loc(loc), factorWithRep(factorWithRep), 
 		factorWithNeg(0), lowerRep(lowerRep), 
-		upperRep(upperRep), type(type) { }
+		upperRep(upperRep), type(type), counted(false) { }
 	
 	FactorWithRep( FactorWithNeg *factorWithNeg )
-		: factorWithNeg(factorWithNeg), type(FactorWithNegType) { }
+		: factorWithNeg(factorWithNeg), type(FactorWithNegType), counted(false) { }
 
 	~FactorWithRep();
 
@@ -510,12 +517,19 @@ struct FactorWithRep
 	void makeNameTree( ParseData *pd );
 	void resolveNameRefs( ParseData *pd );
 
+	bool countedBounds( int &lower, int &upper );
+	FsmAp *walkCounted( ParseData *pd, int lower, int upper );
+
 	InputLoc loc;
 	FactorWithRep *factorWithRep;
 	FactorWithNeg *factorWithNeg;
 	int lowerRep, upperRep;
 	Type type;
 
+	/* Repetitions written with {count ...} loop over a single copy of the
+	 * machine, keeping the number of iterations in a counter. */
+	bool counted;
+
 	/* Priority descriptor for StarStar type. */
 	PriorDesc priorDescs[2];
 };
@@ -732,7 +746,7 @@ struct InlineItem
 		Text, Goto, Call, Next, GotoExpr, CallExpr, NextExpr, Ret, PChar,
 		Char, Hold, Curs, Targs, Entry, Exec, LmSwitch, LmSetActId,
 		LmSetTokEnd, LmOnLast, LmOnNext, LmOnLagBehind, LmInitAct,
-		LmInitTokStart, LmSetTokStart, Break
+		LmInitTokStart, LmSetTokStart, Break, Counter
 	};
 
 	InlineItem( const InputLoc &loc, char *data, Type type ) : 
@@ -752,6 +766,10 @@ struct InlineItem
 
 	InlineItem( const InputLoc &loc, Type type ) : 
 		loc(loc), data(0), nameRef(0), children(0), type(type) { }
+
+	InlineItem( const InputLoc &loc, int counterId, Type type ) : 
+		loc(loc), data(0), nameRef(0), children(0), counterId(counterId),
+		type(type) { }
 	
 	InputLoc loc;
 	char *data;
@@ -760,6 +778,7 @@ struct InlineItem
 	InlineList *children;
 	LongestMatch *longestMatch;
 	LongestMatchPart *longestMatchPart;
+	int counterId;
 	Type type;
 
 	InlineItem *prev, *next;
@@ -37,6 +37,7 @@ enum CodeStyle
 {
 	GenTables,
 	GenFTables,
+	GenCombTables,
 	GenFlat,
 	GenFFlat,
 	GenGoto,
@@ -50,7 +51,8 @@ enum MinimizeLevel {
 	MinimizeApprox,
 	MinimizeStable,
 	MinimizePartition1,
-	MinimizePartition2
+	MinimizePartition2,
+	MinimizeHopcroft
 };
 
 enum MinimizeOpt {
@@ -84,7 +86,7 @@ enum ErrorFormat {
 };
 
 extern ErrorFormat errorFormat;
-extern int gblErrorCount;
+extern THREAD_LOCAL int gblErrorCount;
 extern char mainMachine[];
 
 InputLoc makeInputLoc( const char *fileName, int line = 0, int col = 0 );
@@ -95,6 +97,11 @@ std::ostream &error();
 std::ostream &error( const InputLoc &loc ); 
 std::ostream &warning( const InputLoc &loc ); 
 
+/* Stream for errors and statistics. Threads compiling machines in parallel
+ * point diagStream at a private buffer. */
+extern THREAD_LOCAL std::ostream *diagStream;
+std::ostream &diagnostics();
+
 struct XmlParser;
 
 void xmlEscapeHost( std::ostream &out, char *data, long len );
@@ -103,16 +110,29 @@ extern CodeStyle codeStyle;
 
 /* IO filenames and stream. */
 extern bool displayPrintables;
-extern int gblErrorCount;
 
 /* Options. */
 extern int numSplitPartitions;
 extern bool noLineDirectives;
+extern int numJobs;
+extern const char *cacheDir;
+extern long maxStates;
+extern long maxMemory;
+extern bool profileCompile;
+extern bool phaseTimesOpt;
+extern bool dropCondsOpt;
+extern bool flatPagesOpt;
+extern const char *profileUseFile;
+extern bool instrumentOpt;
+extern bool packedTablesOpt;
+extern bool spanTablesOpt;
+extern bool fixedDataOpt;
 
 std::ostream &error();
 
 /* Target language and output style. */
 extern CodeStyle codeStyle;
+void checkCodeStyle();
 
 extern int numSplitPartitions;
 extern bool noLineDirectives;
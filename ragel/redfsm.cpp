@@ -48,6 +48,7 @@ RedFsmAp::RedFsmAp()
 	errTrans(0),
 	firstFinState(0),
 	numFinStates(0),
+	profiled(false),
 	bAnyToStateActions(false),
 	bAnyFromStateActions(false),
 	bAnyRegActions(false),
@@ -61,16 +62,60 @@ RedFsmAp::RedFsmAp()
 	bAnyRegNextStmt(false),
 	bAnyRegCurStateRef(false),
 	bAnyRegBreak(false),
-	bAnyConditions(false)
+	bAnyConditions(false),
+	charClass(0),
+	numClasses(0),
+	classIntKeys(0),
+	classIntClasses(0),
+	numClassInts(0),
+	flatPaged(false),
+	pageBits(0),
+	numPageRefs(0),
+	combNext(0),
+	combCheck(0),
+	combSize(0),
+	numCombCols(0),
+	maxCombBase(0)
 {
 }
 
+RedFsmAp::~RedFsmAp()
+{
+	delete[] charClass;
+	delete[] classIntKeys;
+	delete[] classIntClasses;
+
+	/* The states and action tables are elements of arrays that belong to the
+	 * code generator. */
+	stateList.abandon();
+	actionMap.abandon();
+}
+
 /* Does the machine have any actions. */
 bool RedFsmAp::anyActions()
 {
 	return actionMap.length() > 0;
 }
 
+/* A successor of a state and how often it is reached from there. */
+struct ProfSucc
+{
+	long long count;
+	RedStateAp *targ;
+};
+
+struct CmpProfSucc
+{
+	static int compare( const ProfSucc &s1, const ProfSucc &s2 )
+	{
+		if ( s1.count > s2.count )
+			return -1;
+		else if ( s1.count < s2.count )
+			return 1;
+		return 0;
+	}
+};
+
 void RedFsmAp::depthFirstOrdering( RedStateAp *state )
 {
 	/* Nothing to do if the state is already on the list. */
@@ -85,6 +130,28 @@ void RedFsmAp::depthFirstOrdering( RedStateAp *state )
 	assert( state->outSingle.length() == 0 );
 	assert( state->defTrans == 0 );
 
+	if ( profiled ) {
+		/* With a profile, recurse on the most taken transitions first so
+		 * that hot paths are laid out together. The sort is stable, leaving
+		 * states of equal count in key order. */
+		Vector<ProfSucc> succs;
+		for ( RedTransList::Iter rtel = state->outRange; rtel.lte(); rtel++ ) {
+			if ( rtel->value->targ != 0 ) {
+				ProfSucc succ;
+				succ.count = profEstimate( state, rtel->value );
+				succ.targ = rtel->value->targ;
+				succs.append( succ );
+			}
+		}
+
+		MergeSort<ProfSucc, CmpProfSucc> mergeSort;
+		mergeSort.sort( succs.data, succs.length() );
+
+		for ( Vector<ProfSucc>::Iter succ = succs; succ.lte(); succ++ )
+			depthFirstOrdering( succ->targ );
+		return;
+	}
+
 	/* Recurse on everything ranges. */
 	for ( RedTransList::Iter rtel = state->outRange; rtel.lte(); rtel++ ) {
 		if ( rtel->value->targ != 0 )
@@ -284,8 +351,165 @@ void RedFsmAp::chooseSingle()
 	}
 }
 
-void RedFsmAp::makeFlat()
+int CmpRedFlatPage::compare( RedFlatPage *const &page1, RedFlatPage *const &page2 )
+{
+	for ( int pos = 0; pos < page1->size; pos++ ) {
+		if ( page1->transList[pos]->id < page2->transList[pos]->id )
+			return -1;
+		else if ( page1->transList[pos]->id > page2->transList[pos]->id )
+			return 1;
+	}
+	return 0;
+}
+
+/* The number of keys from low to high. The whole of a 64 bit alphabet does
+ * not fit and is given as the largest span. */
+static unsigned long long keySpan( Key low, Key high )
+{
+	unsigned long long span = keyOps->span( low, high );
+	return span == 0 ? ~0ULL : span;
+}
+
+/* Cut the span of a state into pages, sharing pages that are already made.
+ * Pages that are covered by a single range or gap are found without filling
+ * them in, so the time taken is not proportional to the span. */
+void RedFsmAp::makeFlatPages( RedStateAp *state, RedFlatPageSet &pageSet, long *uniformPage )
+{
+	unsigned long long span = keyOps->span( state->lowKey, state->highKey );
+	unsigned long long pageSize = 1ULL << pageBits;
+	unsigned long long numPages = ( span + pageSize - 1 ) >> pageBits;
+	state->pageList = new long[numPages];
+
+	RedTransList::Iter rtel = state->outRange;
+	for ( unsigned long long page = 0; page < numPages; page++ ) {
+		unsigned long long first = page << pageBits;
+		unsigned long long last = first + pageSize - 1;
+		if ( last > span - 1 )
+			last = span - 1;
+
+		/* Skip ranges that end before the page. */
+		while ( rtel.lte() && keyOps->span( state->lowKey, rtel->highKey ) - 1 < first )
+			rtel++;
+
+		/* The part of the last page that is past the span is never read, it
+		 * takes whatever the rest of the page does. */
+		RedTransAp *uniform = 0;
+		if ( !rtel.lte() || keyOps->span( state->lowKey, rtel->lowKey ) - 1 > last )
+			uniform = state->defTrans;
+		else if ( keyOps->span( state->lowKey, rtel->lowKey ) - 1 <= first &&
+				keyOps->span( state->lowKey, rtel->highKey ) - 1 >= last )
+			uniform = rtel->value;
+
+		if ( uniform != 0 && uniformPage[uniform->id] >= 0 ) {
+			state->pageList[page] = uniformPage[uniform->id];
+			continue;
+		}
+
+		RedFlatPage *flatPage = new RedFlatPage;
+		flatPage->transList = new RedTransAp*[pageSize];
+		flatPage->size = pageSize;
+		if ( uniform != 0 ) {
+			for ( unsigned long long pos = 0; pos < pageSize; pos++ )
+				flatPage->transList[pos] = uniform;
+		}
+		else {
+			for ( unsigned long long pos = 0; pos < pageSize; pos++ )
+				flatPage->transList[pos] = state->defTrans;
+			for ( RedTransList::Iter tr = rtel; tr.lte(); tr++ ) {
+				unsigned long long low = keyOps->span( state->lowKey, tr->lowKey ) - 1;
+				unsigned long long high = keyOps->span( state->lowKey, tr->highKey ) - 1;
+				if ( low > last )
+					break;
+				if ( low < first )
+					low = first;
+				if ( high > last )
+					high = last;
+				for ( unsigned long long pos = low; pos <= high; pos++ )
+					flatPage->transList[pos - first] = tr->value;
+			}
+		}
+
+		AvlSetEl<RedFlatPage*> *existing = pageSet.find( flatPage );
+		if ( existing != 0 ) {
+			delete[] flatPage->transList;
+			delete flatPage;
+			flatPage = existing->key;
+		}
+		else {
+			flatPage->id = flatPages.length();
+			flatPages.append( flatPage );
+			pageSet.insert( flatPage );
+		}
+
+		if ( uniform != 0 )
+			uniformPage[uniform->id] = flatPage->id;
+		state->pageList[page] = flatPage->id;
+	}
+
+	numPageRefs += numPages;
+}
+
+/* Put the states of a machine too wide for flat tables in terms of classes,
+ * working from the ranges. Returns false if it has conditions, which keep the
+ * machine from being put in classes. */
+bool RedFsmAp::makeWideClasses()
+{
+	for ( RedStateList::Iter st = stateList; st.lte(); st++ ) {
+		st->transList = 0;
+		if ( st->outRange.length() == 0 )
+			st->lowKey = st->highKey = 0;
+		else {
+			st->lowKey = st->outRange[0].lowKey;
+			st->highKey = st->outRange[st->outRange.length()-1].highKey;
+		}
+	}
+
+	makeCharClasses( true );
+	return anyCharClasses();
+}
+
+/* Make the flat tables. Returns false if the machine is too wide to be laid
+ * out. */
+bool RedFsmAp::makeFlat( bool canPage, bool forcePages )
 {
+	/* Machines with a wide span are cut into pages if the code generator can
+	 * handle them. Past the widest span that pages are made for, the states
+	 * are put in terms of classes that are found by a search. */
+	if ( canPage ) {
+		unsigned long long maxStateSpan = 0;
+		for ( RedStateList::Iter st = stateList; st.lte(); st++ ) {
+			if ( st->outRange.length() > 0 ) {
+				unsigned long long span = keySpan( st->outRange[0].lowKey,
+						st->outRange[st->outRange.length()-1].highKey );
+				if ( span > maxStateSpan )
+					maxStateSpan = span;
+			}
+		}
+
+		if ( forcePages || maxStateSpan > FLAT_PAGE_SPAN ) {
+			/* Pages are about the square root of the widest span, but no
+			 * smaller than 256 keys. */
+			int spanBits = 0;
+			while ( spanBits < 64 && ( 1ULL << spanBits ) < maxStateSpan )
+				spanBits += 1;
+			if ( spanBits > FLAT_PAGE_MAX_BITS )
+				return makeWideClasses();
+
+			flatPaged = true;
+			pageBits = ( spanBits + 1 ) / 2;
+			if ( pageBits < 8 )
+				pageBits = 8;
+		}
+	}
+
+	RedFlatPageSet pageSet;
+	long *uniformPage = 0;
+	if ( flatPaged ) {
+		uniformPage = new long[nextTransId];
+		for ( int t = 0; t < nextTransId; t++ )
+			uniformPage[t] = -1;
+	}
+
 	for ( RedStateList::Iter st = stateList; st.lte(); st++ ) {
 		if ( st->stateCondList.length() == 0 ) {
 			st->condLowKey = 0;
@@ -312,6 +536,11 @@ void RedFsmAp::makeFlat()
 			st->lowKey = st->highKey = 0;
 			st->transList = 0;
 		}
+		else if ( flatPaged ) {
+			st->lowKey = st->outRange[0].lowKey;
+			st->highKey = st->outRange[st->outRange.length()-1].highKey;
+			makeFlatPages( st, pageSet, uniformPage );
+		}
 		else {
 			st->lowKey = st->outRange[0].lowKey;
 			st->highKey = st->outRange[st->outRange.length()-1].highKey;
@@ -334,6 +563,488 @@ void RedFsmAp::makeFlat()
 			}
 		}
 	}
+
+	delete[] uniformPage;
+	if ( !flatPaged )
+		makeCharClasses();
+	return true;
+}
+
+/* An interval of the key space and the transition a state takes on it. */
+struct ClassTrans
+{
+	long cls;
+	long transId;
+	int interval;
+};
+
+struct CmpClassTrans
+{
+	static int compare( const ClassTrans &ct1, const ClassTrans &ct2 )
+	{
+		if ( ct1.cls < ct2.cls )
+			return -1;
+		else if ( ct1.cls > ct2.cls )
+			return 1;
+		else if ( ct1.transId < ct2.transId )
+			return -1;
+		else if ( ct1.transId > ct2.transId )
+			return 1;
+		return 0;
+	}
+};
+
+/* Renumber classes in order of first appearance. */
+static long compactClasses( long *classOf, int numIntervals, long numIds )
+{
+	long *remap = new long[numIds];
+	for ( long c = 0; c < numIds; c++ )
+		remap[c] = -1;
+
+	long next = 0;
+	for ( int i = 0; i < numIntervals; i++ ) {
+		if ( remap[classOf[i]] < 0 )
+			remap[classOf[i]] = next++;
+		classOf[i] = remap[classOf[i]];
+	}
+
+	delete[] remap;
+	return next;
+}
+
+/* The transition a state takes on a key, found in its ranges. */
+static RedTransAp *transOfKey( RedStateAp *state, Key key )
+{
+	int low = 0, high = state->outRange.length();
+	while ( low < high ) {
+		int mid = (low + high) / 2;
+		if ( state->outRange[mid].highKey < key )
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	if ( low < state->outRange.length() && state->outRange[low].lowKey <= key )
+		return state->outRange[low].value;
+	return state->defTrans;
+}
+
+/* Group keys that take the same transition in every state into classes and
+ * rewrite the flat tables to be indexed by class. Unless always is given, only
+ * done when the class map and the class indexed tables together are smaller
+ * than the key indexed tables. With always, a class map wider than a flat
+ * page is kept as intervals. The wide keys of conditions are not mapped. Only
+ * the ranges and the key bounds of the states are needed, the key indexed
+ * tables need not have been filled in. */
+void RedFsmAp::makeCharClasses( bool always )
+{
+	unsigned long long keyEntries = 0;
+	for ( RedStateList::Iter st = stateList; st.lte(); st++ ) {
+		if ( st->stateCondList.length() > 0 )
+			return;
+		if ( st->outRange.length() > 0 )
+			keyEntries += keySpan( st->lowKey, st->highKey );
+	}
+
+	/* Break the key space up wherever a range of any state begins or ends. */
+	Vector<Key> keys;
+	for ( RedStateList::Iter st = stateList; st.lte(); st++ ) {
+		for ( RedTransList::Iter rtel = st->outRange; rtel.lte(); rtel++ ) {
+			keys.append( rtel->lowKey );
+			if ( rtel->highKey < keyOps->maxKey ) {
+				Key next = rtel->highKey;
+				next.increment();
+				keys.append( next );
+			}
+		}
+	}
+
+	if ( keys.length() == 0 )
+		return;
+
+	MergeSort<Key, CmpKey> keySort;
+	keySort.sort( keys.data, keys.length() );
+	int numIntervals = 0;
+	for ( int k = 0; k < keys.length(); k++ ) {
+		if ( numIntervals == 0 || keys[numIntervals-1] < keys[k] )
+			keys[numIntervals++] = keys[k];
+	}
+
+	/* Refine the partition of the intervals by the transitions of each state
+	 * in turn. Intervals no state has a range on stay in class zero. */
+	long *classOf = new long[numIntervals];
+	bool *covered = new bool[numIntervals];
+	for ( int i = 0; i < numIntervals; i++ ) {
+		classOf[i] = 0;
+		covered[i] = false;
+	}
+
+	long numIds = 1;
+	MergeSort<ClassTrans, CmpClassTrans> ctSort;
+	Vector<ClassTrans> classTrans;
+	for ( RedStateList::Iter st = stateList; st.lte(); st++ ) {
+		if ( st->outRange.length() == 0 )
+			continue;
+
+		classTrans.empty();
+		for ( RedTransList::Iter rtel = st->outRange; rtel.lte(); rtel++ ) {
+			int low = 0, high = numIntervals;
+			while ( low < high ) {
+				int mid = (low + high) / 2;
+				if ( keys[mid] < rtel->lowKey )
+					low = mid + 1;
+				else
+					high = mid;
+			}
+
+			for ( int i = low; i < numIntervals && keys[i] <= rtel->highKey; i++ ) {
+				ClassTrans ct;
+				ct.cls = classOf[i];
+				ct.transId = rtel->value->id;
+				ct.interval = i;
+				classTrans.append( ct );
+				covered[i] = true;
+			}
+		}
+
+		ctSort.sort( classTrans.data, classTrans.length() );
+		for ( int ct = 0; ct < classTrans.length(); ct++ ) {
+			if ( ct == 0 || CmpClassTrans::compare( classTrans[ct-1], classTrans[ct] ) != 0 )
+				numIds += 1;
+			classOf[classTrans[ct].interval] = numIds - 1;
+		}
+
+		numIds = compactClasses( classOf, numIntervals, numIds );
+	}
+
+	/* Final numbering. Classes of keys that always take the default come
+	 * last and share the out of map class. */
+	long *remap = new long[numIds];
+	for ( long c = 0; c < numIds; c++ )
+		remap[c] = -1;
+	long nextClass = 0;
+	Vector<Key> classKey;
+	for ( int i = 0; i < numIntervals; i++ ) {
+		if ( covered[i] && remap[classOf[i]] < 0 ) {
+			remap[classOf[i]] = nextClass++;
+			classKey.append( keys[i] );
+		}
+	}
+	for ( int i = 0; i < numIntervals; i++ )
+		classOf[i] = covered[i] ? remap[classOf[i]] : nextClass;
+	delete[] remap;
+
+	/* Small alphabets are mapped whole so the key needs no bounds check. */
+	Key lowKey, highKey;
+	if ( keyOps->alphSize() <= 256 ) {
+		lowKey = keyOps->minKey;
+		highKey = keyOps->maxKey;
+	}
+	else {
+		int first = 0, last = numIntervals - 1;
+		while ( !covered[first] )
+			first += 1;
+		while ( !covered[last] )
+			last -= 1;
+		lowKey = keys[first];
+		if ( last + 1 < numIntervals ) {
+			highKey = keys[last+1];
+			highKey.decrement();
+		}
+		else
+			highKey = keyOps->maxKey;
+	}
+
+	unsigned long long mapSize = keySpan( lowKey, highKey );
+	unsigned long long classEntries = mapSize;
+	for ( RedStateList::Iter st = stateList; st.lte() && classEntries < keyEntries; st++ ) {
+		if ( st->outRange.length() == 0 )
+			continue;
+
+		/* Find the span of classes the state does not take the default on. */
+		long lowClass = -1, highClass = -1;
+		for ( long c = 0; c < nextClass; c++ ) {
+			if ( transOfKey( st, classKey[c] ) != st->defTrans ) {
+				if ( lowClass < 0 )
+					lowClass = c;
+				highClass = c;
+			}
+		}
+		if ( lowClass >= 0 )
+			classEntries += highClass - lowClass + 1;
+	}
+
+	if ( !always && classEntries >= keyEntries ) {
+		delete[] classOf;
+		delete[] covered;
+		return;
+	}
+
+	if ( always && mapSize > FLAT_PAGE_SPAN ) {
+		/* Keep the intervals, joining neighbours of the same class. */
+		classIntKeys = new Key[numIntervals + 1];
+		classIntClasses = new long[numIntervals + 1];
+		numClassInts = 0;
+		if ( keys[0] > keyOps->minKey ) {
+			classIntKeys[0] = keyOps->minKey;
+			classIntClasses[0] = nextClass;
+			numClassInts = 1;
+		}
+		for ( int i = 0; i < numIntervals; i++ ) {
+			if ( numClassInts == 0 || classIntClasses[numClassInts-1] != classOf[i] ) {
+				classIntKeys[numClassInts] = keys[i];
+				classIntClasses[numClassInts] = classOf[i];
+				numClassInts += 1;
+			}
+		}
+	}
+	else {
+		/* Fill in the map. */
+		charClass = new long[mapSize];
+		for ( unsigned long long pos = 0; pos < mapSize; pos++ )
+			charClass[pos] = nextClass;
+		for ( int i = 0; i < numIntervals; i++ ) {
+			Key low = keys[i];
+			Key high = keyOps->maxKey;
+			if ( i + 1 < numIntervals ) {
+				high = keys[i+1];
+				high.decrement();
+			}
+
+			if ( low < lowKey )
+				low = lowKey;
+			if ( high > highKey )
+				high = highKey;
+			if ( low > high )
+				continue;
+
+			unsigned long long base = keyOps->span( lowKey, low ) - 1;
+			unsigned long long span = keyOps->span( low, high );
+			for ( unsigned long long pos = 0; pos < span; pos++ )
+				charClass[base+pos] = classOf[i];
+		}
+	}
+
+	classLowKey = lowKey;
+	classHighKey = highKey;
+	numClasses = nextClass;
+
+	/* Rewrite the transition lists of the states in terms of classes. */
+	RedTransAp **classTransList = new RedTransAp*[nextClass];
+	for ( RedStateList::Iter st = stateList; st.lte(); st++ ) {
+		if ( st->outRange.length() == 0 )
+			continue;
+
+		long lowClass = -1, highClass = -1;
+		for ( long c = 0; c < nextClass; c++ ) {
+			classTransList[c] = transOfKey( st, classKey[c] );
+			if ( classTransList[c] != st->defTrans ) {
+				if ( lowClass < 0 )
+					lowClass = c;
+				highClass = c;
+			}
+		}
+
+		delete[] st->transList;
+		if ( lowClass < 0 ) {
+			st->lowKey = st->highKey = 0;
+			st->transList = 0;
+		}
+		else {
+			st->lowKey = lowClass;
+			st->highKey = highClass;
+			st->transList = new RedTransAp*[highClass - lowClass + 1];
+			for ( long c = lowClass; c <= highClass; c++ )
+				st->transList[c - lowClass] = classTransList[c];
+		}
+	}
+
+	delete[] classTransList;
+	delete[] classOf;
+	delete[] covered;
+}
+
+/* The row of a state in the row displacement tables. Its entries are the
+ * columns where it does not take the default transition. */
+struct CombRow
+{
+	RedStateAp *state;
+	long first;
+	long length;
+};
+
+/* Longest rows are placed first. */
+struct CmpCombRow
+{
+	static int compare( const CombRow &row1, const CombRow &row2 )
+	{
+		if ( row1.length > row2.length )
+			return -1;
+		else if ( row1.length < row2.length )
+			return 1;
+		else if ( row1.state->id < row2.state->id )
+			return -1;
+		else if ( row1.state->id > row2.state->id )
+			return 1;
+		return 0;
+	}
+};
+
+/* Pack the rows of the flat tables into shared next and check arrays. Each
+ * row is placed at the first offset where all of its entries land on empty
+ * slots. Makes the flat tables, which are put in terms of classes if
+ * possible. Machines wider than a flat page go straight from the ranges to
+ * classes, as the key indexed tables could not be held. Returns false if such
+ * a machine cannot be put in classes because it has conditions. */
+bool RedFsmAp::makeComb()
+{
+	bool any = false;
+	for ( RedStateList::Iter st = stateList; st.lte(); st++ ) {
+		if ( st->outRange.length() > 0 ) {
+			Key low = st->outRange[0].lowKey;
+			Key high = st->outRange[st->outRange.length()-1].highKey;
+			if ( !any || low < combLowKey )
+				combLowKey = low;
+			if ( !any || high > combHighKey )
+				combHighKey = high;
+			any = true;
+		}
+	}
+
+	if ( !any || keySpan( combLowKey, combHighKey ) <= FLAT_PAGE_SPAN ) {
+		makeFlat();
+		if ( !anyCharClasses() )
+			makeCharClasses( true );
+	}
+	else if ( !makeWideClasses() )
+		return false;
+
+	if ( anyCharClasses() ) {
+		/* The out of map class is a column too. */
+		numCombCols = numClasses + 1;
+	}
+	else {
+		numCombCols = any ? keyOps->span( combLowKey, combHighKey ) : 0;
+	}
+
+	/* The transitions of a state over all columns. */
+	RedTransAp **colTrans = new RedTransAp*[numCombCols];
+	long *transCount = new long[nextTransId];
+	for ( int t = 0; t < nextTransId; t++ )
+		transCount[t] = 0;
+
+	Vector<long> cols;
+	Vector<RedTransAp*> trans;
+	Vector<CombRow> rows;
+	for ( RedStateList::Iter st = stateList; st.lte(); st++ ) {
+		for ( long col = 0; col < numCombCols; col++ )
+			colTrans[col] = st->defTrans;
+		if ( st->transList != 0 ) {
+			long base = anyCharClasses() ? st->lowKey.getVal() :
+					keyOps->span( combLowKey, st->lowKey ) - 1;
+			unsigned long long span = keyOps->span( st->lowKey, st->highKey );
+			for ( unsigned long long pos = 0; pos < span; pos++ )
+				colTrans[base + pos] = st->transList[pos];
+		}
+
+		/* With classes the default is the transition taken on the most
+		 * columns, which is not always the flat default. Without classes the
+		 * keys outside of the columns need the flat default. */
+		st->combDefTrans = st->defTrans;
+		long bestCount = 0;
+		for ( long col = 0; anyCharClasses() && col < numCombCols; col++ ) {
+			if ( colTrans[col] != 0 ) {
+				long count = ++transCount[colTrans[col]->id];
+				if ( count > bestCount ) {
+					bestCount = count;
+					st->combDefTrans = colTrans[col];
+				}
+			}
+		}
+
+		CombRow row;
+		row.state = st;
+		row.first = cols.length();
+		for ( long col = 0; col < numCombCols; col++ ) {
+			if ( colTrans[col] != 0 ) {
+				transCount[colTrans[col]->id] = 0;
+				if ( colTrans[col] != st->combDefTrans ) {
+					cols.append( col );
+					trans.append( colTrans[col] );
+				}
+			}
+		}
+		row.length = cols.length() - row.first;
+		rows.append( row );
+	}
+
+	delete[] colTrans;
+	delete[] transCount;
+
+	MergeSort<CombRow, CmpCombRow> rowSort;
+	rowSort.sort( rows.data, rows.length() );
+
+	/* Slots are added as needed. Enough are kept past the last row so any
+	 * column can be looked up from any row. */
+	long capacity = numCombCols + cols.length() + 1;
+	combNext = new RedTransAp*[capacity];
+	combCheck = new int[capacity];
+	for ( long slot = 0; slot < capacity; slot++ ) {
+		combNext[slot] = 0;
+		combCheck[slot] = nextStateId;
+	}
+
+	long firstEmpty = 0;
+	maxCombBase = 0;
+	for ( int r = 0; r < rows.length(); r++ ) {
+		CombRow &row = rows[r];
+		if ( row.length == 0 ) {
+			row.state->combBase = 0;
+			continue;
+		}
+
+		long *rowCols = cols.data + row.first;
+		long base = firstEmpty > rowCols[0] ? firstEmpty - rowCols[0] : 0;
+		while ( true ) {
+			if ( base + numCombCols > capacity ) {
+				long newCapacity = capacity * 2;
+				RedTransAp **newNext = new RedTransAp*[newCapacity];
+				int *newCheck = new int[newCapacity];
+				for ( long slot = 0; slot < newCapacity; slot++ ) {
+					newNext[slot] = slot < capacity ? combNext[slot] : 0;
+					newCheck[slot] = slot < capacity ? combCheck[slot] : nextStateId;
+				}
+				delete[] combNext;
+				delete[] combCheck;
+				combNext = newNext;
+				combCheck = newCheck;
+				capacity = newCapacity;
+			}
+
+			long e = 0;
+			while ( e < row.length && combCheck[base + rowCols[e]] == nextStateId )
+				e += 1;
+			if ( e == row.length )
+				break;
+			base += 1;
+		}
+
+		for ( long e = 0; e < row.length; e++ ) {
+			combNext[base + rowCols[e]] = trans[row.first + e];
+			combCheck[base + rowCols[e]] = row.state->id;
+		}
+		row.state->combBase = base;
+		if ( base > maxCombBase )
+			maxCombBase = base;
+
+		while ( firstEmpty < capacity && combCheck[firstEmpty] != nextStateId )
+			firstEmpty += 1;
+	}
+
+	combSize = maxCombBase + numCombCols;
+	if ( combSize == 0 )
+		combSize = 1;
+	return true;
 }
 
 
@@ -404,11 +1115,12 @@ RedTransAp *RedFsmAp::chooseDefaultSpan( RedStateAp *state )
 		span[pos] += keyOps->span( rtel->lowKey, rtel->highKey );
 	}
 
-	/* Find the max span, choose it for making the default. */
+	/* Find the max span, choose it for making the default. A range over the
+	 * whole of a 64 bit alphabet has a span of zero, and is the only one. */
 	RedTransAp *maxTrans = 0;
 	unsigned long long maxSpan = 0;
 	for ( RedTransSet::Iter rtel = stateTransSet; rtel.lte(); rtel++ ) {
-		if ( span[rtel.pos()] > maxSpan ) {
+		if ( maxTrans == 0 || span[rtel.pos()] > maxSpan ) {
 			maxSpan = span[rtel.pos()];
 			maxTrans = *rtel;
 		}
@@ -493,6 +1205,54 @@ RedTransAp *RedFsmAp::chooseDefaultNumRanges( RedStateAp *state )
 	return maxTrans;
 }
 
+/* Pick the transition taken least often, going by the profile. Of equally
+ * cold transitions the one with the largest span is taken, as with
+ * chooseDefaultSpan. Every transition but the default needs a test, so this
+ * keeps the tests for the hot ones. */
+RedTransAp *RedFsmAp::chooseDefaultProfile( RedStateAp *state )
+{
+	/* Make a set of transitions from the outRange. */
+	RedTransSet stateTransSet;
+	for ( RedTransList::Iter rtel = state->outRange; rtel.lte(); rtel++ )
+		stateTransSet.insert( rtel->value );
+	
+	unsigned long long *span = new unsigned long long[stateTransSet.length()];
+	memset( span, 0, sizeof(unsigned long long) * stateTransSet.length() );
+	for ( RedTransList::Iter rtel = state->outRange; rtel.lte(); rtel++ ) {
+		RedTransAp **inSet = stateTransSet.find( rtel->value );
+		int pos = inSet - stateTransSet.data;
+		span[pos] += keyOps->span( rtel->lowKey, rtel->highKey );
+	}
+
+	RedTransAp *minTrans = 0;
+	long long minCount = 0;
+	unsigned long long maxSpan = 0;
+	for ( RedTransSet::Iter rtel = stateTransSet; rtel.lte(); rtel++ ) {
+		long long count = profEstimate( state, *rtel );
+		if ( minTrans == 0 || count < minCount || 
+				( count == minCount && span[rtel.pos()] > maxSpan ) )
+		{
+			minTrans = *rtel;
+			minCount = count;
+			maxSpan = span[rtel.pos()];
+		}
+	}
+
+	delete[] span;
+	return minTrans;
+}
+
+void RedFsmAp::chooseDefaultProfile()
+{
+	for ( RedStateList::Iter st = stateList; st.lte(); st++ ) {
+		/* As with chooseDefaultSpan, only when the alphabet is covered. */
+		if ( alphabetCovered( st->outRange ) ) {
+			RedTransAp *defTrans = chooseDefaultProfile( st );
+			moveToDefault( defTrans, st );
+		}
+	}
+}
+
 void RedFsmAp::chooseDefaultNumRanges()
 {
 	/* Loop the states. */
@@ -540,28 +1300,506 @@ RedTransAp *RedFsmAp::allocateTrans( RedStateAp *targ, RedAction *action )
 	return inDict;
 }
 
+/*
+ * Profiles.
+ *
+ * A profile is text. Following a "machine <name>" line, "state <id> <count>"
+ * lines give the number of times a state was entered and "trans <id> <targ>
+ * <count>" lines the number of times a transition was taken. Other lines are
+ * ignored and counts that appear more than once are summed, so the profiles
+ * of several runs can be concatenated. Returns false if the profile does not
+ * fit this machine, in which case no counts are kept.
+ */
+bool RedFsmAp::readProfile( std::istream &in, const char *machine )
+{
+	RedStateAp **stateById = new RedStateAp*[nextStateId];
+	memset( stateById, 0, sizeof(RedStateAp*) * nextStateId );
+	for ( RedStateList::Iter st = stateList; st.lte(); st++ )
+		stateById[st->id] = st;
+
+	RedTransAp **transById = new RedTransAp*[nextTransId];
+	memset( transById, 0, sizeof(RedTransAp*) * nextTransId );
+	for ( TransApSet::Iter trans = transSet; trans.lte(); trans++ )
+		transById[trans->id] = trans;
+
+	bool inMachine = false, fits = true;
+	string line;
+	while ( fits && getline( in, line ) ) {
+		std::istringstream words( line );
+		string word;
+		words >> word;
+
+		long id, targ;
+		long long count;
+		if ( word == "machine" ) {
+			words >> word;
+			inMachine = word == machine;
+		}
+		else if ( inMachine && word == "state" ) {
+			if ( !( words >> id >> count ) || id < 0 || id >= nextStateId || 
+					stateById[id] == 0 )
+				fits = false;
+			else {
+				stateById[id]->profCount += count;
+				profiled = true;
+			}
+		}
+		else if ( inMachine && word == "trans" ) {
+			if ( !( words >> id >> targ >> count ) || id < 0 || id >= nextTransId || 
+					transById[id] == 0 || transById[id]->targ->id != targ )
+				fits = false;
+			else {
+				transById[id]->profCount += count;
+				profiled = true;
+			}
+		}
+	}
+
+	if ( !fits ) {
+		for ( RedStateList::Iter st = stateList; st.lte(); st++ )
+			st->profCount = 0;
+		for ( TransApSet::Iter trans = transSet; trans.lte(); trans++ )
+			trans->profCount = 0;
+		profiled = false;
+	}
+
+	/* Sum the entry counts of the states using each transition, once per
+	 * state. See profEstimate. */
+	int *lastFrom = new int[nextTransId];
+	for ( int t = 0; t < nextTransId; t++ )
+		lastFrom[t] = -1;
+
+	Vector<RedTransEl> out;
+	for ( RedStateList::Iter st = stateList; st.lte(); st++ ) {
+		out.empty();
+		out.append( st->outSingle );
+		out.append( st->outRange );
+		if ( st->defTrans != 0 )
+			out.append( RedTransEl( 0, 0, st->defTrans ) );
+
+		for ( Vector<RedTransEl>::Iter rtel = out; rtel.lte(); rtel++ ) {
+			RedTransAp *trans = rtel->value;
+			if ( lastFrom[trans->id] != st->id ) {
+				lastFrom[trans->id] = st->id;
+				trans->profSrcCount += st->profCount;
+			}
+		}
+	}
+
+	delete[] stateById;
+	delete[] transById;
+	delete[] lastFrom;
+	return fits;
+}
+
+/* The profile counts a transition as a whole, though several states may use
+ * it. Estimate how often it is taken from one state by sharing its count in
+ * proportion to how often the states using it are entered. */
+long long RedFsmAp::profEstimate( RedStateAp *state, RedTransAp *trans )
+{
+	if ( trans->profSrcCount == 0 )
+		return 0;
+	return (long long)( (double)trans->profCount * 
+			state->profCount / trans->profSrcCount );
+}
+
+/*
+ * Partitioning for the split code generator. The states are the nodes of an
+ * undirected graph weighted by code size, with edges weighted by how often
+ * control is expected to pass between them. The graph is cut by recursive
+ * bisection. Each bisection grows one side out from the first state in
+ * depth-first order, then improves the cut with Fiduccia-Mattheyses passes.
+ */
+
+struct PartEdge
+{
+	int to;
+	long long weight;
+};
+
+struct PartNode
+{
+	long long weight;
+	Vector<PartEdge> edges;
+
+	/* Side of the cut being made, or -1 if not in the set being cut. */
+	int side;
+	bool locked;
+	long long gain;
+};
+
+/* Nodes ordered by gain, for finding the best node to move. */
+struct PartGain
+{
+	PartGain() {}
+	PartGain( long long gain, int id ) : gain(gain), id(id) {}
+
+	long long gain;
+	int id;
+};
+
+struct CmpPartGain
+{
+	static int compare( const PartGain &g1, const PartGain &g2 )
+	{
+		if ( g1.gain < g2.gain )
+			return -1;
+		else if ( g1.gain > g2.gain )
+			return 1;
+		else if ( g1.id > g2.id )
+			return -1;
+		else if ( g1.id < g2.id )
+			return 1;
+		return 0;
+	}
+};
+
+typedef AvlSet<PartGain, CmpPartGain> PartGainSet;
+
+/* Most passes of refinement per bisection. */
+#define PART_MAX_PASSES 8
+
+struct FsmPartitioner
+{
+	FsmPartitioner( PartNode *nodes, int *partOf )
+		: nodes(nodes), partOf(partOf) {}
+
+	PartNode *nodes;
+	int *partOf;
+
+	void setGain( PartGainSet *gains, int id, long long gain );
+	void grow( Vector<int> &set, long long targetA, long long &weightA );
+	bool refine( Vector<int> &set, long long targetA, long long tolerance,
+			long long &weightA );
+	void partition( Vector<int> &set, int firstPart, int nParts );
+};
+
+void FsmPartitioner::setGain( PartGainSet *gains, int id, long long gain )
+{
+	gains->remove( PartGain( nodes[id].gain, id ) );
+	nodes[id].gain = gain;
+	gains->insert( PartGain( gain, id ) );
+}
+
+/* Move nodes to side zero, always taking the node most strongly connected to
+ * it, until it holds targetA of the weight. */
+void FsmPartitioner::grow( Vector<int> &set, long long targetA, long long &weightA )
+{
+	PartGainSet frontier;
+	int next = 0;
+	weightA = 0;
+	while ( weightA < targetA ) {
+		int id;
+		if ( frontier.length() > 0 )
+			id = frontier.tail->key.id;
+		else {
+			/* Start again from the next node in depth-first order. */
+			while ( nodes[set[next]].side != 1 )
+				next += 1;
+			id = set[next];
+		}
+
+		/* Stop short if taking the node overshoots by more than leaving it. */
+		PartNode *node = nodes + id;
+		if ( weightA > 0 && weightA + node->weight - targetA > targetA - weightA )
+			break;
+
+		frontier.remove( PartGain( node->gain, id ) );
+		node->side = 0;
+		weightA += node->weight;
+
+		for ( Vector<PartEdge>::Iter edge = node->edges; edge.lte(); edge++ ) {
+			if ( nodes[edge->to].side == 1 )
+				setGain( &frontier, edge->to, nodes[edge->to].gain + edge->weight );
+		}
+	}
+}
+
+/* One Fiduccia-Mattheyses pass. Moves nodes one at a time, best gain first
+ * and keeping the balance, then keeps the best prefix of the moves. Returns
+ * true if the cut improved. */
+bool FsmPartitioner::refine( Vector<int> &set, long long targetA, 
+		long long tolerance, long long &weightA )
+{
+	PartGainSet gains[2];
+	for ( Vector<int>::Iter id = set; id.lte(); id++ ) {
+		PartNode *node = nodes + *id;
+		node->locked = false;
+		node->gain = 0;
+		for ( Vector<PartEdge>::Iter edge = node->edges; edge.lte(); edge++ ) {
+			int side = nodes[edge->to].side;
+			if ( side == node->side )
+				node->gain -= edge->weight;
+			else if ( side >= 0 )
+				node->gain += edge->weight;
+		}
+		gains[node->side].insert( PartGain( node->gain, *id ) );
+	}
+
+	Vector<int> moves;
+	long long total = 0, best = 0;
+	long long bestBalance = weightA > targetA ? weightA - targetA : targetA - weightA;
+	int bestMoves = 0;
+	while ( true ) {
+		/* Best node on each side that can move without upsetting the
+		 * balance. */
+		int id = -1;
+		for ( int side = 0; side < 2; side++ ) {
+			if ( gains[side].length() == 0 )
+				continue;
+			int cand = gains[side].tail->key.id;
+			long long after = side == 0 ? weightA - nodes[cand].weight : 
+					weightA + nodes[cand].weight;
+			if ( after < targetA - tolerance || after > targetA + tolerance )
+				continue;
+			if ( id < 0 || nodes[cand].gain > nodes[id].gain )
+				id = cand;
+		}
+
+		if ( id < 0 )
+			break;
+
+		PartNode *node = nodes + id;
+		gains[node->side].remove( PartGain( node->gain, id ) );
+		node->locked = true;
+		weightA += node->side == 0 ? -node->weight : node->weight;
+		node->side = 1 - node->side;
+		total += node->gain;
+		moves.append( id );
+
+		for ( Vector<PartEdge>::Iter edge = node->edges; edge.lte(); edge++ ) {
+			PartNode *to = nodes + edge->to;
+			if ( to->side >= 0 && !to->locked ) {
+				long long change = to->side == node->side ? -2 * edge->weight : 
+						2 * edge->weight;
+				setGain( &gains[to->side], edge->to, to->gain + change );
+			}
+		}
+
+		long long balance = weightA > targetA ? weightA - targetA : targetA - weightA;
+		if ( total > best || ( total == best && balance < bestBalance ) ) {
+			best = total;
+			bestBalance = balance;
+			bestMoves = moves.length();
+		}
+	}
+
+	/* Undo the moves past the best point. */
+	for ( int m = moves.length() - 1; m >= bestMoves; m-- ) {
+		PartNode *node = nodes + moves[m];
+		node->side = 1 - node->side;
+		weightA += node->side == 0 ? node->weight : -node->weight;
+	}
+
+	return best > 0;
+}
+
+/* Cut the set into nParts partitions, numbered from firstPart. */
+void FsmPartitioner::partition( Vector<int> &set, int firstPart, int nParts )
+{
+	if ( nParts == 1 || set.length() <= 1 ) {
+		for ( Vector<int>::Iter id = set; id.lte(); id++ )
+			partOf[*id] = firstPart;
+		return;
+	}
+
+	long long weight = 0, maxWeight = 0;
+	for ( Vector<int>::Iter id = set; id.lte(); id++ ) {
+		PartNode *node = nodes + *id;
+		node->side = 1;
+		node->gain = 0;
+		weight += node->weight;
+		if ( node->weight > maxWeight )
+			maxWeight = node->weight;
+	}
+
+	/* Side zero becomes the first half of the partitions. */
+	int nPartsA = nParts / 2;
+	long long targetA = weight * nPartsA / nParts;
+	long long tolerance = weight / 20 > maxWeight ? weight / 20 : maxWeight;
+
+	long long weightA;
+	grow( set, targetA, weightA );
+	for ( int pass = 0; pass < PART_MAX_PASSES; pass++ ) {
+		if ( !refine( set, targetA, tolerance, weightA ) )
+			break;
+	}
+
+	Vector<int> setA, setB;
+	for ( Vector<int>::Iter id = set; id.lte(); id++ ) {
+		if ( nodes[*id].side == 0 )
+			setA.append( *id );
+		else
+			setB.append( *id );
+		nodes[*id].side = -1;
+	}
+
+	partition( setA, firstPart, nPartsA );
+	partition( setB, firstPart + nPartsA, nParts - nPartsA );
+}
+
+/* Strongly connected components, by Tarjan's algorithm. Transitions within
+ * a component are on a cycle. */
+struct PartSccs
+{
+	PartSccs( int numStates, RedStateAp *errState );
+	~PartSccs();
+
+	RedStateAp *errState;
+	int *index, *low, *comp;
+	bool *onStack;
+	Vector<RedStateAp*> stack;
+	int nextIndex, nextComp;
+
+	void visit( RedStateAp *state, RedStateAp *targ );
+	void visit( RedStateAp *state );
+};
+
+PartSccs::PartSccs( int numStates, RedStateAp *errState )
+:
+	errState(errState),
+	index(new int[numStates]),
+	low(new int[numStates]),
+	comp(new int[numStates]),
+	onStack(new bool[numStates]),
+	nextIndex(0),
+	nextComp(0)
+{
+	for ( int s = 0; s < numStates; s++ ) {
+		index[s] = -1;
+		onStack[s] = false;
+	}
+}
+
+PartSccs::~PartSccs()
+{
+	delete[] index;
+	delete[] low;
+	delete[] comp;
+	delete[] onStack;
+}
+
+void PartSccs::visit( RedStateAp *state, RedStateAp *targ )
+{
+	if ( targ == 0 || targ == errState )
+		return;
+
+	if ( index[targ->id] < 0 ) {
+		visit( targ );
+		if ( low[targ->id] < low[state->id] )
+			low[state->id] = low[targ->id];
+	}
+	else if ( onStack[targ->id] && index[targ->id] < low[state->id] )
+		low[state->id] = index[targ->id];
+}
+
+void PartSccs::visit( RedStateAp *state )
+{
+	index[state->id] = low[state->id] = nextIndex++;
+	stack.append( state );
+	onStack[state->id] = true;
+
+	for ( RedTransList::Iter rtel = state->outSingle; rtel.lte(); rtel++ )
+		visit( state, rtel->value->targ );
+	for ( RedTransList::Iter rtel = state->outRange; rtel.lte(); rtel++ )
+		visit( state, rtel->value->targ );
+	if ( state->defTrans != 0 )
+		visit( state, state->defTrans->targ );
+
+	if ( low[state->id] == index[state->id] ) {
+		RedStateAp *member;
+		do {
+			member = stack[stack.length()-1];
+			stack.remove( stack.length()-1 );
+			onStack[member->id] = false;
+			comp[member->id] = nextComp;
+		} while ( member != state );
+		nextComp += 1;
+	}
+}
+
+/* Number of keys a transition list entry covers, up to a limit. */
+static long long partKeys( RedTransEl *rtel )
+{
+	long span = rtel->highKey.getVal() - rtel->lowKey.getVal();
+	return span < 0 || span >= 256 ? 256 : span + 1;
+}
+
 void RedFsmAp::partitionFsm( int nparts )
 {
-	/* At this point the states are ordered by a depth-first traversal. We
-	 * will allocate to partitions based on this ordering. */
+	if ( nparts < 1 )
+		nparts = 1;
 	this->nParts = nparts;
-	int partSize = stateList.length() / nparts;
-	int remainder = stateList.length() % nparts;
-	int numInPart = partSize;
-	int partition = 0;
-	if ( remainder-- > 0 )
-		numInPart += 1;
+
+	/* Nodes are numbered by position in the depth-first ordering the states
+	 * are in now, so ties between nodes go the way of that ordering. */
+	int *pos = new int[nextStateId];
+	PartNode *nodes = new PartNode[stateList.length()];
+	int nextPos = 0;
+	for ( RedStateList::Iter st = stateList; st.lte(); st++ ) {
+		PartNode *node = nodes + nextPos;
+		pos[st->id] = nextPos++;
+		node->weight = 1 + st->outSingle.length() + 
+				st->outRange.length() + st->stateCondVect.length();
+		node->side = -1;
+	}
+
+	PartSccs sccs( nextStateId, errState );
+	for ( RedStateList::Iter st = stateList; st.lte(); st++ ) {
+		if ( st != errState && sccs.index[st->id] < 0 )
+			sccs.visit( st );
+	}
+
+	Vector<RedTransEl> out;
 	for ( RedStateList::Iter st = stateList; st.lte(); st++ ) {
-		st->partition = partition;
+		out.empty();
+		out.append( st->outSingle );
+		out.append( st->outRange );
+		if ( st->defTrans != 0 )
+			out.append( RedTransEl( 0, 0, st->defTrans ) );
+
+		for ( Vector<RedTransEl>::Iter rtel = out; rtel.lte(); rtel++ ) {
+			/* Self loops never cross and the error state is cold. */
+			RedTransAp *trans = rtel->value;
+			RedStateAp *targ = trans->targ;
+			if ( targ == st || targ == errState )
+				continue;
+
+			/* Without a profile, transitions on many keys and transitions
+			 * closing a cycle are expected to be hot. */
+			long long weight;
+			if ( profiled )
+				weight = 1 + profEstimate( st, trans );
+			else {
+				bool isDefault = st->defTrans != 0 && rtel.last();
+				weight = isDefault ? 1 : partKeys( rtel );
+				if ( sccs.comp[targ->id] == sccs.comp[st->id] )
+					weight *= 8;
+			}
 
-		numInPart -= 1;
-		if ( numInPart == 0 ) {
-			partition += 1;
-			numInPart = partSize;
-			if ( remainder-- > 0 )
-				numInPart += 1;
+			PartEdge edge;
+			edge.weight = weight;
+			edge.to = pos[targ->id];
+			nodes[pos[st->id]].edges.append( edge );
+			edge.to = pos[st->id];
+			nodes[pos[targ->id]].edges.append( edge );
 		}
 	}
+
+	Vector<int> set;
+	for ( RedStateList::Iter st = stateList; st.lte(); st++ )
+		set.append( pos[st->id] );
+
+	int *partOf = new int[stateList.length()];
+	FsmPartitioner partitioner( nodes, partOf );
+	partitioner.partition( set, 0, nparts );
+
+	for ( RedStateList::Iter st = stateList; st.lte(); st++ )
+		st->partition = partOf[pos[st->id]];
+
+	delete[] pos;
+	delete[] nodes;
+	delete[] partOf;
 }
 
 void RedFsmAp::setInTrans()
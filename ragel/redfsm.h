@@ -25,6 +25,7 @@
 #include <assert.h>
 #include <string.h>
 #include <string>
+#include <iostream>
 #include "config.h"
 #include "common.h"
 #include "vector.h"
@@ -35,6 +36,7 @@
 #include "avlmap.h"
 #include "avltree.h"
 #include "avlbasic.h"
+#include "avlset.h"
 #include "mergesort.h"
 #include "sbstmap.h"
 #include "sbstset.h"
@@ -45,6 +47,15 @@
 #define STATE_ERR_STATE   0
 #define FUNC_NO_FUNC      0
 
+/* Flat machines with a state spanning more keys than this are paged. */
+#define FLAT_PAGE_SPAN    65536
+
+/* Flat machines with a state spanning more than 2^FLAT_PAGE_MAX_BITS keys are
+ * not paged, as there would be too many pages per state. Their classes are
+ * searched for instead. Pages and offsets into the span of a state so fit in
+ * an int. */
+#define FLAT_PAGE_MAX_BITS 24
+
 using std::string;
 
 struct RedStateAp;
@@ -61,12 +72,12 @@ struct GenInlineItem
 		Text, Goto, Call, Next, GotoExpr, CallExpr, NextExpr, Ret, 
 		PChar, Char, Hold, Exec, Curs, Targs, Entry,
 		LmSwitch, LmSetActId, LmSetTokEnd, LmGetTokEnd, LmInitTokStart,
-		LmInitAct, LmSetTokStart, SubAction, Break
+		LmInitAct, LmSetTokStart, SubAction, Break, Counter
 	};
 
 	GenInlineItem( const InputLoc &loc, Type type ) : 
 		loc(loc), data(0), targId(0), targState(0), 
-		lmId(0), children(0), offset(0),
+		lmId(0), children(0), offset(0), counterId(0),
 		type(type) { }
 	
 	InputLoc loc;
@@ -76,6 +87,7 @@ struct GenInlineItem
 	int lmId;
 	GenInlineList *children;
 	int offset;
+	int counterId;
 	Type type;
 
 	GenInlineItem *prev, *next;
@@ -211,7 +223,8 @@ struct RedTransAp
 	public AvlTreeEl<RedTransAp>
 {
 	RedTransAp( RedStateAp *targ, RedAction *action, int id )
-		: targ(targ), action(action), id(id), pos(-1), labelNeeded(true) { }
+		: targ(targ), action(action), id(id), pos(-1), labelNeeded(true),
+			profCount(0), profSrcCount(0) { }
 
 	RedStateAp *targ;
 	RedAction *action;
@@ -219,6 +232,11 @@ struct RedTransAp
 	int pos;
 	bool partitionBoundary;
 	bool labelNeeded;
+
+	/* Times taken, from a profile, and the summed entry counts of the
+	 * states that use it. */
+	long long profCount;
+	long long profSrcCount;
 };
 
 /* Compare of transitions for the final reduction of transitions. Comparison
@@ -326,10 +344,14 @@ struct RedStateAp
 		defTrans(0), 
 		condList(0),
 		transList(0), 
+		pageList(0), 
+		combBase(0), 
+		combDefTrans(0), 
 		isFinal(false), 
 		labelNeeded(false), 
 		outNeeded(false), 
 		onStateList(false), 
+		literalLen(0), 
 		toStateAction(0), 
 		fromStateAction(0), 
 		eofAction(0), 
@@ -338,7 +360,8 @@ struct RedStateAp
 		bAnyRegCurStateRef(false),
 		partitionBoundary(false),
 		inTrans(0),
-		numInTrans(0)
+		numInTrans(0),
+		profCount(0)
 	{ }
 
 	/* Transitions out. */
@@ -354,6 +377,15 @@ struct RedStateAp
 	Key lowKey, highKey;
 	RedTransAp **transList;
 
+	/* For paged flat keys. The span is cut into pages that are shared between
+	 * states. Used instead of the transList. */
+	long *pageList;
+
+	/* Offset of the state's row in the row displacement tables and the
+	 * transition taken on columns left out of the row. */
+	long combBase;
+	RedTransAp *combDefTrans;
+
 	/* The list of states that transitions from this state go to. */
 	RedStateVect targStates;
 
@@ -361,6 +393,10 @@ struct RedStateAp
 	bool labelNeeded;
 	bool outNeeded;
 	bool onStateList;
+
+	/* Length of the chain of single key states that the goto styles match
+	 * in one compare, starting here. Zero if there is none. */
+	int literalLen;
 	RedAction *toStateAction;
 	RedAction *fromStateAction;
 	RedAction *eofAction;
@@ -380,11 +416,31 @@ struct RedStateAp
 
 	RedTransAp **inTrans;
 	int numInTrans;
+
+	/* Times entered, from a profile. */
+	long long profCount;
 };
 
 /* List of states. */
 typedef DList<RedStateAp> RedStateList;
 
+/* A page of a paged flat machine. Holds the transitions of a run of keys of
+ * the size of the machine's pages. */
+struct RedFlatPage
+{
+	RedTransAp **transList;
+	int size;
+	long id;
+};
+
+struct CmpRedFlatPage
+{
+	static int compare( RedFlatPage *const &page1, RedFlatPage *const &page2 );
+};
+
+typedef Vector<RedFlatPage*> RedFlatPageVect;
+typedef AvlSet< RedFlatPage*, CmpRedFlatPage > RedFlatPageSet;
+
 /* Set of reduced transitons. Comparison is by pointer. */
 typedef BstSet< RedTransAp*, CmpOrd<RedTransAp*> > RedTransSet;
 
@@ -392,6 +448,7 @@ typedef BstSet< RedTransAp*, CmpOrd<RedTransAp*> > RedTransSet;
 struct RedFsmAp
 {
 	RedFsmAp();
+	~RedFsmAp();
 
 	bool forcedErrorState;
 
@@ -413,6 +470,9 @@ struct RedFsmAp
 	int numFinStates;
 	int nParts;
 
+	/* Set when state and transition counts were read from a profile. */
+	bool profiled;
+
 	bool bAnyToStateActions;
 	bool bAnyFromStateActions;
 	bool bAnyRegActions;
@@ -428,6 +488,36 @@ struct RedFsmAp
 	bool bAnyRegBreak;
 	bool bAnyConditions;
 
+	/* Character classes of the flat tables. When in use, the flat key ranges
+	 * and transition lists of the states are in terms of classes. Keys
+	 * outside of the class map are in class numClasses. */
+	long *charClass;
+	Key classLowKey, classHighKey;
+	long numClasses;
+
+	/* Class maps too wide to write out are kept as the low keys of the
+	 * intervals of the key space and the class of each, for a binary search.
+	 * The first interval starts at the lowest key. */
+	Key *classIntKeys;
+	long *classIntClasses;
+	long numClassInts;
+
+	/* Paged flat tables. Pages hold 2^pageBits keys. */
+	bool flatPaged;
+	int pageBits;
+	RedFlatPageVect flatPages;
+	long numPageRefs;
+
+	/* Row displacement tables. Rows are indexed by class, or by key from
+	 * combLowKey when there are no classes. Empty slots are checked against
+	 * nextStateId. */
+	RedTransAp **combNext;
+	int *combCheck;
+	long combSize;
+	long numCombCols;
+	Key combLowKey, combHighKey;
+	long maxCombBase;
+
 	int maxState;
 	int maxSingleLen;
 	int maxRangeLen;
@@ -462,6 +552,8 @@ struct RedFsmAp
 	bool anyRegCurStateRef()        { return bAnyRegCurStateRef; }
 	bool anyRegBreak()              { return bAnyRegBreak; }
 	bool anyConditions()            { return bAnyConditions; }
+	bool anyCharClasses()           { return charClass != 0 || classIntKeys != 0; }
+	bool anyClassIntervals()        { return classIntKeys != 0; }
 
 
 	/* Is is it possible to extend a range by bumping ranges that span only
@@ -472,7 +564,11 @@ struct RedFsmAp
 	void moveTransToSingle( RedStateAp *state );
 	void chooseSingle();
 
-	void makeFlat();
+	bool makeFlat( bool canPage = false, bool forcePages = false );
+	bool makeWideClasses();
+	void makeCharClasses( bool always = false );
+	bool makeComb();
+	void makeFlatPages( RedStateAp *state, RedFlatPageSet &pageSet, long *uniformPage );
 
 	/* Move a selected transition from ranges to default. */
 	void moveToDefault( RedTransAp *defTrans, RedStateAp *state );
@@ -489,6 +585,10 @@ struct RedFsmAp
 	RedTransAp *chooseDefaultGoto( RedStateAp *state );
 	void chooseDefaultGoto();
 
+	/* Pick the least taken transition of a profile as the default. */
+	RedTransAp *chooseDefaultProfile( RedStateAp *state );
+	void chooseDefaultProfile();
+
 	/* Ordering states by transition connections. */
 	void optimizeStateOrdering( RedStateAp *state );
 	void optimizeStateOrdering();
@@ -521,6 +621,9 @@ struct RedFsmAp
 
 	RedTransAp *allocateTrans( RedStateAp *targState, RedAction *actionTable );
 
+	bool readProfile( std::istream &in, const char *machine );
+	long long profEstimate( RedStateAp *state, RedTransAp *trans );
+
 	void partitionFsm( int nParts );
 
 	void setInTrans();
@@ -104,6 +104,18 @@ std::ostream &RubyCodeGen::STATIC_VAR( string type, string name )
 
 std::ostream &RubyCodeGen::OPEN_ARRAY( string type, string name )
 {
+	if ( packedTablesOpt ) {
+		/* The reader is written by CLOSE_ARRAY, once the directive is known. */
+		packedName = name;
+		packedItems.empty();
+		packedSigned = true;
+		for ( int i = 0; i < hostLang->numHostTypes; i++ ) {
+			if ( type == hostLang->hostTypes[i].data1 )
+				packedSigned = hostLang->hostTypes[i].isSigned;
+		}
+		return out;
+	}
+
 	out << 
 		"class << self\n"
 		"	attr_accessor :" << name << "\n"
@@ -115,10 +127,101 @@ std::ostream &RubyCodeGen::OPEN_ARRAY( string type, string name )
 
 std::ostream &RubyCodeGen::CLOSE_ARRAY()
 {
+	if ( packedTablesOpt ) {
+		/* Choose the narrowest little endian directive that holds every
+		 * item. Items of unsigned tables are compared as unsigned. */
+		long long min = 0, max = 0;
+		unsigned long long umax = 0;
+		for ( long i = 0; i < packedItems.length(); i++ ) {
+			if ( packedItems[i] < min )
+				min = packedItems[i];
+			if ( packedItems[i] > max )
+				max = packedItems[i];
+			if ( (unsigned long long)packedItems[i] > umax )
+				umax = packedItems[i];
+		}
+
+		const char *directive;
+		int size;
+		if ( !packedSigned ) {
+			if ( umax < 0x100 )
+				directive = "C*", size = 1;
+			else if ( umax < 0x10000 )
+				directive = "S<*", size = 2;
+			else if ( umax < 0x100000000ULL )
+				directive = "L<*", size = 4;
+			else
+				directive = "Q<*", size = 8;
+		}
+		else if ( min >= -0x80 && max < 0x80 )
+			directive = "c*", size = 1;
+		else if ( min >= 0 && max < 0x100 )
+			directive = "C*", size = 1;
+		else if ( min >= -0x8000 && max < 0x8000 )
+			directive = "s<*", size = 2;
+		else if ( min >= 0 && max < 0x10000 )
+			directive = "S<*", size = 2;
+		else if ( min >= -0x80000000LL && max < 0x80000000LL )
+			directive = "l<*", size = 4;
+		else
+			directive = "q<*", size = 8;
+
+		/* The reader decodes the string the first time the table is used
+		 * and keeps the array. */
+		out << 
+			"class << self\n"
+			"	attr_writer :" << packedName << "\n"
+			"	def " << packedName << "\n"
+			"		if String === @" << packedName << "\n"
+			"			@" << packedName << " = @" << packedName << 
+					".unpack(\"m\")[0].unpack(\"" << directive << "\")\n"
+			"		end\n"
+			"		@" << packedName << "\n"
+			"	end\n"
+			"	private :" << packedName << ", :" << packedName << "=\n"
+			"end\n"
+			"self." << packedName << " = ";
+
+		PACKED_STRING( packedItems, size );
+		out << "\n";
+		return out;
+	}
+
 	out << "]\n";
 	return out;
 }
 
+/* Write items of size bytes each, little endian, as base64 in adjacent string
+ * literals, which the parser joins. */
+void RubyCodeGen::PACKED_STRING( const Vector<long long> &items, int size )
+{
+	static const char digits[] =
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	Vector<unsigned char> bytes;
+	for ( long i = 0; i < items.length(); i++ ) {
+		for ( int b = 0; b < size; b++ )
+			bytes.append( ( items[i] >> ( 8 * b ) ) & 0xff );
+	}
+
+	out << "\"";
+	for ( long i = 0; i < bytes.length(); i += 3 ) {
+		if ( i > 0 && i % 48 == 0 )
+			out << "\" \\\n\t\"";
+
+		long group = bytes[i] << 16;
+		if ( i + 1 < bytes.length() )
+			group |= bytes[i+1] << 8;
+		if ( i + 2 < bytes.length() )
+			group |= bytes[i+2];
+
+		out << digits[(group >> 18) & 0x3f] << digits[(group >> 12) & 0x3f];
+		out << ( i + 1 < bytes.length() ? digits[(group >> 6) & 0x3f] : '=' );
+		out << ( i + 2 < bytes.length() ? digits[group & 0x3f] : '=' );
+	}
+	out << "\"";
+}
+
 
 string RubyCodeGen::ARR_OFF( string ptr, string offset )
 {
@@ -196,6 +299,19 @@ string RubyCodeGen::TOP()
 	return ret.str();
 }
 
+string RubyCodeGen::COUNTERS()
+{
+	ostringstream ret;
+	if ( countersExpr == 0 )
+		ret << ACCESS() + "counters";
+	else {
+		//ret << "(";
+		INLINE_LIST( ret, countersExpr, 0, false );
+		//ret << ")";
+	}
+	return ret.str();
+}
+
 string RubyCodeGen::STACK()
 {
 	ostringstream ret;
@@ -423,6 +539,11 @@ void RubyCodeGen::STATE_IDS()
 	if ( !noError )
 		STATIC_VAR( "int", ERROR() ) << " = " << ERROR_STATE() << ";\n";
 
+	if ( numCounters > 0 ) {
+		STATIC_VAR( "int", DATA_PREFIX() + "num_counters" ) <<
+				" = " << numCounters << ";\n";
+	}
+
 	out << "\n";
 
 	if ( entryPointNames.length() > 0 ) {
@@ -436,12 +557,21 @@ void RubyCodeGen::STATE_IDS()
 
 std::ostream &RubyCodeGen::START_ARRAY_LINE()
 {
-	out << "\t";
+	if ( !packedTablesOpt )
+		out << "\t";
 	return out;
 }
 
 std::ostream &RubyCodeGen::ARRAY_ITEM( string item, int count, bool last )
 {
+	if ( packedTablesOpt ) {
+		if ( packedSigned )
+			packedItems.append( strtoll( item.c_str(), 0, 10 ) );
+		else
+			packedItems.append( (long long)strtoull( item.c_str(), 0, 10 ) );
+		return out;
+	}
+
 	out << item;
 	if ( !last )
 	{
@@ -457,7 +587,8 @@ std::ostream &RubyCodeGen::ARRAY_ITEM( string item, int count, bool last )
 
 std::ostream &RubyCodeGen::END_ARRAY_LINE()
 {
-	out << "\n";
+	if ( !packedTablesOpt )
+		out << "\n";
 	return out;
 }
 
@@ -576,6 +707,9 @@ void RubyCodeGen::INLINE_LIST( ostream &ret, GenInlineList *inlineList,
 		case GenInlineItem::Break:
 			BREAK( ret, targState );
 			break;
+		case GenInlineItem::Counter:
+			ret << COUNTERS() << "[" << item->counterId << "]";
+			break;
 		}
 	}
 }
@@ -33,12 +33,19 @@
 class RubyCodeGen : public CodeGenData
 {
 public:
-   RubyCodeGen( ostream &out ) : CodeGenData(out) { }
+   RubyCodeGen( ostream &out ) : CodeGenData(out), packedSigned(true) { }
    virtual ~RubyCodeGen() {}
 protected:
 	ostream &START_ARRAY_LINE();
 	ostream &ARRAY_ITEM( string item, int count, bool last );
 	ostream &END_ARRAY_LINE();
+	void PACKED_STRING( const Vector<long long> &items, int size );
+
+	/* Name and items of the open array when tables are packed, and whether
+	 * its type is signed. */
+	string packedName;
+	Vector<long long> packedItems;
+	bool packedSigned;
   
 
 	string FSM_NAME();
@@ -85,6 +92,7 @@ protected:
 	string ET() { return "_" + DATA_PREFIX() + "eof_trans"; }
 	string SP() { return "_" + DATA_PREFIX() + "key_spans"; }
 	string CSP() { return "_" + DATA_PREFIX() + "cond_key_spans"; }
+	string CC() { return "_" + DATA_PREFIX() + "char_class"; }
 	string START() { return DATA_PREFIX() + "start"; }
 	string ERROR() { return DATA_PREFIX() + "error"; }
 	string FIRST_FINAL() { return DATA_PREFIX() + "first_final"; }
@@ -103,6 +111,7 @@ public:
 
 	string vCS();
 	string TOP();
+	string COUNTERS();
 	string STACK();
 	string ACT();
 	string TOKSTART();
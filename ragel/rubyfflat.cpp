@@ -256,6 +256,13 @@ void RubyFFlatCodeGen::writeData()
 		"\n";
 	}
 
+	if ( redFsm->anyCharClasses() ) {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->numClasses), CC() );
+		CHAR_CLASS();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+
 	OPEN_ARRAY( WIDE_ALPH_TYPE(), K() );
 	KEYS();
 	CLOSE_ARRAY() <<
@@ -329,6 +336,8 @@ void RubyFFlatCodeGen::writeExec()
 		out << ", _ps";
 	if ( redFsm->anyConditions() )
 		out << ", _cond, _conds, _widec";
+	if ( redFsm->anyCharClasses() )
+		out << ", _cls";
 	if ( redFsm->anyToStateActions() || redFsm->anyRegActions() 
 			|| redFsm->anyFromStateActions() )
 		out << ", _acts, _nacts";
@@ -98,9 +98,16 @@ std::ostream &RubyFlatCodeGen::KEYS()
 	START_ARRAY_LINE();
 	int totalTrans = 0;
 	for ( RedStateList::Iter st = redFsm->stateList; st.lte(); st++ ) {
-		/* Emit just low key and high key. */
-		ARRAY_ITEM( KEY( st->lowKey ), ++totalTrans, false );
-		ARRAY_ITEM( KEY( st->highKey ), ++totalTrans, false );
+		/* Emit just low key and high key. These are classes when the keys
+		 * are mapped. */
+		if ( redFsm->anyCharClasses() ) {
+			ARRAY_ITEM( INT( st->lowKey.getVal() ), ++totalTrans, false );
+			ARRAY_ITEM( INT( st->highKey.getVal() ), ++totalTrans, false );
+		}
+		else {
+			ARRAY_ITEM( KEY( st->lowKey ), ++totalTrans, false );
+			ARRAY_ITEM( KEY( st->highKey ), ++totalTrans, false );
+		}
 		if ( ++totalTrans % IALL == 0 )
 			out << "\n\t";
 
@@ -113,6 +120,16 @@ std::ostream &RubyFlatCodeGen::KEYS()
 	return out;
 }
 
+std::ostream &RubyFlatCodeGen::CHAR_CLASS()
+{
+	START_ARRAY_LINE();
+	unsigned long long span = keyOps->span( redFsm->classLowKey, redFsm->classHighKey );
+	for ( unsigned long long pos = 0; pos < span; pos++ )
+		ARRAY_ITEM( INT( redFsm->charClass[pos] ), pos+1, pos == span-1 );
+	END_ARRAY_LINE();
+	return out;
+}
+
 std::ostream &RubyFlatCodeGen::INDICIES()
 {
 	int totalTrans = 0;
@@ -275,15 +292,31 @@ std::ostream &RubyFlatCodeGen::TRANS_ACTIONS()
 
 void RubyFlatCodeGen::LOCATE_TRANS()
 {
+	/* With a class map the transition is found by class. */
+	string key = GET_WIDE_KEY();
+	if ( redFsm->anyCharClasses() ) {
+		out << "	_cls = ";
+		if ( redFsm->classLowKey != keyOps->minKey || redFsm->classHighKey != keyOps->maxKey ) {
+			out << "if " << GET_KEY() << " < " << KEY( redFsm->classLowKey ) << " || " <<
+					GET_KEY() << " > " << KEY( redFsm->classHighKey ) << " then " <<
+					redFsm->numClasses << " else " << CC() << "[" << GET_KEY() << " - " <<
+					KEY( redFsm->classLowKey ) << "] end\n";
+		}
+		else {
+			out << CC() << "[" << GET_KEY() << " - " << KEY( redFsm->classLowKey ) << "]\n";
+		}
+		key = "_cls";
+	}
+
 	out <<
 		"	_keys = " << vCS() << " << 1\n"
 		"	_inds = " << IO() << "[" << vCS() << "]\n"
 		"	_slen = " << SP() << "[" << vCS() << "]\n"
 		"	_trans = if (   _slen > 0 && \n"
-		"			" << K() << "[_keys] <= " << GET_WIDE_KEY() << " && \n"
-		"			" << GET_WIDE_KEY() << " <= " << K() << "[_keys + 1] \n"
+		"			" << K() << "[_keys] <= " << key << " && \n"
+		"			" << key << " <= " << K() << "[_keys + 1] \n"
 		"		    ) then\n"
-		"			" << I() << "[ _inds + " << GET_WIDE_KEY() << " - " << K() << "[_keys] ] \n"
+		"			" << I() << "[ _inds + " << key << " - " << K() << "[_keys] ] \n"
 		"		 else \n"
 		"			" << I() << "[ _inds + _slen ]\n"
 		"		 end\n"
@@ -593,6 +626,13 @@ void RubyFlatCodeGen::writeData()
 		"\n";
 	}
 
+	if ( redFsm->anyCharClasses() ) {
+		OPEN_ARRAY( ARRAY_TYPE(redFsm->numClasses), CC() );
+		CHAR_CLASS();
+		CLOSE_ARRAY() <<
+		"\n";
+	}
+
 	OPEN_ARRAY( WIDE_ALPH_TYPE(), K() );
 	KEYS();
 	CLOSE_ARRAY() <<
@@ -666,6 +706,8 @@ void RubyFlatCodeGen::writeExec()
 		out << ", _ps";
 	if ( redFsm->anyConditions() )
 		out << ", _cond, _conds, _widec";
+	if ( redFsm->anyCharClasses() )
+		out << ", _cls";
 	if ( redFsm->anyToStateActions() || redFsm->anyRegActions() 
 			|| redFsm->anyFromStateActions() )
 		out << ", _acts, _nacts";
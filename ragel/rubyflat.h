@@ -47,6 +47,7 @@ protected:
 	std::ostream &ACTION_SWITCH();
 
 	std::ostream &KEYS();
+	std::ostream &CHAR_CLASS();
 	std::ostream &INDICIES();
 	std::ostream &FLAT_INDEX_OFFSET();
 	std::ostream &KEY_SPANS();
@@ -82,6 +82,26 @@ void GenBase::reduceActionTables()
 	}
 }
 
+/* Number the condition spaces that states use. Spaces left behind by
+ * construction get no id, their conditions may no longer be referenced. */
+long GenBase::numberCondSpaces()
+{
+	for ( CondSpaceMap::Iter cs = condData->condSpaceMap; cs.lte(); cs++ )
+		cs->condSpaceId = -1;
+
+	for ( StateList::Iter st = fsm->stateList; st.lte(); st++ ) {
+		for ( StateCondList::Iter sc = st->stateCondList; sc.lte(); sc++ )
+			sc->condSpace->condSpaceId = 0;
+	}
+
+	long nextCondSpaceId = 0;
+	for ( CondSpaceMap::Iter cs = condData->condSpaceMap; cs.lte(); cs++ ) {
+		if ( cs->condSpaceId >= 0 )
+			cs->condSpaceId = nextCondSpaceId++;
+	}
+	return nextCondSpaceId;
+}
+
 XMLCodeGen::XMLCodeGen( char *fsmName, ParseData *pd, FsmAp *fsm, std::ostream &out )
 :
 	GenBase(fsmName, pd, fsm),
@@ -444,6 +464,9 @@ void XMLCodeGen::writeInlineList( InlineList *inlineList )
 		case InlineItem::LmSetTokStart:
 			out << "<set_tokstart></set_tokstart>";
 			break;
+		case InlineItem::Counter:
+			out << "<counter>" << item->counterId << "</counter>";
+			break;
 		}
 	}
 }
@@ -620,6 +643,13 @@ void BackendGen::makeSetAct( GenInlineList *outList, long lmId )
 	outList->append( inlineItem );
 }
 
+void BackendGen::makeCounter( GenInlineList *outList, int counterId )
+{
+	GenInlineItem *inlineItem = new GenInlineItem( InputLoc(), GenInlineItem::Counter );
+	inlineItem->counterId = counterId;
+	outList->append( inlineItem );
+}
+
 void BackendGen::makeGenInlineList( GenInlineList *outList, InlineList *inList )
 {
 	for ( InlineList::Iter item = *inList; item.lte(); item++ ) {
@@ -704,6 +734,9 @@ void BackendGen::makeGenInlineList( GenInlineList *outList, InlineList *inList )
 			outList->append( new GenInlineItem( InputLoc(), GenInlineItem::LmSetTokStart ) );
 			cgd->hasLongestMatch = true;
 			break;
+		case InlineItem::Counter:
+			makeCounter( outList, item->counterId );
+			break;
 		}
 	}
 }
@@ -877,13 +910,12 @@ void XMLCodeGen::writeMachine()
 
 void XMLCodeGen::writeConditions()
 {
-	if ( condData->condSpaceMap.length() > 0 ) {
-		long nextCondSpaceId = 0;
-		for ( CondSpaceMap::Iter cs = condData->condSpaceMap; cs.lte(); cs++ )
-			cs->condSpaceId = nextCondSpaceId++;
-
-		out << "    <cond_space_list length=\"" << condData->condSpaceMap.length() << "\">\n";
+	long numCondSpaces = numberCondSpaces();
+	if ( numCondSpaces > 0 ) {
+		out << "    <cond_space_list length=\"" << numCondSpaces << "\">\n";
 		for ( CondSpaceMap::Iter cs = condData->condSpaceMap; cs.lte(); cs++ ) {
+			if ( cs->condSpaceId < 0 )
+				continue;
 			out << "      <cond_space id=\"" << cs->condSpaceId << 
 				"\" length=\"" << cs->condSet.length() << "\">";
 			writeKey( cs->baseKey );
@@ -1007,6 +1039,15 @@ void XMLCodeGen::writeXML()
 		writeInlineList( pd->dataExpr );
 		out << "</data_expr>\n";
 	}
+
+	if ( pd->countersExpr != 0 ) {
+		out << "  <counters_expr>";
+		writeInlineList( pd->countersExpr );
+		out << "</counters_expr>\n";
+	}
+
+	if ( pd->nextCounterId > 0 )
+		out << "  <num_counters>" << pd->nextCounterId << "</num_counters>\n";
 	
 	writeExports();
 	
@@ -1086,16 +1127,14 @@ void BackendGen::makeActionTableList()
 
 void BackendGen::makeConditions()
 {
-	if ( condData->condSpaceMap.length() > 0 ) {
-		long nextCondSpaceId = 0;
-		for ( CondSpaceMap::Iter cs = condData->condSpaceMap; cs.lte(); cs++ )
-			cs->condSpaceId = nextCondSpaceId++;
-
-		long listLength = condData->condSpaceMap.length();
+	long listLength = numberCondSpaces();
+	if ( listLength > 0 ) {
 		cgd->initCondSpaceList( listLength );
 		curCondSpace = 0;
 
 		for ( CondSpaceMap::Iter cs = condData->condSpaceMap; cs.lte(); cs++ ) {
+			if ( cs->condSpaceId < 0 )
+				continue;
 			long id = cs->condSpaceId;
 			cgd->newCondSpace( curCondSpace, id, cs->baseKey );
 			for ( CondSet::Iter csi = cs->condSet; csi.lte(); csi++ )
@@ -1390,10 +1429,21 @@ void BackendGen::makeBackend()
 		cgd->dataExpr = new GenInlineList;
 		makeGenInlineList( cgd->dataExpr, pd->dataExpr );
 	}
+
+	if ( pd->countersExpr != 0 ) {
+		cgd->countersExpr = new GenInlineList;
+		makeGenInlineList( cgd->countersExpr, pd->countersExpr );
+	}
+
+	cgd->numCounters = pd->nextCounterId;
 	
 	makeExports();
 	makeMachine();
 
+	/* The cache takes the machine before the code generator works on it. */
+	if ( pd->cacheFile.length() > 0 )
+		saveGenCache( pd->cacheFile.c_str(), cgd, pd->cacheDiags );
+
 	close_ragel_def();
 }
 
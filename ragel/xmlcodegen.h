@@ -85,6 +85,7 @@ struct GenBase
 
 	void appendTrans( TransListVect &outList, Key lowKey, Key highKey, TransAp *trans );
 	void reduceActionTables();
+	long numberCondSpaces();
 
 	char *fsmName;
 	ParseData *pd;
@@ -155,6 +156,7 @@ private:
 	void makeLmSwitch( GenInlineList *outList, InlineItem *item );
 	void makeSetTokend( GenInlineList *outList, long offset );
 	void makeSetAct( GenInlineList *outList, long lmId );
+	void makeCounter( GenInlineList *outList, int counterId );
 	void makeSubList( GenInlineList *outList, InlineList *inlineList, 
 			GenInlineItem::Type type );
 	void makeTargetItem( GenInlineList *outList, NameInst *nameTarg, GenInlineItem::Type type );
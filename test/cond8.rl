@@ -0,0 +1,51 @@
+/* 
+ * @LANG: c
+ * @ALLOW_MINFLAGS: -m -l -e -y
+ * @RAGEL_FLAGS: --drop-conds
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+%%{
+	machine foo;
+
+	action c1 {(printf( "c1 " ), 1)}
+	action c2 {(printf( "c2 " ), 1)}
+	action hit {printf( "hit " );}
+
+	# Both senses of c1 go the same way, so it is never tested. The c2 test
+	# decides whether hit is executed.
+	main := (
+		10 .. 60 when c1 |
+		0 .. 70 |
+		30 .. 40 when c2 @hit
+	)* ${printf( "char: %i\n", (int)*p );};
+}%%
+
+%% write data noerror nofinal;
+
+void test( char *str )
+{
+	int len = strlen( str );
+	int cs = foo_start;
+	char *p = str, *pe = str+len;
+	%% write exec;
+}
+
+char data[] = { 5, 15, 25, 35, 45, 65, 0 };
+
+int main()
+{
+	test( data );
+	return 0;
+}
+
+#ifdef _____OUTPUT_____
+char: 5
+char: 15
+char: 25
+c2 hit char: 35
+char: 45
+char: 65
+#endif
@@ -0,0 +1,112 @@
+/*
+ * @LANG: c
+ * @EXPECT_WARNING: lower bound of counted repetition is not checked
+ */
+
+/**
+ * Test counted repetition. The counters are kept in an array of the caller's
+ * struct. The last alternative ends the machine inside a repetition, so its
+ * lower bound is not checked and ragel warns about it.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+struct count
+{
+	int cs;
+	int cnt[8];
+};
+
+%%{
+	machine count;
+	access fsm->;
+	variable counters fsm->cnt;
+
+	main := (
+		'a' [0-9]{count 3} |
+		'b' [0-9]{count 2,} |
+		'c' [0-9]{count ,3} |
+		'd' [0-9]{count 2,3} |
+		'e' ( [0-9]{count 1,2} '.' ){count 2,3}
+	) '\n' |
+	'f' [0-9]{count 2,};
+}%%
+
+%% write data noerror;
+
+void test( const char *str )
+{
+	struct count s, *fsm = &s;
+	const char *p = str;
+	const char *pe = str + strlen( str );
+
+	memset( fsm->cnt, 0, sizeof(fsm->cnt) );
+	%% write init;
+	%% write exec;
+
+	if ( fsm->cs >= count_first_final )
+		printf( "ACCEPT\n" );
+	else
+		printf( "FAIL\n" );
+}
+
+int main()
+{
+	printf( "%d counters\n", count_num_counters );
+
+	test( "a12\n" );
+	test( "a123\n" );
+	test( "a1234\n" );
+
+	test( "b1\n" );
+	test( "b12\n" );
+	test( "b1234567\n" );
+
+	test( "c\n" );
+	test( "c123\n" );
+	test( "c1234\n" );
+
+	test( "d1\n" );
+	test( "d12\n" );
+	test( "d123\n" );
+	test( "d1234\n" );
+
+	test( "e1.\n" );
+	test( "e1.23.\n" );
+	test( "e1.23.4.\n" );
+	test( "e1.23.4.5.\n" );
+	test( "e123.4.\n" );
+	test( "e.1.\n" );
+
+	test( "f12" );
+	test( "f12345" );
+	test( "f" );
+	return 0;
+}
+
+#ifdef _____OUTPUT_____
+7 counters
+FAIL
+ACCEPT
+FAIL
+FAIL
+ACCEPT
+ACCEPT
+ACCEPT
+ACCEPT
+FAIL
+FAIL
+ACCEPT
+ACCEPT
+FAIL
+FAIL
+ACCEPT
+ACCEPT
+FAIL
+FAIL
+FAIL
+ACCEPT
+ACCEPT
+FAIL
+#endif
@@ -0,0 +1,16 @@
+/*
+ * @LANG: c
+ * @EXPECT_ERROR: invalid range repetition
+ */
+
+/**
+ * A counted repetition with a lower bound above the upper bound is rejected.
+ */
+
+%%{
+	machine count;
+
+	main := [0-9]{count 3,2} '\n';
+}%%
+
+%% write data;
@@ -0,0 +1,70 @@
+/*
+ * @LANG: csharp
+ * @CFLAGS: -unsafe
+ * @ALLOW_GENFLAGS: -T0 -T1 -F0 -F1 -G0 -G1 -T0,--span-tables -F1,--span-tables -T1,--fixed-data -G1,--fixed-data -F0,--span-tables,--fixed-data
+ */
+
+/*
+ * Test C# machines over a byte alphabet, with tables written as spans and
+ * with the data pinned. Parentheses are matched by calling the inner machine
+ * and bytes above 0x7f are counted as two byte UTF-8 sequences.
+ */
+
+using System;
+
+class Test
+{
+	%%{
+		machine csharp1;
+		alphtype byte;
+
+		action char { chars += 1; }
+		action call { fcall inner; }
+		action ret { fret; }
+		action done { Console.WriteLine( "DONE" ); }
+
+		char = ( [a-z] | 0xc2..0xdf 0x80..0xbf ) @char;
+
+		inner := ( char | '(' @call )* ')' @ret;
+
+		main := ( char | '(' @call )* %/done;
+	}%%
+
+	%% write data;
+
+	static unsafe void test( byte[] data )
+	{
+		int cs, top;
+		int[] stack = new int[8];
+		int p = 0, pe = data.Length, eof = data.Length;
+		int chars = 0;
+
+		%% write init;
+		%% write exec;
+
+		if ( cs >= csharp1_first_final )
+			Console.WriteLine( "ACCEPT " + chars );
+		else
+			Console.WriteLine( "FAIL " + p );
+	}
+
+	static void Main()
+	{
+		test( new byte[] { 0x61, 0x28, 0x62, 0x28, 0x63, 0x29, 0x29, 0x64 } );
+		test( new byte[] { 0x63, 0x61, 0x66, 0xc3, 0xa9, 0x28, 0xc3, 0xa0, 0x29 } );
+		test( new byte[] { 0x61, 0x28, 0x62 } );
+		test( new byte[] { 0x61, 0xc3, 0x62 } );
+		test( new byte[] { } );
+	}
+}
+
+/* _____OUTPUT_____
+DONE
+ACCEPT 4
+DONE
+ACCEPT 5
+FAIL 3
+FAIL 2
+DONE
+ACCEPT 0
+*/
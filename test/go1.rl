@@ -0,0 +1,63 @@
+/*
+ * @LANG: go
+ */
+
+/*
+ * Test the Go code styles with calls into a nested machine and keys above
+ * 0x7f. Parentheses are matched by calling the inner machine. Each character
+ * is counted, with two byte UTF-8 sequences counted as one.
+ */
+
+package main
+
+import "fmt"
+
+%%{
+	machine gocall;
+
+	action char { chars += 1 }
+	action call { fcall inner; }
+	action ret { fret; }
+
+	char = ( [a-z] | 0xc2..0xdf 0x80..0xbf ) @char;
+
+	inner := ( char | '(' @call )* ')' @ret;
+
+	main := ( char | '(' @call )* '\n';
+}%%
+
+%% write data;
+
+func test(data []byte) {
+	var cs, top int
+	var stack [8]int
+	p, pe := 0, len(data)
+	chars := 0
+
+	%% write init;
+	%% write exec;
+
+	if cs >= gocall_first_final {
+		fmt.Println("ACCEPT", chars)
+	} else {
+		fmt.Println("FAIL", p)
+	}
+}
+
+func main() {
+	test([]byte("ab(cd(e)f)g\n"))
+	test([]byte("caf\xc3\xa9 (\xc3\xa0)\n"))
+	test([]byte("caf\xc3\xa9(\xc3\xa0)\n"))
+	test([]byte("a(b(c)\n"))
+	test([]byte("a\xc3b\n"))
+	test([]byte("((((x))))\n"))
+}
+
+/* _____OUTPUT_____
+ACCEPT 7
+FAIL 5
+ACCEPT 5
+FAIL 6
+FAIL 2
+ACCEPT 1
+*/
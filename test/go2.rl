@@ -0,0 +1,58 @@
+/*
+ * @LANG: go
+ * @ALLOW_GENFLAGS: -F0 -F1
+ * @RAGEL_FLAGS: --flat-pages
+ */
+
+/*
+ * Test the flat tables of Go cut into pages. The alphabet is 32 bits wide
+ * and the first state spans keys from 0x2e to 0x2fff.
+ */
+
+package main
+
+import "fmt"
+
+%%{
+	machine gopages;
+
+	alphtype int32;
+
+	action lo { lo += 1 }
+	action hi { hi += 1 }
+
+	main := ( [a-z] @lo | 0x400..0x4ff @hi | 0x2000..0x2fff @hi )* '.';
+}%%
+
+%% write data;
+
+func test(data []int32) {
+	var cs int
+	p, pe := 0, len(data)
+	lo, hi := 0, 0
+
+	%% write init;
+	%% write exec;
+
+	if cs >= gopages_first_final {
+		fmt.Println("ACCEPT", lo, hi)
+	} else {
+		fmt.Println("FAIL", p)
+	}
+}
+
+func main() {
+	test([]int32{'a', 'b', 0x410, 0x2abc, '.'})
+	test([]int32{'a', 0x500, '.'})
+	test([]int32{0x2fff, 0x2000, 0x4ff, '.'})
+	test([]int32{'z', 0x3000, '.'})
+	test([]int32{0x1fff, '.'})
+}
+
+/* _____OUTPUT_____
+ACCEPT 2 2
+FAIL 1
+ACCEPT 0 3
+FAIL 1
+FAIL 0
+*/
@@ -0,0 +1,60 @@
+/*
+ * @LANG: c
+ */
+
+/**
+ * Test a wide alphabet. States that span more than a few thousand characters
+ * put the flat styles into pages.
+ */
+
+#include <stdio.h>
+
+%%{
+	machine high;
+
+	alphtype unsigned int;
+
+	letter = 0x41..0x5a | 0x61..0x7a | 0xc0..0x24f | 0x4e00..0x9fff |
+			0x10000..0x1ffff;
+	number = 0x30..0x39 | 0x660..0x669;
+
+	main := |*
+		letter+ => { printf( "word %i\n", (int)(te-ts) ); };
+		number+ => { printf( "number %i\n", (int)(te-ts) ); };
+		0x20 | 0x3000;
+		any => { printf( "other 0x%x\n", *ts ); };
+	*|;
+}%%
+
+%% write data nofinal;
+
+unsigned int data[] = {
+	0x61, 0x4e2d, 0x6587, 0x10400, 0x20, 0x31, 0x661, 0x3000, 0xffffffff,
+	0x5, 0x7a, 0x9fff, 0xa000, 0x1ffff
+};
+
+int main()
+{
+	int cs, act;
+	unsigned int *ts, *te;
+	unsigned int *p = data;
+	unsigned int *pe = data + sizeof(data)/sizeof(data[0]);
+	unsigned int *eof = pe;
+
+	%% write init;
+	%% write exec;
+
+	if ( cs == high_error )
+		printf( "fail\n" );
+	return 0;
+}
+
+#ifdef _____OUTPUT_____
+word 4
+number 2
+other 0xffffffff
+other 0x5
+word 2
+other 0xa000
+word 1
+#endif
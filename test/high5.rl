@@ -0,0 +1,60 @@
+/*
+ * @LANG: c
+ */
+
+/**
+ * Test keys at both ends of a wide alphabet. The classes of the row
+ * displacement tables are found by searching intervals, as a class map would
+ * be as wide as the alphabet.
+ */
+
+#include <stdio.h>
+
+%%{
+	machine high;
+
+	alphtype unsigned int;
+
+	main := ( 0x61 | 0xfffffff0 ) 0x62 ( 0x80000000..0xfffffffe 0x63 )*;
+}%%
+
+%% write data noerror;
+
+void test( const unsigned int *data, int len )
+{
+	int cs;
+	const unsigned int *p = data;
+	const unsigned int *pe = data + len;
+
+	%% write init;
+	%% write exec;
+
+	if ( cs >= high_first_final )
+		printf( "ACCEPT\n" );
+	else
+		printf( "FAIL\n" );
+}
+
+const unsigned int d1[] = { 0x61, 0x62 };
+const unsigned int d2[] = { 0xfffffff0, 0x62, 0x80000000, 0x63, 0xfffffffe, 0x63 };
+const unsigned int d3[] = { 0xfffffff1, 0x62 };
+const unsigned int d4[] = { 0x61, 0x62, 0xffffffff, 0x63 };
+const unsigned int d5[] = { 0x61, 0x62, 0x7fffffff, 0x63 };
+
+int main()
+{
+	test( d1, 2 );
+	test( d2, 6 );
+	test( d3, 2 );
+	test( d4, 4 );
+	test( d5, 4 );
+	return 0;
+}
+
+#ifdef _____OUTPUT_____
+ACCEPT
+ACCEPT
+FAIL
+FAIL
+FAIL
+#endif
@@ -0,0 +1,63 @@
+/*
+ * @LANG: c
+ */
+
+/**
+ * Test a 64 bit alphabet. The span of the first state does not fit in a
+ * 64 bit count, and is too wide for the flat styles to page.
+ */
+
+#include <stdio.h>
+
+%%{
+	machine high;
+
+	alphtype long;
+
+	main := ( -9223372036854775792 | 0x7ffffffffffffff0 | 0x61 )
+			( -16..16 | 0x100000000..0x1000fffff )+ 0x2e;
+}%%
+
+%% write data noerror;
+
+void test( const long *data, int len )
+{
+	int cs;
+	const long *p = data;
+	const long *pe = data + len;
+
+	%% write init;
+	%% write exec;
+
+	if ( cs >= high_first_final )
+		printf( "ACCEPT\n" );
+	else
+		printf( "FAIL\n" );
+}
+
+const long d1[] = { 0x61, 0x0, 0x2e };
+const long d2[] = { -0x7ffffffffffffff0, -0x10, 0x100000000, 0x1000fffff, 0x2e };
+const long d3[] = { 0x7ffffffffffffff0, 0x10, 0x2e };
+const long d4[] = { 0x7ffffffffffffff1, 0x10, 0x2e };
+const long d5[] = { 0x61, 0x100100000, 0x2e };
+const long d6[] = { 0x61, -0x11, 0x2e };
+
+int main()
+{
+	test( d1, 3 );
+	test( d2, 5 );
+	test( d3, 3 );
+	test( d4, 3 );
+	test( d5, 3 );
+	test( d6, 3 );
+	return 0;
+}
+
+#ifdef _____OUTPUT_____
+ACCEPT
+ACCEPT
+ACCEPT
+FAIL
+FAIL
+FAIL
+#endif
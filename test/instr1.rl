@@ -0,0 +1,77 @@
+/*
+ * @LANG: c
+ * @ALLOW_GENFLAGS: -T0 -T1 -T2 -F0 -F1 -G0 -G1 -G2
+ * @ALLOW_MINFLAGS: -m -l -e -y
+ * @RAGEL_FLAGS: --instrument
+ */
+
+/**
+ * Test the counters of --instrument. The machine is run over a few lines and
+ * the counts are written out by the generated dump routine. The ids of states
+ * and transitions are the same in every code style, but not without
+ * minimization.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+%%{
+	machine instr;
+
+	action word { words += 1; }
+	action number { numbers += 1; }
+
+	token = [a-z]+ %word | [0-9]+ %number;
+	main := token ( ' ' token )* '\n';
+}%%
+
+%% write data;
+
+int words, numbers;
+
+void test( const char *str )
+{
+	int cs;
+	const char *p = str;
+	const char *pe = str + strlen( str );
+
+	%% write init;
+	%% write exec;
+
+	if ( cs >= instr_first_final )
+		printf( "ACCEPT\n" );
+	else
+		printf( "FAIL\n" );
+}
+
+int main()
+{
+	test( "ab 12 c\n" );
+	test( "1 2 3\n" );
+	test( "x!\n" );
+	printf( "%d words %d numbers\n", words, numbers );
+	instr_dump_profile( stdout );
+	return 0;
+}
+
+#ifdef _____OUTPUT_____
+ACCEPT
+ACCEPT
+FAIL
+2 words 4 numbers
+machine instr
+state 0 0
+state 1 7
+state 2 5
+state 3 4
+state 4 0
+trans 0 2 5
+trans 1 0 1
+trans 2 3 4
+trans 3 4 1
+trans 4 1 3
+trans 5 4 1
+trans 6 1 1
+action 0 2
+action 1 4
+#endif
@@ -0,0 +1,75 @@
+/*
+ * @LANG: d
+ * @ALLOW_GENFLAGS: -G1 -G2
+ * @ALLOW_MINFLAGS: -m -l -e -y
+ * @RAGEL_FLAGS: --instrument
+ */
+
+/**
+ * The counters of --instrument in D. The machine and the counts are those of
+ * instr1.rl. Only the goto styles are run, because the table styles point
+ * into the const tables with pointers that D2 does not allow.
+ */
+
+import core.stdc.stdio;
+
+%%{
+	machine instr;
+
+	action word { words += 1; }
+	action number { numbers += 1; }
+
+	token = [a-z]+ %word | [0-9]+ %number;
+	main := token ( ' ' token )* '\n';
+}%%
+
+%% write data;
+
+int words, numbers;
+
+void test( string str )
+{
+	int cs;
+	const(char) *p = str.ptr;
+	const(char) *pe = str.ptr + str.length;
+
+	%% write init;
+	%% write exec;
+
+	if ( cs >= instr_first_final )
+		printf( "ACCEPT\n" );
+	else
+		printf( "FAIL\n" );
+}
+
+int main()
+{
+	test( "ab 12 c\n" );
+	test( "1 2 3\n" );
+	test( "x!\n" );
+	printf( "%d words %d numbers\n", words, numbers );
+	instr_dump_profile( stdout );
+	return 0;
+}
+
+/+ _____OUTPUT_____
+ACCEPT
+ACCEPT
+FAIL
+2 words 4 numbers
+machine instr
+state 0 0
+state 1 7
+state 2 5
+state 3 4
+state 4 0
+trans 0 2 5
+trans 1 0 1
+trans 2 3 4
+trans 3 4 1
+trans 4 1 3
+trans 5 4 1
+trans 6 1 1
+action 0 2
+action 1 4
+++++++++++++++++++/
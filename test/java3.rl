@@ -0,0 +1,93 @@
+/*
+ * @LANG: java
+ */
+
+import java.nio.ByteBuffer;
+
+class java3
+{
+	%%{
+		machine java3;
+		alphtype byte;
+
+		action w { System.out.print( "w" ); }
+		action n { System.out.print( "n" ); }
+		action h { System.out.print( "h" ); }
+
+		word = [a-zA-Z_] [a-zA-Z_0-9]*;
+		num = [0-9]+;
+		item = word @w | num @n | -128..-1 @h | [ \t];
+
+		main := ( item* '\n' @{ System.out.print( "|" ); } )*;
+	}%%
+
+	%% write data;
+	%% machine java3_buf; include java3; write data;
+
+	static void test( byte data[] )
+	{
+		int cs, p = 0, pe = data.length;
+
+		%% machine java3;
+		%% write init;
+		%% write exec;
+
+		if ( cs >= java3_first_final )
+			System.out.println( " ACCEPT" );
+		else
+			System.out.println( " FAIL" );
+	}
+
+	/* The same machine read through a buffer. */
+	static void testBuf( ByteBuffer buf )
+	{
+		int cs, p = buf.position(), pe = buf.limit();
+
+		%%{
+			machine java3_buf;
+			variable data buf;
+			getkey buf.get( p );
+			write init;
+			write exec;
+		}%%
+
+		if ( cs >= java3_buf_first_final )
+			System.out.println( " ACCEPT" );
+		else
+			System.out.println( " FAIL" );
+	}
+
+	static final byte t1[] = { 97, 98, 32, 99, 57, 32, 49, 50, 10, -61, -87, 10 };
+	static final byte t2[] = { 97, 98, 10, 35, 10 };
+
+	/* Copy into a direct buffer, which has no backing array. */
+	static ByteBuffer direct( byte data[] )
+	{
+		ByteBuffer buf = ByteBuffer.allocateDirect( data.length + 2 );
+		buf.put( (byte)35 ).put( (byte)35 ).put( data );
+		buf.flip();
+		buf.position( 2 );
+		return buf;
+	}
+
+	public static void main( String args[] )
+	{
+		test( t1 );
+		test( t2 );
+
+		testBuf( ByteBuffer.wrap( t1 ) );
+		testBuf( ByteBuffer.wrap( t2 ) );
+
+		testBuf( direct( t1 ) );
+		testBuf( direct( t2 ) );
+	}
+}
+
+/* _____OUTPUT_____
+wwwwnnn|hh| ACCEPT
+ww| FAIL
+wwwwnnn|hh| ACCEPT
+ww| FAIL
+wwwwnnn|hh| ACCEPT
+ww| FAIL
+*/
@@ -0,0 +1,63 @@
+/*
+ * @LANG: c
+ */
+
+/**
+ * Keywords made of chains of single character states. The goto styles match
+ * these several bytes at a time when enough input is left.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+%%{
+	machine literal;
+
+	action method { printf( "method %i\n", (int)(p - data) ); }
+	action header { printf( "header %i\n", (int)(p - data) ); }
+
+	method = ( "GET" | "POST" | "OPTIONS" | "CONNECT" ) %method;
+	header = ( "Content-Length" | "Content-Type" | "Transfer-Encoding" ) %header;
+
+	main := method ' HTTP/1.1\r\n' ( header ': x\r\n' )* '\r\n';
+}%%
+
+%% write data;
+
+void test( const char *data )
+{
+	int cs;
+	const char *p = data, *pe = data + strlen( data );
+
+	%% write init;
+	%% write exec;
+
+	if ( cs >= literal_first_final )
+		printf( "ACCEPT\n" );
+	else
+		printf( "FAIL %i\n", (int)(p - data) );
+}
+
+int main()
+{
+	test( "OPTIONS HTTP/1.1\r\nTransfer-Encoding: x\r\nContent-Type: x\r\n"
+		"Content-Length: x\r\n\r\n" );
+	test( "CONNECT HTTP/1.1\r\nTransfer-Encodinf: x\r\n\r\n" );
+	test( "POST HTTP/1.1\r\nContent-Typ" );
+	test( "GET HTTP/1.0\r\n\r\n" );
+	return 0;
+}
+
+#ifdef _____OUTPUT_____
+method 7
+header 35
+header 52
+header 71
+ACCEPT
+method 7
+FAIL 34
+method 4
+FAIL 26
+method 3
+FAIL 11
+#endif
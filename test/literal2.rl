@@ -0,0 +1,78 @@
+/*
+ * @LANG: c
+ */
+
+/**
+ * Chains of single character states that lead into cycles. The first machine
+ * ends in a state that links to itself, the second in a cycle of three states
+ * after a prefix longer than one compare.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+%%{
+	machine self;
+	main := 'x' 'a'*;
+}%%
+
+%% write data;
+
+void test_self( const char *data )
+{
+	int cs;
+	const char *p = data, *pe = data + strlen( data );
+
+	%% write init;
+	%% write exec;
+
+	if ( cs >= self_first_final )
+		printf( "ACCEPT\n" );
+	else
+		printf( "FAIL %i\n", (int)(p - data) );
+}
+
+%%{
+	machine cycle;
+	main := 'header: ' ( 'abc' )*;
+}%%
+
+%% write data;
+
+void test_cycle( const char *data )
+{
+	int cs;
+	const char *p = data, *pe = data + strlen( data );
+
+	%% write init;
+	%% write exec;
+
+	if ( cs >= cycle_first_final )
+		printf( "ACCEPT\n" );
+	else
+		printf( "FAIL %i\n", (int)(p - data) );
+}
+
+int main()
+{
+	test_self( "x" );
+	test_self( "xaaaaaaaaaaaa" );
+	test_self( "xaab" );
+	test_cycle( "header: " );
+	test_cycle( "header: abcabcabcabc" );
+	test_cycle( "header: abcab" );
+	test_cycle( "header: abcabd" );
+	test_cycle( "heade: abc" );
+	return 0;
+}
+
+#ifdef _____OUTPUT_____
+ACCEPT
+ACCEPT
+FAIL 3
+ACCEPT
+ACCEPT
+FAIL 13
+FAIL 13
+FAIL 5
+#endif
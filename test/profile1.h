@@ -0,0 +1,13 @@
+#ifndef _PROFILE1_H
+#define _PROFILE1_H
+
+struct profile
+{
+	int cs;
+	int idents;
+	int numbers;
+	int keywords;
+	int strings;
+};
+
+#endif
@@ -0,0 +1,76 @@
+/*
+ * @LANG: c
+ * @ALLOW_GENFLAGS: -T0 -F1 -G0 -G1 -G2 -P
+ * @ALLOW_MINFLAGS: -m -l -e -y
+ * @RAGEL_FLAGS: --profile-use=profile1.prof
+ */
+
+/**
+ * Test laying out machines by a profile: the partitions of -P and the order of
+ * states, tests and defaults in the goto styles. The table styles only check
+ * that the profile fits. The profile was written by an instrumented build of
+ * this machine reading the input below. Identifiers and numbers are hot, while
+ * the keywords and strings are hardly used.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "profile1.h"
+
+%%{
+	machine profile;
+	access fsm->;
+
+	action ident { fsm->idents += 1; }
+	action number { fsm->numbers += 1; }
+	action keyword { fsm->keywords += 1; }
+	action string { fsm->strings += 1; }
+
+	ident = [a-z] [a-z0-9]*;
+	keyword = 'while' | 'return' | 'struct' | 'switch';
+
+	token = 
+		( ident - keyword ) %ident |
+		keyword %keyword |
+		[0-9]+ %number |
+		'"' [^"\n]* '"' %string;
+
+	main := ( token ( ' ' | '\n' )+ )*;
+}%%
+
+%% write data;
+
+void test( const char *str )
+{
+	struct profile s, *fsm = &s;
+	char *p = (char*)str;
+	char *pe = p + strlen( str );
+
+	fsm->idents = fsm->numbers = fsm->keywords = fsm->strings = 0;
+	%% write init;
+	%% write exec;
+
+	if ( fsm->cs >= profile_first_final ) {
+		printf( "ACCEPT %d %d %d %d\n", fsm->idents, fsm->numbers,
+				fsm->keywords, fsm->strings );
+	}
+	else {
+		printf( "FAIL\n" );
+	}
+}
+
+int main()
+{
+	test(
+		"a1 b2 c3 x y z 12 34 56 foo bar baz 7 8 9\n"
+		"sum total count 100 200 300 index value 42 42 42\n"
+		"while i j k 1 2 3 return \"done\"\n"
+	);
+	test( "switch \"open\n" );
+	return 0;
+}
+
+#ifdef _____OUTPUT_____
+ACCEPT 17 15 2 1
+FAIL
+#endif
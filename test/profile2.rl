@@ -0,0 +1,18 @@
+/*
+ * @LANG: c
+ * @ALLOW_GENFLAGS: -P
+ * @RAGEL_FLAGS: --profile-use=profile2.prof
+ * @EXPECT_ERROR: does not fit machine profile
+ */
+
+/**
+ * A profile naming a state the machine does not have is rejected.
+ */
+
+%%{
+	machine profile;
+
+	main := ( 'if' | 'for' | 'while' ) ';';
+}%%
+
+%% write data;
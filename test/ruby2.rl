@@ -0,0 +1,61 @@
+#
+# @LANG: ruby
+#
+# Packed tables must give the same results as plain ones. The input is read
+# as signed bytes so keys below zero are exercised.
+#
+
+%%{
+	machine ruby2;
+
+	action word { puts "WORD" }
+	action high { puts "HIGH" }
+	action num { puts "NUM" }
+
+	word = ( 'alpha' | 'beta' | 'gamma' | 'delta' | 'epsilon' ) %word;
+	high = ( -128 .. -65 )+ %high;
+	num = ( digit{1,3} | '0x' xdigit+ ) %num;
+
+	main := ( ( word | high | num ) ' ' )* '\n';
+}%%
+
+%% write data;
+
+def run_machine( str )
+	data = str.unpack( "c*" )
+	p = 0
+	pe = data.length
+	cs = 0
+
+	%% write init;
+	%% write exec;
+	if  cs >= ruby2_first_final
+		puts "ACCEPT"
+	else
+		puts "FAIL"
+	end
+end
+
+inp = [
+	"alpha 12 0xff \n",
+	"gamma \x80\xa0\xbf epsilon \n",
+	"delta 1234 \n",
+	"beta \xc0 \n",
+]
+
+inp.each { |str| run_machine( str ) }
+
+=begin _____OUTPUT_____
+WORD
+NUM
+NUM
+ACCEPT
+WORD
+HIGH
+WORD
+ACCEPT
+WORD
+FAIL
+WORD
+FAIL
+=end _____OUTPUT_____
@@ -0,0 +1,69 @@
+/*
+ * @LANG: c
+ */
+
+/**
+ * Runs of strings, comments and whitespace, long enough to go through the
+ * vector skip loops of the goto styles.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+%%{
+	machine skip;
+
+	action tok { printf( "%s %i\n", tok, (int)(p - ts) ); }
+
+	string = ( '"' ( [^"\\] | '\\' any )* '"' ) >{ tok = "string"; ts = p; };
+	comment = ( '#' [^\n]* '\n' ) >{ tok = "comment"; ts = p; };
+	high = ( 0x80..0xff )+ >{ tok = "high"; ts = p; };
+	ident = [a-z_]+ >{ tok = "ident"; ts = p; };
+
+	main := ( ( string | high | ident ) %tok [ \t\n]+ | comment %tok )*;
+}%%
+
+%% write data;
+
+void test( const char *data )
+{
+	int cs;
+	const char *p = data, *pe = data + strlen( data ), *eof = pe;
+	const char *ts = 0, *tok = 0;
+
+	%% write init;
+	%% write exec;
+
+	if ( cs >= skip_first_final )
+		printf( "ACCEPT\n" );
+	else
+		printf( "FAIL\n" );
+}
+
+int main()
+{
+	test( "\"a short string\" "
+		"\"a string long enough to need more than one vector, with \\\" an "
+		"escaped quote in the middle of it and another \\\\ at the end\\\\\"\n"
+		"# a comment that runs on and on past thirty two bytes of text\n"
+		"identifier_that_is_longer_than_sixteen_bytes"
+		"                                        "
+		"\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9"
+		"\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9"
+		"\xc3\xa9\xc3\xa9\xc3\xa9 x\n" );
+	test( "\"an unterminated string that ends inside the loop" );
+	test( "# a comment cut off before its newline" );
+	return 0;
+}
+
+#ifdef _____OUTPUT_____
+string 16
+string 125
+comment 62
+ident 44
+high 38
+ident 1
+ACCEPT
+FAIL
+FAIL
+#endif
@@ -0,0 +1,66 @@
+/*
+ * @LANG: c
+ * @ALLOW_GENFLAGS: -T0 -T1 -F0 -F1 -G0 -G1 -G2 -P
+ */
+
+/**
+ * Test error transitions taken from states in every partition of -P. The
+ * machine must stop on the character that fails, whatever the partition of
+ * the failing state.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "split1.h"
+
+%%{
+	machine split;
+	access fsm->;
+
+	main := ( 'if' | 'int' | 'for' | 'while' | 'return' ) ';' '\n';
+}%%
+
+%% write data;
+
+void test( const char *str )
+{
+	struct split s, *fsm = &s;
+	char *p = (char*)str;
+	char *pe = p + strlen( str );
+
+	%% write init;
+	%% write exec;
+
+	if ( fsm->cs == split_error )
+		printf( "ERROR at %d\n", (int)(p - str) );
+	else if ( fsm->cs >= split_first_final )
+		printf( "ACCEPT\n" );
+	else
+		printf( "FAIL\n" );
+}
+
+int main()
+{
+	test( "int;\n" );
+	test( "while;\n" );
+	test( "inx;\n" );
+	test( "whale;\n" );
+	test( "retur;\n" );
+	test( "for\n" );
+	test( "if;;" );
+	test( "x" );
+	test( "retu" );
+	return 0;
+}
+
+#ifdef _____OUTPUT_____
+ACCEPT
+ACCEPT
+ERROR at 2
+ERROR at 2
+ERROR at 5
+ERROR at 3
+ERROR at 3
+ERROR at 0
+FAIL
+#endif
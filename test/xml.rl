@@ -3,7 +3,7 @@
  * http://www.jelks.nu/XML/xmlebnf.html
  *
  * @LANG: c++
- * @ALLOW_MINFLAGS: -l -e
+ * @ALLOW_MINFLAGS: -l -e -y
  * @ALLOW_GENFLAGS: -T0 -T1
  */
 